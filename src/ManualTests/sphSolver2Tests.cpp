@@ -9,58 +9,116 @@
 #include <Geometry/PointGenerator/volume_particle_emitter2.h>
 #include <Geometry/ImplicitSurface/implicit_surface2_set.h>
 
+#include <algorithm>
+#include <cmath>
+
 
 using namespace jet;
 
 JET_TESTS(SPHSolver2)
 
+namespace
+{
+    // Sets up the water drop scene: a pool and a drop in a 1 x 2 box.
+    void SetUpWaterDrop(SPHSolver2* solver, double targetSpacing)
+    {
+        BoundingBox2D domain(Vector2D(), Vector2D(1, 2));
+
+        solver->SetPseudoViscosityCoefficient(0.0);
+
+        SPHSystemData2Ptr particles = solver->SPHSystemData();
+        particles->SetTargetDensity(1000.0);
+        particles->SetTargetSpacing(targetSpacing);
+
+        // Initialize source
+        ImplicitSurfaceSet2Ptr surfaceSet = std::make_shared<ImplicitSurfaceSet2>();
+        surfaceSet->AddExplicitSurface(
+            std::make_shared<Plane2>(
+                Vector2D(0, 1), Vector2D(0, 0.25 * domain.Height())));
+        surfaceSet->AddExplicitSurface(
+            std::make_shared<Sphere2>(
+                domain.MidPoint(), 0.15 * domain.Width()));
+
+        BoundingBox2D sourceBound(domain);
+        sourceBound.Expand(-targetSpacing);
+
+        auto emitter = std::make_shared<VolumeParticleEmitter2>(
+            surfaceSet,
+            sourceBound,
+            targetSpacing,
+            Vector2D());
+        solver->SetEmitter(emitter);
+
+        // Initialize boundary
+        Box2Ptr box = std::make_shared<Box2>(domain);
+        box->IsNormalFlipped = true;
+        RigidBodyCollider2Ptr collider = std::make_shared<RigidBodyCollider2>(box);
+
+        // Setup solver
+        solver->SetCollider(collider);
+    }
+}
+
 JET_BEGIN_TEST_F(SPHSolver2, WaterDrop) {
-    const double targetSpacing = 0.02;
+    SPHSolver2 solver;
+    SetUpWaterDrop(&solver, 0.02);
+
+    SPHSystemData2Ptr particles = solver.SPHSystemData();
+    SaveParticleDataXy(particles, 0);
+
+    Frame frame(1, 1.0 / 60.0);
+    for ( ; frame.Index < 120; frame.Advance()) {
+        solver.Update(frame);
 
-    BoundingBox2D domain(Vector2D(), Vector2D(1, 2));
+        SaveParticleDataXy(particles, frame.Index);
+    }
+}
+JET_END_TEST_F
 
-    // Initialize solvers
+JET_BEGIN_TEST_F(SPHSolver2, WaterDropSinglePrecisionDensities) {
     SPHSolver2 solver;
-    solver.SetPseudoViscosityCoefficient(0.0);
+    SetUpWaterDrop(&solver, 0.02);
 
     SPHSystemData2Ptr particles = solver.SPHSystemData();
-    particles->SetTargetDensity(1000.0);
-    particles->SetTargetSpacing(targetSpacing);
-
-    // Initialize source
-    ImplicitSurfaceSet2Ptr surfaceSet = std::make_shared<ImplicitSurfaceSet2>();
-    surfaceSet->AddExplicitSurface(
-        std::make_shared<Plane2>(
-            Vector2D(0, 1), Vector2D(0, 0.25 * domain.Height())));
-    surfaceSet->AddExplicitSurface(
-        std::make_shared<Sphere2>(
-            domain.MidPoint(), 0.15 * domain.Width()));
-
-    BoundingBox2D sourceBound(domain);
-    sourceBound.Expand(-targetSpacing);
-
-    auto emitter = std::make_shared<VolumeParticleEmitter2>(
-        surfaceSet,
-        sourceBound,
-        targetSpacing,
-        Vector2D());
-    solver.SetEmitter(emitter);
-
-    // Initialize boundary
-    Box2Ptr box = std::make_shared<Box2>(domain);
-    box->IsNormalFlipped = true;
-    RigidBodyCollider2Ptr collider = std::make_shared<RigidBodyCollider2>(box);
-
-    // Setup solver
-    solver.SetCollider(collider);
 
-    SaveParticleDataXy(particles, 0);
+    // At each frame of the double precision simulation, the densities are
+    // computed again from the positions rounded to float, and the maximum
+    // relative difference to the double precision densities is saved.
+    Array1<double> frames;
+    Array1<double> maxRelativeErrors;
 
     Frame frame(1, 1.0 / 60.0);
     for ( ; frame.Index < 120; frame.Advance()) {
         solver.Update(frame);
 
-        SaveParticleDataXy(particles, frame.Index);
+        particles->BuildNeighborSearch();
+        particles->BuildNeighborLists();
+        particles->UpdateDensities();
+
+        const size_t n = particles->NumberOfParticles();
+        auto positions = particles->Positions();
+        auto densities = particles->Densities();
+
+        Array1<Vector2F> positionsF(n);
+        for (size_t i = 0; i < n; ++i)
+            positionsF[i] = Vector2F(static_cast<float>(positions[i].x), static_cast<float>(positions[i].y));
+
+        Array1<float> densitiesF(n);
+        ComputeSPHDensities(positionsF.ConstAccessor(), particles->NeighborLists(),
+                    static_cast<float>(particles->KernelRadius()), static_cast<float>(particles->Mass()),
+                    densitiesF.Accessor());
+
+        double maxRelativeError = 0.0;
+        for (size_t i = 0; i < n; ++i)
+            maxRelativeError = std::max(maxRelativeError, std::abs(densitiesF[i] - densities[i]) / densities[i]);
+
+        frames.Append(static_cast<double>(frame.Index));
+        maxRelativeErrors.Append(maxRelativeError);
+
+        EXPECT_LT(maxRelativeError, 1e-4);
     }
+
+    SaveData(frames.ConstAccessor(), "data.#line2,x.npy");
+    SaveData(maxRelativeErrors.ConstAccessor(), "data.#line2,y.npy");
 }
 JET_END_TEST_F
\ No newline at end of file
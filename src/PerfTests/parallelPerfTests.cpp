@@ -1,4 +1,5 @@
 
+#include<Arrays/array3.h>
 #include<parallel.h>
 #include<timer.h>
 #include<gtest/gtest.h>
@@ -42,4 +43,112 @@ TEST(Parallel, For) {
         });
     }
     std::cout<<"ParallelFor Time: " << timer.DurationInSeconds()/20.0 << " secs" << std::endl;
-}
\ No newline at end of file
+}
+TEST(Parallel, ExclusiveScan) {
+    size_t N = (1 << 24) + 7;
+    std::vector<size_t> a(N), b(N);
+
+    for (size_t i = 0; i < N; ++i) {
+        a[i] = i % 7;
+    }
+
+    Timer timer;
+
+    for (int iter = 0; iter < 20; ++iter) {
+        size_t sum = 0;
+        for (size_t i = 0; i < N; ++i) {
+            b[i] = sum;
+            sum += a[i];
+        }
+    }
+
+    double serialTime = timer.DurationInSeconds() / 20.0;
+    std::cout << "Serial Time ExclusiveScan: " << serialTime << " secs ("
+              << N / serialTime * 1e-6 << " M elements/sec)" << std::endl;
+
+    timer.Reset();
+
+    for (int iter = 0; iter < 20; ++iter) {
+        ParallelExclusiveScan(a.begin(), a.end(), b.begin(), kZeroSize);
+    }
+
+    double parallelTime = timer.DurationInSeconds() / 20.0;
+    std::cout << "ParallelExclusiveScan Time: " << parallelTime << " secs ("
+              << N / parallelTime * 1e-6 << " M elements/sec)" << std::endl;
+}
+
+TEST(Parallel, Compact) {
+    size_t N = (1 << 24) + 7;
+    std::vector<double> a(N), b(N);
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(0.0, 1.0);
+
+    for (size_t i = 0; i < N; ++i) {
+        a[i] = d(rng);
+    }
+
+    auto predicate = [](double x) {
+        return x < 0.5;
+    };
+
+    Timer timer;
+
+    for (int iter = 0; iter < 20; ++iter) {
+        std::copy_if(a.begin(), a.end(), b.begin(), predicate);
+    }
+
+    double serialTime = timer.DurationInSeconds() / 20.0;
+    std::cout << "Serial Time Compact: " << serialTime << " secs ("
+              << N / serialTime * 1e-6 << " M elements/sec)" << std::endl;
+
+    timer.Reset();
+
+    for (int iter = 0; iter < 20; ++iter) {
+        ParallelCompact(a.begin(), a.end(), predicate, b.begin());
+    }
+
+    double parallelTime = timer.DurationInSeconds() / 20.0;
+    std::cout << "ParallelCompact Time: " << parallelTime << " secs ("
+              << N / parallelTime * 1e-6 << " M elements/sec)" << std::endl;
+}
+
+TEST(Parallel, TiledFor3D) {
+    // Thin grid where the Z extent is smaller than the number of threads.
+    size_t nX = 512, nY = 512, nZ = 4;
+    Array3<double> a(nX, nY, nZ), b(nX, nY, nZ);
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(0.0, 1.0);
+    a.ForEachIndex([&](size_t i, size_t j, size_t k) {
+        a(i, j, k) = d(rng);
+    });
+
+    auto stencil = [&](size_t i, size_t j, size_t k) {
+        size_t im = (i > 0) ? i - 1 : i, ip = (i + 1 < nX) ? i + 1 : i;
+        size_t jm = (j > 0) ? j - 1 : j, jp = (j + 1 < nY) ? j + 1 : j;
+        b(i, j, k) = 0.2 * (a(i, j, k) + a(im, j, k) + a(ip, j, k) + a(i, jm, k) + a(i, jp, k));
+    };
+
+    Timer timer;
+
+    for (int iter = 0; iter < 20; ++iter) {
+        ParallelFor(kZeroSize, nX, kZeroSize, nY, kZeroSize, nZ, stencil);
+    }
+    std::cout << "ParallelFor 3D Time: " << timer.DurationInSeconds() / 20.0 << " secs" << std::endl;
+
+    timer.Reset();
+
+    for (int iter = 0; iter < 20; ++iter) {
+        ParallelTiledFor(kZeroSize, nX, kZeroSize, nY, kZeroSize, nZ, stencil);
+    }
+    std::cout << "ParallelTiledFor 3D Time: " << timer.DurationInSeconds() / 20.0 << " secs" << std::endl;
+
+    timer.Reset();
+
+    for (int iter = 0; iter < 20; ++iter) {
+        ParallelTiledFor(kZeroSize, nX, kZeroSize, nY, kZeroSize, nZ,
+                        size_t(32), size_t(8), size_t(1), TileOrder::kMorton, stencil);
+    }
+    std::cout << "ParallelTiledFor 3D Time (Morton order): " << timer.DurationInSeconds() / 20.0 << " secs" << std::endl;
+}
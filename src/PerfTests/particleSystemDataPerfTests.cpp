@@ -0,0 +1,150 @@
+#include<ParticleSim/SPH/sph_system_data2.h>
+#include<Logging/logging.h>
+#include<timer.h>
+#include<gtest/gtest.h>
+
+#include<algorithm>
+#include<cmath>
+#include<random>
+#include<sstream>
+
+#include<iostream>
+
+using namespace jet;
+
+namespace
+{
+    // Returns the time of one UpdateDensities call, averaged over a few runs.
+    double MeasureUpdateDensities(SPHSystemData2* particles, int numIterations)
+    {
+        particles->BuildNeighborSearch();
+        particles->BuildNeighborLists();
+
+        Timer timer;
+        for (int iter = 0; iter < numIterations; ++iter)
+            particles->UpdateDensities();
+
+        return timer.DurationInSeconds() / numIterations;
+    }
+}
+
+TEST(ParticleSystemData2, ReorderBySpatialKey) {
+    std::ostringstream log;
+    Logging::SetAllStream(&log);
+
+    // A block of 250k particles stored in random order, as in a fluid which
+    // has been mixing for a while.
+    const double spacing = 0.002;
+    ParticleSystemData2::VectorData positions;
+    for (size_t j = 0; j < 500; ++j) {
+        for (size_t i = 0; i < 500; ++i)
+            positions.Append(Vector2D(spacing * i, spacing * j));
+    }
+
+    std::mt19937 rng;
+    std::shuffle(positions.begin(), positions.end(), rng);
+
+    // The densities are computed through the neighbor search without a skin
+    // radius, and through the neighbor lists with one.
+    for (double skinRadius : {0.0, 0.2 * spacing}) {
+        SPHSystemData2 particles;
+        particles.SetTargetSpacing(spacing);
+        particles.SetNeighborListSkinRadius(skinRadius);
+        particles.AddParticles(positions);
+
+        double shuffledTime = MeasureUpdateDensities(&particles, 5);
+
+        Timer timer;
+        particles.ReorderBySpatialKey();
+        double reorderTime = timer.DurationInSeconds();
+
+        double reorderedTime = MeasureUpdateDensities(&particles, 5);
+
+        std::cout << particles.NumberOfParticles() << " particles, skin radius "
+                  << skinRadius << std::endl;
+        std::cout << "  UpdateDensities in random order: " << shuffledTime * 1e3 << " msecs" << std::endl;
+        std::cout << "  UpdateDensities in Z-order: " << reorderedTime * 1e3 << " msecs" << std::endl;
+        std::cout << "  ReorderBySpatialKey: " << reorderTime * 1e3 << " msecs" << std::endl;
+    }
+
+    Logging::SetAllStream(&std::cout);
+}
+
+TEST(ParticleSystemData2, ContinuousEmission) {
+    // An emitter adding a few particles per substep to a large fluid, with
+    // the SPH density and pressure layers.
+    SPHSystemData2 particles;
+    particles.AddParticles(ParticleSystemData2::VectorData(200000));
+
+    ParticleSystemData2::VectorData batch(16, Vector2D(0.5, 0.5));
+
+    Timer timer;
+    for (size_t i = 0; i < 2000; ++i)
+        particles.AddParticles(batch);
+    double batchTime = timer.DurationInSeconds();
+
+    timer.Reset();
+    for (size_t i = 0; i < 32000; ++i)
+        particles.AddParticle(Vector2D(0.5, 0.5));
+    double singleTime = timer.DurationInSeconds();
+
+    std::cout << "2000 AddParticles of 16 particles: " << batchTime * 1e3 << " msecs" << std::endl;
+    std::cout << "32000 AddParticle: " << singleTime * 1e3 << " msecs" << std::endl;
+    EXPECT_EQ(264000u, particles.NumberOfParticles());
+}
+
+TEST(SPHSystemData2, SinglePrecisionDensities) {
+    std::ostringstream log;
+    Logging::SetAllStream(&log);
+
+    // A block of 250k particles in Z-order, with about 40 neighbors each.
+    const double spacing = 0.002;
+    SPHSystemData2 particles;
+    particles.SetTargetSpacing(spacing);
+
+    ParticleSystemData2::VectorData positions;
+    for (size_t j = 0; j < 500; ++j) {
+        for (size_t i = 0; i < 500; ++i)
+            positions.Append(Vector2D(spacing * i, spacing * j));
+    }
+    particles.AddParticles(positions);
+    particles.ReorderBySpatialKey();
+    particles.BuildNeighborSearch();
+    particles.BuildNeighborLists();
+
+    const size_t n = particles.NumberOfParticles();
+    auto x = particles.Positions();
+    Array1<Vector2F> positionsF(n);
+    for (size_t i = 0; i < n; ++i)
+        positionsF[i] = Vector2F(static_cast<float>(x[i].x), static_cast<float>(x[i].y));
+
+    const int numIterations = 5;
+    Array1<double> densities(n);
+    Timer timer;
+    for (int iter = 0; iter < numIterations; ++iter) {
+        ComputeSPHDensities(ConstArrayAccessor1<Vector2D>(x), particles.NeighborLists(),
+                    particles.KernelRadius(), particles.Mass(), densities.Accessor());
+    }
+    const double doubleTime = timer.DurationInSeconds() / numIterations;
+
+    Array1<float> densitiesF(n);
+    timer.Reset();
+    for (int iter = 0; iter < numIterations; ++iter) {
+        ComputeSPHDensities(positionsF.ConstAccessor(), particles.NeighborLists(),
+                    static_cast<float>(particles.KernelRadius()), static_cast<float>(particles.Mass()),
+                    densitiesF.Accessor());
+    }
+    const double floatTime = timer.DurationInSeconds() / numIterations;
+
+    double maxRelativeError = 0.0;
+    for (size_t i = 0; i < n; ++i)
+        maxRelativeError = std::max(maxRelativeError, std::abs(densitiesF[i] - densities[i]) / densities[i]);
+
+    Logging::SetAllStream(&std::cout);
+
+    EXPECT_LT(maxRelativeError, 1e-4);
+    std::cout << n << " particles" << std::endl;
+    std::cout << "  Densities in double: " << doubleTime * 1e3 << " msecs" << std::endl;
+    std::cout << "  Densities in float: " << floatTime * 1e3 << " msecs, max relative error "
+              << maxRelativeError << std::endl;
+}
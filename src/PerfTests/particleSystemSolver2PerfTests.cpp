@@ -0,0 +1,158 @@
+#include<Field/VectorField/constant_vector_field2.h>
+#include<ParticleSim/particle_system_solver2.h>
+#include<Logging/logging.h>
+#include<parallel.h>
+#include<timer.h>
+#include<gtest/gtest.h>
+
+#include<algorithm>
+#include<cstdlib>
+#include<iostream>
+#include<memory>
+#include<sstream>
+#include<vector>
+
+using namespace jet;
+
+TEST(ParticleSystemSolver2, AdvanceSubTimeStep) {
+    std::ostringstream log;
+    Logging::SetAllStream(&log);
+
+    // 1M particles under gravity and a constant wind, without collider or
+    // emitter, so that the frame time is the force and integration loops.
+    ParticleSystemSolver2 solver;
+    solver.SetWind(std::make_shared<ConstantVectorField2>(Vector2D(1.0, 0.0)));
+
+    auto particles = solver.ParticleSystemData();
+    ParticleSystemData2::VectorData positions;
+    for (size_t j = 0; j < 1000; ++j) {
+        for (size_t i = 0; i < 1000; ++i)
+            positions.Append(Vector2D(0.001 * i, 0.001 * j));
+    }
+    particles->AddParticles(positions);
+
+    // The first frame initializes the solver.
+    solver.Update(Frame(0, 1.0 / 60.0));
+
+    const int numFrames = 10;
+    Timer timer;
+    for (int frame = 1; frame <= numFrames; ++frame)
+        solver.Update(Frame(frame, 1.0 / 60.0));
+    const double frameTime = timer.DurationInSeconds() / numFrames;
+
+    Logging::SetAllStream(&std::cout);
+
+    EXPECT_GT(0.0, particles->Velocities()[0].y);
+    std::cout << particles->NumberOfParticles() << " particles: "
+              << frameTime * 1e3 << " msecs per frame" << std::endl;
+}
+
+TEST(ParticleSystemSolver2, SwapNewPositionsAndVelocities) {
+    // Ending a sub time-step used to copy the new positions and velocities
+    // back into the particle arrays, reading and writing both arrays.
+    ParticleSystemData2 particles;
+    particles.AddParticles(ParticleSystemData2::VectorData(1000000, Vector2D(0.5, 0.5)));
+
+    auto newPositions = particles.NewPositions();
+    auto newVelocities = particles.NewVelocities();
+    ParallelFor(kZeroSize, particles.NumberOfParticles(), [&](size_t i) {
+        newPositions[i] = Vector2D(1.0, 1.0);
+        newVelocities[i] = Vector2D(2.0, 2.0);
+    });
+
+    const int numIterations = 10;
+    Timer timer;
+    for (int iter = 0; iter < numIterations; ++iter) {
+        auto positions = particles.Positions();
+        auto velocities = particles.Velocities();
+        ParallelFor(kZeroSize, particles.NumberOfParticles(), [&](size_t i) {
+            positions[i] = newPositions[i];
+            velocities[i] = newVelocities[i];
+        });
+    }
+    const double copyTime = timer.DurationInSeconds() / numIterations;
+
+    // The swap is too fast to be timed once.
+    const int numSwaps = 1000;
+    timer.Reset();
+    for (int iter = 0; iter < numSwaps; ++iter) {
+        particles.NewPositions();
+        particles.NewVelocities();
+        particles.SwapNewPositionsAndVelocities();
+    }
+    const double swapTime = timer.DurationInSeconds() / numSwaps;
+
+    EXPECT_EQ(Vector2D(1.0, 1.0), particles.Positions()[0]);
+    EXPECT_EQ(Vector2D(2.0, 2.0), particles.Velocities()[0]);
+
+    const double bytes = 4.0 * sizeof(Vector2D) * particles.NumberOfParticles();
+    std::cout << particles.NumberOfParticles() << " particles, "
+              << bytes / (1 << 20) << " MB of memory traffic saved per sub time-step" << std::endl;
+    std::cout << "  Copy: " << copyTime * 1e3 << " msecs ("
+              << bytes / copyTime / (1 << 30) << " GB/s)" << std::endl;
+    std::cout << "  Swap: " << swapTime * 1e6 << " usecs" << std::endl;
+}
+
+TEST(ParticleSystemSolver2, IntegrationLayout) {
+    // The integration loop of TimeIntegration on the interleaved Vector2D
+    // arrays of ParticleSystemData2, and the same loop on 64-byte aligned
+    // per-component arrays, as a structure-of-arrays storage would have them.
+    const size_t n = 1000000;
+    const double timeStep = 1e-3;
+    const double timeStepOverMass = 1.0;
+
+    std::vector<Vector2D> x(n, Vector2D(0.5, 0.5)), v(n, Vector2D(1.0, 0.0)), f(n, Vector2D(0.0, -9.8));
+    std::vector<Vector2D> newX(n), newV(n);
+
+    auto allocate = [n](double value) {
+        std::unique_ptr<double, decltype(&std::free)> data(
+            static_cast<double*>(std::aligned_alloc(64, n * sizeof(double))), &std::free);
+        std::fill(data.get(), data.get() + n, value);
+        return data;
+    };
+    auto xx = allocate(0.5), xy = allocate(0.5), vx = allocate(1.0), vy = allocate(0.0);
+    auto fx = allocate(0.0), fy = allocate(-9.8);
+    auto newXx = allocate(0.0), newXy = allocate(0.0), newVx = allocate(0.0), newVy = allocate(0.0);
+
+    const int numIterations = 20;
+    Timer timer;
+    for (int iter = 0; iter < numIterations; ++iter) {
+        ParallelRangeFor(kZeroSize, n, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                newV[i] = v[i] + timeStepOverMass * f[i];
+                newX[i] = x[i] + timeStep * newV[i];
+            }
+        });
+    }
+    const double aosTime = timer.DurationInSeconds() / numIterations;
+
+    timer.Reset();
+    for (int iter = 0; iter < numIterations; ++iter) {
+        ParallelRangeFor(kZeroSize, n, [&](size_t begin, size_t end) {
+            const double* __restrict px = xx.get();
+            const double* __restrict py = xy.get();
+            const double* __restrict pvx = vx.get();
+            const double* __restrict pvy = vy.get();
+            const double* __restrict pfx = fx.get();
+            const double* __restrict pfy = fy.get();
+            double* __restrict qx = newXx.get();
+            double* __restrict qy = newXy.get();
+            double* __restrict qvx = newVx.get();
+            double* __restrict qvy = newVy.get();
+            for (size_t i = begin; i < end; ++i) {
+                qvx[i] = pvx[i] + timeStepOverMass * pfx[i];
+                qvy[i] = pvy[i] + timeStepOverMass * pfy[i];
+                qx[i] = px[i] + timeStep * qvx[i];
+                qy[i] = py[i] + timeStep * qvy[i];
+            }
+        });
+    }
+    const double soaTime = timer.DurationInSeconds() / numIterations;
+
+    EXPECT_EQ(newX[n - 1].x, newXx.get()[n - 1]);
+    EXPECT_EQ(newX[n - 1].y, newXy.get()[n - 1]);
+
+    std::cout << n << " particles" << std::endl;
+    std::cout << "  Vector2D arrays: " << aosTime * 1e3 << " msecs" << std::endl;
+    std::cout << "  Component arrays: " << soaTime * 1e3 << " msecs" << std::endl;
+}
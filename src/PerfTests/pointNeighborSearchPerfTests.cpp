@@ -0,0 +1,323 @@
+#include<Arrays/array1.h>
+#include<NeighborhoodSearch/point2_compact_hash_grid_search.h>
+#include<NeighborhoodSearch/point2_kdtree_search.h>
+#include<NeighborhoodSearch/point2_parallel_hash_grid_search.h>
+#include<NeighborhoodSearch/point3_kdtree_search.h>
+#include<NeighborhoodSearch/point3_parallel_hash_grid_search.h>
+#include<timer.h>
+#include<gtest/gtest.h>
+
+#include<random>
+
+#include<iostream>
+
+using namespace jet;
+
+namespace
+{
+    // Sums the distances to the neighbors of every point with the three query
+    // paths: the virtual ForEachNearbyPoint with a std::function, the visitor
+    // on the base class, and the templated ForEachNearbyPoint of the concrete
+    // class.
+    template<typename Base, typename Searcher, typename VectorType>
+    void MeasureQueryPaths(const Searcher& searcher, const Array1<VectorType>& points,
+                           double radius, int numIterations)
+    {
+        typedef typename Base::ForEachNearbyPointCallback Callback;
+        const Base& base = searcher;
+
+        double sum = 0.0;
+        auto accumulate = [&](size_t i) {
+            return [&, i](size_t, const VectorType& neighborPos) {
+                sum += points[i].DistanceTo(neighborPos);
+            };
+        };
+
+        Timer timer;
+        for (int iter = 0; iter < numIterations; ++iter) {
+            for (size_t i = 0; i < points.Size(); ++i)
+                base.ForEachNearbyPoint(points[i], radius, Callback(accumulate(i)));
+        }
+        double functionTime = timer.DurationInSeconds() / numIterations;
+        double functionSum = sum;
+
+        sum = 0.0;
+        timer.Reset();
+        for (int iter = 0; iter < numIterations; ++iter) {
+            for (size_t i = 0; i < points.Size(); ++i)
+                base.VisitNearbyPoints(points[i], radius, accumulate(i));
+        }
+        double visitorTime = timer.DurationInSeconds() / numIterations;
+        EXPECT_DOUBLE_EQ(functionSum, sum);
+
+        sum = 0.0;
+        timer.Reset();
+        for (int iter = 0; iter < numIterations; ++iter) {
+            for (size_t i = 0; i < points.Size(); ++i)
+                searcher.ForEachNearbyPoint(points[i], radius, accumulate(i));
+        }
+        double templateTime = timer.DurationInSeconds() / numIterations;
+        EXPECT_DOUBLE_EQ(functionSum, sum);
+
+        std::cout << points.Size() << " queries" << std::endl;
+        std::cout << "  Virtual std::function callback: " << functionTime * 1e3 << " msecs" << std::endl;
+        std::cout << "  Base class visitor: " << visitorTime * 1e3 << " msecs" << std::endl;
+        std::cout << "  Templated callback: " << templateTime * 1e3 << " msecs" << std::endl;
+    }
+
+    // Returns the time to build the searcher and to query every point.
+    template<typename Searcher, typename VectorType>
+    void MeasureBuildAndQuery(Searcher* searcher, const Array1<VectorType>& points,
+                              double radius, double* buildTime, double* queryTime)
+    {
+        Timer timer;
+        searcher->Build(points.ConstAccessor());
+        *buildTime = timer.DurationInSeconds();
+
+        size_t count = 0;
+        timer.Reset();
+        for (size_t i = 0; i < points.Size(); ++i)
+            searcher->ForEachNearbyPoint(points[i], radius, [&](size_t, const VectorType&) { ++count; });
+        *queryTime = timer.DurationInSeconds();
+        EXPECT_LT(0u, count);
+    }
+
+    // Compares the KD-tree against the parallel hash grid on the radius
+    // queries, and times the k-nearest-neighbor queries of the KD-tree.
+    template<typename KdTree, typename HashGrid, typename VectorType>
+    void CompareKdTreeAndHashGrid(KdTree* kdTree, HashGrid* hashGrid,
+                                  const Array1<VectorType>& points, double radius, size_t k)
+    {
+        double buildTime, queryTime;
+        std::cout << points.Size() << " points" << std::endl;
+
+        MeasureBuildAndQuery(hashGrid, points, radius, &buildTime, &queryTime);
+        std::cout << "  Parallel hash grid radius queries: build " << buildTime * 1e3
+                  << " msecs, query " << queryTime * 1e3 << " msecs" << std::endl;
+
+        MeasureBuildAndQuery(kdTree, points, radius, &buildTime, &queryTime);
+        std::cout << "  KD-tree radius queries: build " << buildTime * 1e3
+                  << " msecs, query " << queryTime * 1e3 << " msecs" << std::endl;
+
+        double sum = 0.0;
+        Timer timer;
+        for (size_t i = 0; i < points.Size(); ++i) {
+            kdTree->ForEachKNearest(points[i], k, [&](size_t, const VectorType& pt) {
+                sum += points[i].DistanceTo(pt);
+            });
+        }
+        std::cout << "  KD-tree " << k << "-nearest queries: " << timer.DurationInSeconds() * 1e3
+                  << " msecs" << std::endl;
+        EXPECT_LT(0.0, sum);
+    }
+}
+
+TEST(PointNeighborSearch2, QueryPaths) {
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(0.0, 1.0);
+
+    Array1<Vector2D> points(100000);
+    for (size_t i = 0; i < points.Size(); ++i)
+        points[i] = Vector2D(d(rng), d(rng));
+
+    // About 30 neighbors per point.
+    const double radius = 0.01;
+    PointParallelHashGridSearch2 searcher(64, 64, 2.0 * radius);
+    searcher.Build(points.Accessor());
+
+    MeasureQueryPaths<PointNeighborSearch2>(searcher, points, radius, 5);
+}
+
+TEST(PointNeighborSearch3, QueryPaths) {
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(0.0, 1.0);
+
+    Array1<Vector3D> points(100000);
+    for (size_t i = 0; i < points.Size(); ++i)
+        points[i] = Vector3D(d(rng), d(rng), d(rng));
+
+    // About 30 neighbors per point.
+    const double radius = 0.04;
+    PointParallelHashGridSearch3 searcher(64, 64, 64, 2.0 * radius);
+    searcher.Build(points.Accessor());
+
+    MeasureQueryPaths<PointNeighborSearch3>(searcher, points, radius, 5);
+}
+
+TEST(PointNeighborSearch2, SparseDomain) {
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(0.0, 1.0);
+
+    // Splashes: small dense clusters scattered over a large domain.
+    Array1<Vector2D> points(100000);
+    for (size_t i = 0; i < points.Size(); ++i) {
+        const size_t cluster = i % 16;
+        points[i] = Vector2D(100.0 * (cluster % 4), 100.0 * (cluster / 4))
+                    + Vector2D(d(rng), d(rng));
+    }
+
+    const double radius = 0.01;
+    double buildTime, queryTime;
+
+    PointParallelHashGridSearch2 parallelSearcher(1024, 1024, 2.0 * radius);
+    MeasureBuildAndQuery(&parallelSearcher, points, radius, &buildTime, &queryTime);
+    std::cout << points.Size() << " points in 16 clusters" << std::endl;
+    std::cout << "  Parallel hash grid (1024 x 1024 buckets): build " << buildTime * 1e3
+              << " msecs, query " << queryTime * 1e3 << " msecs, "
+              << parallelSearcher.Statistics().NumberOfCollidingBuckets << " colliding buckets" << std::endl;
+
+    PointCompactHashGridSearch2 compactSearcher(2.0 * radius);
+    MeasureBuildAndQuery(&compactSearcher, points, radius, &buildTime, &queryTime);
+    std::cout << "  Compact hash grid (" << compactSearcher.TableCapacity() << " slots): build "
+              << buildTime * 1e3 << " msecs, query " << queryTime * 1e3 << " msecs" << std::endl;
+}
+
+TEST(PointNeighborSearch2, KdTree) {
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(0.0, 1.0);
+
+    Array1<Vector2D> points(100000);
+    for (size_t i = 0; i < points.Size(); ++i)
+        points[i] = Vector2D(d(rng), d(rng));
+
+    // About 30 neighbors per point.
+    const double radius = 0.01;
+    PointKdTreeSearch2 kdTree;
+    PointParallelHashGridSearch2 hashGrid(64, 64, 2.0 * radius);
+    CompareKdTreeAndHashGrid(&kdTree, &hashGrid, points, radius, 30);
+}
+
+TEST(PointNeighborSearch3, KdTree) {
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(0.0, 1.0);
+
+    Array1<Vector3D> points(100000);
+    for (size_t i = 0; i < points.Size(); ++i)
+        points[i] = Vector3D(d(rng), d(rng), d(rng));
+
+    // About 30 neighbors per point.
+    const double radius = 0.04;
+    PointKdTreeSearch3 kdTree;
+    PointParallelHashGridSearch3 hashGrid(64, 64, 64, 2.0 * radius);
+    CompareKdTreeAndHashGrid(&kdTree, &hashGrid, points, radius, 30);
+}
+
+TEST(PointNeighborSearch2, IncrementalUpdate) {
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(0.0, 1.0);
+
+    const double radius = 0.002;
+    const double gridSpacing = 2.0 * radius;
+
+    // The particles are stored in the order of the buckets, as after
+    // ParticleSystemData2::ReorderBySpatialKey.
+    Array1<Vector2D> points(1000000);
+    for (size_t i = 0; i < points.Size(); ++i)
+        points[i] = Vector2D((i % 1000 + d(rng)) * 0.001, (i / 1000 + d(rng)) * 0.001);
+    PointParallelHashGridSearch2 searcher(256, 256, gridSpacing);
+    searcher.Build(points.ConstAccessor());
+
+    std::cout << points.Size() << " points" << std::endl;
+
+    // A sub-step moves a particle by a fraction of the grid spacing.
+    for (double maxMove : {0.01, 0.05, 0.25}) {
+        std::uniform_real_distribution<> move(-maxMove * gridSpacing, maxMove * gridSpacing);
+        for (size_t i = 0; i < points.Size(); ++i)
+            points[i] += Vector2D(move(rng), move(rng));
+
+        PointParallelHashGridSearch2 rebuilt(256, 256, gridSpacing);
+        Timer timer;
+        rebuilt.Build(points.ConstAccessor());
+        const double buildTime = timer.DurationInSeconds();
+
+        timer.Reset();
+        searcher.Update(points.ConstAccessor());
+        const double updateTime = timer.DurationInSeconds();
+
+        EXPECT_EQ(rebuilt.SortedIndices(), searcher.SortedIndices());
+
+        std::cout << "  Moved by up to " << maxMove << " grid spacing: build "
+                  << buildTime * 1e3 << " msecs, update " << updateTime * 1e3 << " msecs" << std::endl;
+    }
+}
+
+namespace
+{
+    // Returns the name of the SIMD instruction set the bucket scans use.
+    const char* SimdName()
+    {
+#if defined(JET_USE_AVX512)
+        return "AVX-512";
+#elif defined(JET_USE_AVX)
+        return "AVX";
+#elif defined(JET_USE_SSE2)
+        return "SSE2";
+#else
+        return "scalar";
+#endif
+    }
+
+    // Prints the number of templated radius queries per second, one query
+    // around each point.
+    template<typename Searcher, typename VectorType>
+    void MeasureQueriesPerSecond(const char* name, const Searcher& searcher,
+                                 const Array1<VectorType>& points, double radius)
+    {
+        size_t count = 0;
+        Timer timer;
+        for (size_t i = 0; i < points.Size(); ++i)
+            searcher.ForEachNearbyPoint(points[i], radius, [&](size_t, const VectorType&) { ++count; });
+        const double time = timer.DurationInSeconds();
+        EXPECT_LT(0u, count);
+
+        std::cout << "  " << name << " (" << SimdName() << "): " << points.Size() / time
+                  << " queries/sec, " << static_cast<double>(count) / points.Size()
+                  << " neighbors per query" << std::endl;
+    }
+}
+
+TEST(PointNeighborSearch2, BucketScan) {
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(0.0, 1.0);
+    std::normal_distribution<> n(0.0, 0.05);
+
+    const double radius = 0.01;
+    Array1<Vector2D> uniform(100000);
+    for (size_t i = 0; i < uniform.Size(); ++i)
+        uniform[i] = Vector2D(d(rng), d(rng));
+
+    // Dense blobs, so that the buckets hold many points.
+    Array1<Vector2D> clustered(100000);
+    for (size_t i = 0; i < clustered.Size(); ++i)
+        clustered[i] = Vector2D(0.25 + 0.5 * (i % 2), 0.25 + 0.5 * (i / 2 % 2)) + Vector2D(n(rng), n(rng));
+
+    std::cout << uniform.Size() << " points" << std::endl;
+    for (const auto* points : {&uniform, &clustered}) {
+        PointParallelHashGridSearch2 searcher(64, 64, 2.0 * radius);
+        searcher.Build(points->ConstAccessor());
+        MeasureQueriesPerSecond(points == &uniform ? "Uniform" : "Clustered", searcher, *points, radius);
+    }
+}
+
+TEST(PointNeighborSearch3, BucketScan) {
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(0.0, 1.0);
+    std::normal_distribution<> n(0.0, 0.1);
+
+    const double radius = 0.04;
+    Array1<Vector3D> uniform(100000);
+    for (size_t i = 0; i < uniform.Size(); ++i)
+        uniform[i] = Vector3D(d(rng), d(rng), d(rng));
+
+    Array1<Vector3D> clustered(100000);
+    for (size_t i = 0; i < clustered.Size(); ++i)
+        clustered[i] = Vector3D(0.25 + 0.5 * (i % 2), 0.25 + 0.5 * (i / 2 % 2), 0.5)
+                       + Vector3D(n(rng), n(rng), n(rng));
+
+    std::cout << uniform.Size() << " points" << std::endl;
+    for (const auto* points : {&uniform, &clustered}) {
+        PointParallelHashGridSearch3 searcher(64, 64, 64, 2.0 * radius);
+        searcher.Build(points->ConstAccessor());
+        MeasureQueriesPerSecond(points == &uniform ? "Uniform" : "Clustered", searcher, *points, radius);
+    }
+}
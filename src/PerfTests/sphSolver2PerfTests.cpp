@@ -0,0 +1,70 @@
+#include<ParticleSim/SPH/sph_solver2.h>
+#include<Geometry/PointGenerator/volume_particle_emitter2.h>
+#include<Geometry/Sphere/sphere2.h>
+#include<Geometry/Surface/surface_to_implicit2.h>
+#include<Logging/logging.h>
+#include<timer.h>
+#include<gtest/gtest.h>
+
+#include<memory>
+#include<sstream>
+
+#include<iostream>
+
+using namespace jet;
+
+namespace
+{
+    double MeasureUpdate(bool isUsingHalfNeighborLists, double skinRadius,
+                         size_t* numberOfParticles)
+    {
+        SPHSolver2 solver(1000.0, 0.01, 1.8);
+        solver.SetIsUsingHalfNeighborLists(isUsingHalfNeighborLists);
+        solver.SPHSystemData()->SetNeighborListSkinRadius(skinRadius);
+
+        auto sphere = std::make_shared<Sphere2>(Vector2D(0.5, 0.5), 0.4);
+        auto emitter = std::make_shared<VolumeParticleEmitter2>(
+            std::make_shared<SurfaceToImplicit2>(sphere),
+            BoundingBox2D(Vector2D(0, 0), Vector2D(1, 1)), 0.01);
+        solver.SetEmitter(emitter);
+
+        // The first frame emits the particles.
+        solver.Update(Frame(0, 1.0 / 60.0));
+        *numberOfParticles = solver.SPHSystemData()->NumberOfParticles();
+
+        Timer timer;
+        solver.Update(Frame(1, 1.0 / 60.0));
+
+        return timer.DurationInSeconds();
+    }
+}
+
+TEST(SPHSolver2, HalfNeighborLists) {
+    std::ostringstream log;
+    Logging::SetAllStream(&log);
+
+    size_t numberOfParticles = 0;
+    double fullTime = MeasureUpdate(false, 0.0, &numberOfParticles);
+    double halfTime = MeasureUpdate(true, 0.0, &numberOfParticles);
+
+    Logging::SetAllStream(&std::cout);
+
+    std::cout << numberOfParticles << " particles" << std::endl;
+    std::cout << "  Full neighbor lists per frame: " << fullTime * 1e3 << " msecs" << std::endl;
+    std::cout << "  Half neighbor lists per frame: " << halfTime * 1e3 << " msecs" << std::endl;
+}
+
+TEST(SPHSolver2, NeighborListSkinRadius) {
+    std::ostringstream log;
+    Logging::SetAllStream(&log);
+
+    size_t numberOfParticles = 0;
+    double noSkinTime = MeasureUpdate(true, 0.0, &numberOfParticles);
+    double skinTime = MeasureUpdate(true, 0.2 * 0.01 * 1.8, &numberOfParticles);
+
+    Logging::SetAllStream(&std::cout);
+
+    std::cout << numberOfParticles << " particles" << std::endl;
+    std::cout << "  Rebuilt every sub-step per frame: " << noSkinTime * 1e3 << " msecs" << std::endl;
+    std::cout << "  Skin radius of 0.2 h per frame: " << skinTime * 1e3 << " msecs" << std::endl;
+}
@@ -0,0 +1,129 @@
+#include<parallel.h>
+#include<thread_pool.h>
+#include<timer.h>
+#include<gtest/gtest.h>
+
+#include<algorithm>
+#include<cmath>
+#include<random>
+#include<thread>
+#include<vector>
+
+#include<iostream>
+
+using namespace jet;
+
+namespace
+{
+    // Reference implementation which spawns and joins the threads on every
+    // call, as ParallelFor did before the thread pool was introduced.
+    template<typename Function>
+    void ThreadSpawningFor(size_t start, size_t end, const Function& func)
+    {
+        const unsigned int NumThreads = ThreadPool::GetInstance().NumberOfThreads();
+        size_t slice = std::max((end - start) / NumThreads, kOneSize);
+
+        std::vector<std::thread> pool;
+        pool.reserve(NumThreads);
+        size_t i1 = start;
+        size_t i2 = std::min(start + slice, end);
+        for (unsigned int i = 0; i < NumThreads - 1 && i1 < end; ++i)
+        {
+            pool.emplace_back([&func, i1, i2](){
+                for (size_t k = i1; k < i2; ++k)
+                    func(k);
+            });
+            i1 = i2;
+            i2 = std::min(i2 + slice, end);
+        }
+
+        if (i1 < end)
+        {
+            pool.emplace_back([&func, i1, end](){
+                for (size_t k = i1; k < end; ++k)
+                    func(k);
+            });
+        }
+
+        for (std::thread& t : pool)
+            t.join();
+    }
+
+    void MeasureForOverhead(size_t N, int numIterations)
+    {
+        std::vector<double> a(N), b(N), c(N);
+
+        std::mt19937 rng;
+        std::uniform_real_distribution<> d(0.0, 1.0);
+
+        for (size_t i = 0; i < N; ++i) {
+            a[i] = d(rng);
+            b[i] = d(rng);
+        }
+
+        auto kernel = [&] (size_t i) {
+            c[i] = 1.0 / std::sqrt(a[i] / b[i] + 1.0);
+        };
+
+        Timer timer;
+        for (int iter = 0; iter < numIterations; ++iter)
+            ThreadSpawningFor(kZeroSize, N, kernel);
+
+        double spawnTime = timer.DurationInSeconds() / numIterations;
+
+        timer.Reset();
+        for (int iter = 0; iter < numIterations; ++iter)
+            ParallelFor(kZeroSize, N, kernel);
+
+        double poolTime = timer.DurationInSeconds() / numIterations;
+
+        std::cout << "N = " << N << " (" << ThreadPool::GetInstance().NumberOfThreads()
+                  << " threads)" << std::endl;
+        std::cout << "  Thread spawning per call: " << spawnTime * 1e6 << " usecs" << std::endl;
+        std::cout << "  Thread pool per call: " << poolTime * 1e6 << " usecs" << std::endl;
+    }
+}
+
+TEST(ThreadPool, ForOverheadSmallRange) {
+    MeasureForOverhead(64, 2000);
+}
+
+TEST(ThreadPool, ForOverheadLargeRange) {
+    MeasureForOverhead((1 << 22) + 7, 20);
+}
+
+TEST(ThreadPool, StrongScaling) {
+    size_t N = (1 << 22) + 7;
+    std::vector<double> a(N), b(N), c(N);
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(0.0, 1.0);
+
+    for (size_t i = 0; i < N; ++i) {
+        a[i] = d(rng);
+        b[i] = d(rng);
+    }
+
+    const unsigned int maxNumThreads = ThreadPool::DefaultNumberOfThreads();
+    double singleThreadTime = 0.0;
+
+    for (unsigned int numThreads = 1; numThreads <= maxNumThreads; ++numThreads) {
+        SetMaxNumberOfThreads(numThreads);
+
+        Timer timer;
+        for (int iter = 0; iter < 20; ++iter) {
+            ParallelFor(kZeroSize, N, [&] (size_t i) {
+                c[i] = 1.0 / std::sqrt(a[i] / b[i] + 1.0);
+            });
+        }
+
+        double time = timer.DurationInSeconds() / 20.0;
+        if (numThreads == 1)
+            singleThreadTime = time;
+
+        std::cout << numThreads << " threads: " << time * 1e3 << " msecs, speedup "
+                  << singleThreadTime / time << "x" << std::endl;
+    }
+
+    SetMaxNumberOfThreads(0);
+}
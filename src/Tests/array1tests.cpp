@@ -92,6 +92,33 @@ TEST(Array1, Resize)
     }
 }
 
+TEST(Array1, Reserve)
+{
+    jet::Array1<float> arr = {1.f, 2.f};
+    arr.Reserve(100);
+    EXPECT_EQ(2u, arr.Size());
+    EXPECT_LE(100u, arr.Capacity());
+
+    // Growing within the capacity keeps the storage.
+    const float* data = arr.Data();
+    arr.Resize(100, 3.f);
+    EXPECT_EQ(data, arr.Data());
+    EXPECT_FLOAT_EQ(2.f, arr[1]);
+    EXPECT_FLOAT_EQ(3.f, arr[99]);
+}
+
+TEST(Array1, AppendAccessor)
+{
+    jet::Array1<float> arr = {1.f, 2.f};
+    jet::Array1<float> other = {3.f, 4.f, 5.f};
+    arr.Append(other.ConstAccessor());
+    ASSERT_EQ(5u, arr.Size());
+    for (size_t i = 0; i < 5; ++i)
+    {
+        EXPECT_FLOAT_EQ(static_cast<float>(i + 1), arr[i]);
+    }
+}
+
 TEST(Array1, Iterators)
 {
     jet::Array1<float> arr1 = {6.f, 4.f, 1.f, -5.f};
@@ -0,0 +1,40 @@
+#include <NeighborhoodSearch/hash_grid_utils.h>
+#include <gtest/gtest.h>
+
+using namespace jet;
+
+TEST(HashGridUtils, SuggestHashGridResolution2) {
+    // 10 x 5 cells of 0.1 and plenty of points: no wrapping.
+    BoundingBox2D bounds(Vector2D(0.0, 0.0), Vector2D(0.95, 0.45));
+    EXPECT_EQ(Size2(10, 5), SuggestHashGridResolution(bounds, 1000, 0.1));
+
+    // The cells are counted from the grid origin, not from the lower corner.
+    bounds = BoundingBox2D(Vector2D(-0.05, 0.05), Vector2D(0.05, 0.15));
+    EXPECT_EQ(Size2(2, 2), SuggestHashGridResolution(bounds, 1000, 0.1));
+
+    // 1000 x 1000 cells for 100 points: scaled down to about 100 buckets.
+    bounds = BoundingBox2D(Vector2D(0.0, 0.0), Vector2D(99.95, 99.95));
+    EXPECT_EQ(Size2(10, 10), SuggestHashGridResolution(bounds, 100, 0.1));
+    EXPECT_EQ(Size2(5, 5), SuggestHashGridResolution(bounds, 100, 0.1, 4.0));
+
+    // A thin row of 1000 x 2 cells keeps its 2 rows.
+    bounds = BoundingBox2D(Vector2D(0.0, 0.0), Vector2D(99.95, 0.15));
+    EXPECT_EQ(Size2(250, 2), SuggestHashGridResolution(bounds, 500, 0.1));
+
+    // At least 2 buckets per axis.
+    bounds = BoundingBox2D(Vector2D(0.0, 0.0), Vector2D(0.0, 0.0));
+    EXPECT_EQ(Size2(2, 2), SuggestHashGridResolution(bounds, 1, 0.1));
+    EXPECT_EQ(Size2(2, 2), SuggestHashGridResolution(BoundingBox2D(), 0, 0.1));
+
+    EXPECT_THROW(SuggestHashGridResolution(bounds, 1, 0.0), std::invalid_argument);
+}
+
+TEST(HashGridUtils, SuggestHashGridResolution3) {
+    BoundingBox3D bounds(Vector3D(0.0, 0.0, 0.0), Vector3D(0.95, 0.45, 0.25));
+    EXPECT_EQ(Size3(10, 5, 3), SuggestHashGridResolution(bounds, 1000, 0.1));
+
+    bounds = BoundingBox3D(Vector3D(0.0, 0.0, 0.0), Vector3D(99.95, 99.95, 99.95));
+    EXPECT_EQ(Size3(10, 10, 10), SuggestHashGridResolution(bounds, 1000, 0.1));
+
+    EXPECT_EQ(Size3(2, 2, 2), SuggestHashGridResolution(BoundingBox3D(), 0, 0.1));
+}
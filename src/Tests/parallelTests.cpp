@@ -5,8 +5,16 @@
 #include<gtest/gtest.h>
 
 #include<algorithm>
+#include<atomic>
+#include<chrono>
+#include<ctime>
 #include<functional>
+#include<iterator>
+#include<limits>
 #include<random>
+#include<stdexcept>
+#include<thread>
+#include<utility>
 #include<vector>
 
 using namespace jet;
@@ -38,6 +46,96 @@ TEST(Parallel, For) {
     });
 }
 
+TEST(Parallel, ForException) {
+    // Every slice throws, including the ones run by the pool.
+    EXPECT_THROW(ParallelFor(kZeroSize, size_t(1000), [](size_t) {
+        throw std::runtime_error("body");
+    }), std::runtime_error);
+
+    // Only a slice run by the pool throws.
+    EXPECT_THROW(ParallelRangeFor(kZeroSize, size_t(1000), size_t(10), [](size_t begin, size_t) {
+        if (begin == 500)
+            throw std::runtime_error("slice");
+    }), std::runtime_error);
+
+    // The pool keeps working afterwards.
+    std::vector<size_t> a(1000, 0);
+    ParallelFor(kZeroSize, a.size(), [&a](size_t i) { a[i] = i; });
+    for (size_t i = 0; i < a.size(); ++i) {
+        EXPECT_EQ(i, a[i]);
+    }
+}
+
+TEST(Parallel, RangeFor) {
+    size_t N = std::max(20u, (3 * NumCores) / 2);
+    std::vector<double> a(N, 0.0);
+
+    ParallelRangeFor(kZeroSize, a.size(), [&a] (size_t begin, size_t end) {
+        EXPECT_LE(begin, end);
+        for (size_t i = begin; i < end; ++i) {
+            a[i] += static_cast<double>(i);
+        }
+    });
+
+    for (size_t i = 0; i < N; ++i) {
+        EXPECT_DOUBLE_EQ(static_cast<double>(i), a[i]);
+    }
+
+    std::vector<size_t> chunkSizes(N, 0);
+    ParallelRangeFor(kZeroSize, N, size_t(3), [&] (size_t begin, size_t end) {
+        EXPECT_LE(end - begin, 3u);
+        for (size_t i = begin; i < end; ++i) {
+            a[i] += 1.0;
+            chunkSizes[i] = end - begin;
+        }
+    });
+
+    for (size_t i = 0; i < N; ++i) {
+        EXPECT_DOUBLE_EQ(static_cast<double>(i) + 1.0, a[i]);
+        EXPECT_EQ(i + 3 <= N ? 3u : N % 3, chunkSizes[i]);
+    }
+
+    ParallelRangeFor(size_t(5), size_t(5), [] (size_t, size_t) {
+        FAIL();
+    });
+}
+
+TEST(Parallel, Reduce) {
+    size_t N = std::max(1000u, (3 * NumCores) / 2);
+    std::vector<double> a(N);
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(-1.0, 1.0);
+
+    double expectedSum = 0.0;
+    double expectedMin = std::numeric_limits<double>::max();
+    double expectedMax = std::numeric_limits<double>::lowest();
+    for (size_t i = 0; i < N; ++i) {
+        a[i] = d(rng);
+        expectedSum += a[i];
+        expectedMin = std::min(expectedMin, a[i]);
+        expectedMax = std::max(expectedMax, a[i]);
+    }
+
+    auto value = [&a] (size_t i) { return a[i]; };
+
+    EXPECT_NEAR(expectedSum, ParallelSum(kZeroSize, N, value), 1e-9);
+    EXPECT_DOUBLE_EQ(expectedMin, ParallelMin(kZeroSize, N, value));
+    EXPECT_DOUBLE_EQ(expectedMax, ParallelMax(kZeroSize, N, value));
+
+    size_t numPositive = ParallelReduce(kZeroSize, N, kZeroSize,
+        [&a] (size_t i) -> size_t { return a[i] > 0.0 ? 1 : 0; },
+        [] (size_t x, size_t y) { return x + y; });
+    EXPECT_EQ(
+        static_cast<size_t>(std::count_if(a.begin(), a.end(), [] (double x) { return x > 0.0; })),
+        numPositive);
+
+    EXPECT_EQ(-3, ParallelReduce(kZeroSize, kZeroSize, -3,
+        [] (size_t) { return 1; },
+        [] (int x, int y) { return x + y; }));
+    EXPECT_DOUBLE_EQ(std::numeric_limits<double>::lowest(), ParallelMax(kZeroSize, kZeroSize, value));
+}
+
 TEST(Parallel, For2D) {
     size_t nX = std::max(20u, (3 * NumCores) / 2);
     size_t nY = std::max(30u, (3 * NumCores) / 2);
@@ -82,6 +180,203 @@ TEST(Parallel, For3D) {
     });
 }
 
+TEST(Parallel, TiledFor2D) {
+    size_t nX = 131;
+    size_t nY = 67;
+
+    for (TileOrder order : {TileOrder::kRowMajor, TileOrder::kMorton}) {
+        Array2<int> visits(nX, nY, 0);
+
+        // Non-zero begin indices and tiles which do not divide the range.
+        ParallelTiledFor(
+            size_t(3), nX,
+            size_t(1), nY,
+            size_t(16), size_t(5),
+            order,
+            [&] (size_t i, size_t j) {
+            ++visits(i, j);
+        });
+
+        for (size_t j = 0; j < nY; ++j) {
+            for (size_t i = 0; i < nX; ++i) {
+                EXPECT_EQ((i >= 3 && j >= 1) ? 1 : 0, visits(i, j));
+            }
+        }
+    }
+
+    Array2<int> visits(nX, 2, 0);
+    ParallelTiledFor(kZeroSize, nX, kZeroSize, size_t(2), [&] (size_t i, size_t j) {
+        ++visits(i, j);
+    });
+    visits.ForEach([](int v) {
+        EXPECT_EQ(1, v);
+    });
+}
+
+TEST(Parallel, TiledFor3D) {
+    size_t nX = 70;
+    size_t nY = 19;
+    size_t nZ = 3;
+
+    for (TileOrder order : {TileOrder::kRowMajor, TileOrder::kMorton}) {
+        Array3<int> visits(nX, nY, nZ, 0);
+
+        ParallelTiledFor(
+            size_t(1), nX,
+            kZeroSize, nY,
+            kZeroSize, nZ,
+            size_t(32), size_t(4), size_t(2),
+            order,
+            [&] (size_t i, size_t j, size_t k) {
+            ++visits(i, j, k);
+        });
+
+        for (size_t k = 0; k < nZ; ++k) {
+            for (size_t j = 0; j < nY; ++j) {
+                for (size_t i = 0; i < nX; ++i) {
+                    EXPECT_EQ(i >= 1 ? 1 : 0, visits(i, j, k));
+                }
+            }
+        }
+    }
+
+    // Small Z extent with the default tile size
+    Array3<int> visits(nX, nY, 1, 0);
+    ParallelTiledFor(kZeroSize, nX, kZeroSize, nY, kZeroSize, size_t(1),
+        [&] (size_t i, size_t j, size_t k) {
+        ++visits(i, j, k);
+    });
+    visits.ForEach([](int v) {
+        EXPECT_EQ(1, v);
+    });
+}
+
+TEST(Parallel, ExecutionPolicy) {
+    const std::thread::id callerId = std::this_thread::get_id();
+
+    // The serial policy runs on the calling thread, in order.
+    std::vector<size_t> order;
+    ParallelFor(kZeroSize, size_t(100), [&](size_t i) {
+        EXPECT_EQ(callerId, std::this_thread::get_id());
+        order.push_back(i);
+    }, ExecutionPolicy::kSerial);
+    ASSERT_EQ(size_t(100), order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        EXPECT_EQ(i, order[i]);
+    }
+
+    // The auto policy runs small ranges on the calling thread.
+    size_t numCalls = 0;
+    ParallelRangeFor(kZeroSize, kAutoParallelThreshold - 1, [&](size_t begin, size_t end) {
+        EXPECT_EQ(callerId, std::this_thread::get_id());
+        EXPECT_EQ(kZeroSize, begin);
+        EXPECT_EQ(kAutoParallelThreshold - 1, end);
+        ++numCalls;
+    }, ExecutionPolicy::kAuto);
+    EXPECT_EQ(size_t(1), numCalls);
+
+    for (ExecutionPolicy policy : {ExecutionPolicy::kSerial, ExecutionPolicy::kParallel, ExecutionPolicy::kAuto}) {
+        for (size_t N : {10u, 54321u}) {
+            std::vector<int> a(N);
+            ParallelFill(a.begin(), a.end(), 3, policy);
+            EXPECT_EQ(std::vector<int>(N, 3), a);
+
+            Array2<int> b(N, 2, 0);
+            ParallelFor(kZeroSize, N, kZeroSize, size_t(2), [&](size_t i, size_t j) {
+                b(i, j) = static_cast<int>(i + j);
+            }, policy);
+            EXPECT_EQ(static_cast<int>(N), b(N - 1, 1));
+
+            EXPECT_EQ(N * (N - 1) / 2,
+                ParallelSum(kZeroSize, N, [](size_t i) { return i; }, policy));
+
+            std::vector<int> c(N);
+            for (size_t i = 0; i < N; ++i) {
+                c[i] = static_cast<int>((i * 7919) % 1000);
+            }
+            std::vector<int> expected = c;
+            std::sort(expected.begin(), expected.end());
+            ParallelSort(c.begin(), c.end(), policy);
+            EXPECT_EQ(expected, c);
+        }
+    }
+}
+
+TEST(Parallel, MaxNumberOfThreads) {
+    const unsigned int defaultNumThreads = GetMaxNumberOfThreads();
+    EXPECT_EQ(ThreadPool::DefaultNumberOfThreads(), defaultNumThreads);
+
+    for (unsigned int numThreads : {1u, 2u, 3u}) {
+        SetMaxNumberOfThreads(numThreads);
+        EXPECT_EQ(numThreads, GetMaxNumberOfThreads());
+
+        std::vector<size_t> a(1000, 0);
+        ParallelFor(kZeroSize, a.size(), [&](size_t i) {
+            a[i] = i;
+        });
+        for (size_t i = 0; i < a.size(); ++i) {
+            EXPECT_EQ(i, a[i]);
+        }
+    }
+
+    SetIsPinningThreadsToCores(true);
+    EXPECT_TRUE(IsPinningThreadsToCores());
+    EXPECT_EQ(3u, GetMaxNumberOfThreads());
+    EXPECT_EQ(size_t(499500), ParallelSum(kZeroSize, size_t(1000), [](size_t i) { return i; }));
+    SetIsPinningThreadsToCores(false);
+    EXPECT_FALSE(IsPinningThreadsToCores());
+
+    SetMaxNumberOfThreads(0);
+    EXPECT_EQ(defaultNumThreads, GetMaxNumberOfThreads());
+}
+
+TEST(Parallel, WaitSleepsWhileTasksRun) {
+    SetMaxNumberOfThreads(2);
+
+    std::atomic<bool> isStarted(false);
+    TaskGroup group;
+    group.Run([&]() {
+        isStarted = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    });
+
+    // Make sure the worker runs the task, not the waiting thread.
+    while (!isStarted) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    const std::clock_t start = std::clock();
+    group.Wait();
+    const double cpuSeconds = static_cast<double>(std::clock() - start) / CLOCKS_PER_SEC;
+
+    // A spinning waiter would use about as much CPU time as the task sleeps.
+    EXPECT_LT(cpuSeconds, 0.1);
+
+    SetMaxNumberOfThreads(0);
+}
+
+TEST(Parallel, ResizeWhileBusy) {
+    std::atomic<bool> isReleased(false);
+    TaskGroup group;
+    group.Run([&]() {
+        while (!isReleased) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    // Resizing would drop or abandon the task of the group.
+    EXPECT_THROW(SetMaxNumberOfThreads(2), std::invalid_argument);
+    EXPECT_THROW(SetIsPinningThreadsToCores(true), std::invalid_argument);
+
+    isReleased = true;
+    group.Wait();
+
+    const unsigned int numThreads = GetMaxNumberOfThreads();
+    SetMaxNumberOfThreads(2);
+    EXPECT_EQ(2u, GetMaxNumberOfThreads());
+    SetMaxNumberOfThreads(numThreads);
+}
+
 TEST(Parallel, Sort) {
     size_t N = std::max(20u, (3 * NumCores) / 2);
     std::vector<double> a(N);
@@ -125,3 +420,190 @@ TEST(Parallel, Sort) {
         EXPECT_LE(c[idx[i]], c[idx[i + 1]]);
     }
 }
+
+TEST(Parallel, RadixSortByKey) {
+    size_t N = std::max(5000u, (3 * NumCores) / 2);
+    std::vector<size_t> keys(N);
+    std::vector<size_t> values(N);
+
+    std::mt19937 rng;
+    std::uniform_int_distribution<size_t> d(0, 70000);
+
+    for (size_t i = 0; i < N; ++i) {
+        keys[i] = d(rng);
+        values[i] = i;
+    }
+
+    std::vector<size_t> originalKeys = keys;
+
+    ParallelRadixSortByKey(keys.begin(), keys.end(), values.begin(), size_t(70000));
+
+    std::vector<size_t> expectedKeys = originalKeys;
+    std::sort(expectedKeys.begin(), expectedKeys.end());
+
+    for (size_t i = 0; i < N; ++i) {
+        EXPECT_EQ(expectedKeys[i], keys[i]);
+        EXPECT_EQ(originalKeys[values[i]], keys[i]);
+        if (i > 0 && keys[i] == keys[i - 1]) {
+            // Stable for equal keys
+            EXPECT_LT(values[i - 1], values[i]);
+        }
+    }
+
+    // Single pass (odd number of passes) and tiny inputs.
+    std::vector<unsigned int> smallKeys = {3, 1, 2, 1, 0};
+    std::vector<char> smallValues = {'d', 'b', 'c', 'B', 'a'};
+    ParallelRadixSortByKey(smallKeys.begin(), smallKeys.end(), smallValues.begin(), 3u);
+
+    EXPECT_EQ(std::vector<unsigned int>({0, 1, 1, 2, 3}), smallKeys);
+    EXPECT_EQ(std::vector<char>({'a', 'b', 'B', 'c', 'd'}), smallValues);
+}
+
+TEST(Parallel, SortException) {
+    std::mt19937 rng;
+    std::uniform_int_distribution<int> d(0, 1000);
+
+    std::vector<int> a(5000);
+    for (int& x : a) {
+        x = d(rng);
+    }
+
+    std::atomic<size_t> numComparisons(0);
+    EXPECT_THROW(ParallelSort(a.begin(), a.end(), [&](int x, int y) {
+        if (++numComparisons == 100)
+            throw std::runtime_error("comparator");
+        return x < y;
+    }, ExecutionPolicy::kParallel), std::runtime_error);
+
+    // The sorts after the failed one still work.
+    for (int iter = 0; iter < 2; ++iter) {
+        std::shuffle(a.begin(), a.end(), rng);
+        ParallelSort(a.begin(), a.end());
+        EXPECT_TRUE(std::is_sorted(a.begin(), a.end()));
+    }
+}
+
+TEST(Parallel, SortWithDuplicatesAndVaryingSizes) {
+    std::mt19937 rng;
+    std::uniform_int_distribution<int> d(0, 50);
+
+    // Repeated calls exercise the reused scratch buffer with growing and
+    // shrinking sizes.
+    for (size_t N : {1000u, 7u, 0u, 1u, 54321u, 100u}) {
+        std::vector<int> a(N);
+        for (size_t i = 0; i < N; ++i) {
+            a[i] = d(rng);
+        }
+
+        std::vector<int> expected = a;
+        std::sort(expected.begin(), expected.end());
+
+        ParallelSort(a.begin(), a.end(), [](int x, int y) {
+            return x > y;
+        });
+        std::reverse(a.begin(), a.end());
+
+        EXPECT_EQ(expected, a) << N;
+    }
+}
+
+TEST(Parallel, ExclusiveScan) {
+    for (size_t N : {0u, 1u, 5u, 1000u, 54321u}) {
+        std::vector<size_t> a(N);
+        for (size_t i = 0; i < N; ++i) {
+            a[i] = i % 7;
+        }
+
+        std::vector<size_t> expected(N);
+        size_t expectedTotal = 3;
+        for (size_t i = 0; i < N; ++i) {
+            expected[i] = expectedTotal;
+            expectedTotal += a[i];
+        }
+
+        std::vector<size_t> b(N);
+        size_t total = ParallelExclusiveScan(a.begin(), a.end(), b.begin(), size_t(3));
+        EXPECT_EQ(expected, b) << N;
+        EXPECT_EQ(expectedTotal, total) << N;
+
+        // In-place
+        total = ParallelExclusiveScan(a.begin(), a.end(), a.begin(), size_t(3));
+        EXPECT_EQ(expected, a) << N;
+        EXPECT_EQ(expectedTotal, total) << N;
+    }
+}
+
+TEST(Parallel, InclusiveScan) {
+    for (size_t N : {0u, 1u, 5u, 1000u, 54321u}) {
+        std::vector<int> a(N);
+        for (size_t i = 0; i < N; ++i) {
+            a[i] = static_cast<int>((i * 31) % 101) - 50;
+        }
+
+        std::vector<int> expected(N);
+        std::vector<int> expectedMax(N);
+        for (size_t i = 0; i < N; ++i) {
+            expected[i] = (i == 0) ? a[i] : expected[i - 1] + a[i];
+            expectedMax[i] = (i == 0) ? a[i] : std::max(expectedMax[i - 1], a[i]);
+        }
+
+        std::vector<int> b(N);
+        ParallelInclusiveScan(a.begin(), a.end(), b.begin(), [](int x, int y) {
+            return std::max(x, y);
+        });
+        EXPECT_EQ(expectedMax, b) << N;
+
+        // In-place
+        ParallelInclusiveScan(a.begin(), a.end(), a.begin());
+        EXPECT_EQ(expected, a) << N;
+    }
+}
+
+TEST(Parallel, Compact) {
+    for (size_t N : {0u, 1u, 5u, 1000u, 54321u}) {
+        std::vector<size_t> a(N);
+        for (size_t i = 0; i < N; ++i) {
+            a[i] = (i * 7919) % 1000;
+        }
+
+        auto isEven = [](size_t x) {
+            return x % 2 == 0;
+        };
+
+        std::vector<size_t> expected;
+        std::copy_if(a.begin(), a.end(), std::back_inserter(expected), isEven);
+
+        std::vector<size_t> b(N);
+        size_t count = ParallelCompact(a.begin(), a.end(), isEven, b.begin());
+        EXPECT_EQ(expected.size(), count) << N;
+
+        b.resize(count);
+        EXPECT_EQ(expected, b) << N;
+    }
+}
+
+TEST(Parallel, Merge) {
+    for (size_t N : {0u, 1u, 5u, 1000u, 54321u}) {
+        for (size_t M : {0u, 3u, 777u, 100000u}) {
+            // Pairs of (value, source) so that the stability can be checked.
+            std::vector<std::pair<size_t, size_t>> a(N), b(M);
+            for (size_t i = 0; i < N; ++i)
+                a[i] = std::make_pair((i * 7919) % 1000, 0);
+            for (size_t i = 0; i < M; ++i)
+                b[i] = std::make_pair((i * 104729) % 500, 1);
+
+            auto lessValue = [](const std::pair<size_t, size_t>& x, const std::pair<size_t, size_t>& y) {
+                return x.first < y.first;
+            };
+            std::sort(a.begin(), a.end(), lessValue);
+            std::sort(b.begin(), b.end(), lessValue);
+
+            std::vector<std::pair<size_t, size_t>> expected(N + M);
+            std::merge(a.begin(), a.end(), b.begin(), b.end(), expected.begin(), lessValue);
+
+            std::vector<std::pair<size_t, size_t>> c(N + M);
+            ParallelMerge(a.begin(), a.end(), b.begin(), b.end(), c.begin(), lessValue);
+            EXPECT_EQ(expected, c) << N << " " << M;
+        }
+    }
+}
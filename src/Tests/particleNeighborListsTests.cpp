@@ -0,0 +1,113 @@
+#include <ParticleSim/particle_neighbor_lists.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+using namespace jet;
+
+namespace
+{
+    // Particle i is connected to the particles j != i with |i - j| <= i % 4.
+    void ForEachTestNeighbor(size_t numberOfParticles, size_t i,
+                             const std::function<void(size_t)>& visit)
+    {
+        const size_t reach = i % 4;
+        const size_t first = i > reach ? i - reach : 0;
+        const size_t last = std::min(i + reach, numberOfParticles - 1);
+        for (size_t j = first; j <= last; ++j)
+        {
+            if (j != i)
+                visit(j);
+        }
+    }
+}
+
+TEST(ParticleNeighborLists, Constructors) {
+    ParticleNeighborLists lists;
+    EXPECT_EQ(0u, lists.Size());
+    EXPECT_EQ(0u, lists.NumberOfNeighbors());
+
+    ParticleNeighborList list;
+    EXPECT_EQ(0u, list.Size());
+    EXPECT_TRUE(list.IsEmpty());
+    EXPECT_EQ(list.begin(), list.end());
+}
+
+TEST(ParticleNeighborLists, Build) {
+    const size_t numberOfParticles = 5000;
+    auto forEachNeighbor = [&](size_t i, const auto& visit) {
+        ForEachTestNeighbor(numberOfParticles, i, visit);
+    };
+
+    for (ExecutionPolicy policy : {ExecutionPolicy::kSerial, ExecutionPolicy::kParallel}) {
+        ParticleNeighborLists lists;
+        lists.Build(numberOfParticles, forEachNeighbor, policy);
+
+        ASSERT_EQ(numberOfParticles, lists.Size());
+        ASSERT_EQ(numberOfParticles + 1, lists.Offsets().size());
+        EXPECT_EQ(0u, lists.Offsets().front());
+        EXPECT_EQ(lists.NumberOfNeighbors(), lists.Offsets().back());
+        EXPECT_EQ(lists.NumberOfNeighbors(), lists.Indices().size());
+
+        for (size_t i = 0; i < numberOfParticles; ++i) {
+            std::vector<size_t> expected;
+            ForEachTestNeighbor(numberOfParticles, i, [&](size_t j) { expected.push_back(j); });
+
+            const auto neighbors = lists[i];
+            ASSERT_EQ(expected.size(), neighbors.Size());
+            EXPECT_EQ(lists.Indices().data() + lists.Offsets()[i], neighbors.begin());
+            for (size_t k = 0; k < expected.size(); ++k) {
+                EXPECT_EQ(expected[k], neighbors[k]);
+            }
+        }
+    }
+
+    // Rebuilding with fewer particles shrinks the lists.
+    ParticleNeighborLists lists;
+    lists.Build(numberOfParticles, forEachNeighbor);
+    lists.Build(3, [](size_t i, const auto& visit) { visit((i + 1) % 3); });
+    ASSERT_EQ(3u, lists.Size());
+    EXPECT_EQ(3u, lists.NumberOfNeighbors());
+    EXPECT_EQ(2u, lists[1][0]);
+
+    lists.Clear();
+    EXPECT_EQ(0u, lists.Size());
+}
+
+TEST(ParticleNeighborLists, AccumulatePairs) {
+    // Nearby neighbors plus a far one, so that some batches span most of
+    // the particles. The calls reuse the buffers with varying sizes.
+    for (size_t numberOfParticles : {5000u, 3u, 20000u, 0u, 700u}) {
+        ParticleNeighborLists lists;
+        lists.Build(numberOfParticles, [&](size_t i, const auto& visit) {
+            ForEachTestNeighbor(numberOfParticles, i, visit);
+            if (i % 97 == 0 && numberOfParticles > 1)
+                visit(numberOfParticles - 1 - i % (numberOfParticles - 1));
+        });
+
+        auto pairFunc = [](size_t i, size_t j, double& resultI, double& resultJ) {
+            resultI += static_cast<double>(j);
+            resultJ += static_cast<double>(i + 1);
+        };
+
+        std::vector<double> serial(numberOfParticles, 1.0);
+        std::vector<double> parallel(numberOfParticles, 1.0);
+        lists.AccumulatePairs(ArrayAccessor1<double>(numberOfParticles, serial.data()),
+                              pairFunc, ExecutionPolicy::kSerial);
+        lists.AccumulatePairs(ArrayAccessor1<double>(numberOfParticles, parallel.data()),
+                              pairFunc, ExecutionPolicy::kParallel);
+
+        std::vector<double> expected(numberOfParticles, 1.0);
+        for (size_t i = 0; i < numberOfParticles; ++i) {
+            for (size_t j : lists[i]) {
+                expected[i] += static_cast<double>(j);
+                expected[j] += static_cast<double>(i + 1);
+            }
+        }
+
+        EXPECT_EQ(expected, serial);
+        EXPECT_EQ(expected, parallel);
+    }
+}
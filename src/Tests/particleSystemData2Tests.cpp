@@ -1,5 +1,7 @@
+#include <NeighborhoodSearch/point2_parallel_hash_grid_search.h>
 #include <ParticleSim/particle_system_data2.h>
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <vector>
 
 using namespace jet;
@@ -108,6 +110,81 @@ TEST(ParticleSystemData2, AddParticles) {
     EXPECT_EQ(Vector2D(2.0, 1.0), f[13]);
 }
 
+TEST(ParticleSystemData2, AddParticleGrowth) {
+    ParticleSystemData2 particleSystem;
+    size_t scalarIdx = particleSystem.AddScalarData(5.0);
+    size_t vectorIdx = particleSystem.AddVectorData();
+
+    // The capacity of every layer doubles, so it only changes a few times.
+    size_t numCapacityChanges = 0;
+    size_t capacity = particleSystem.Capacity();
+    for (size_t i = 0; i < 1000; ++i) {
+        const double x = static_cast<double>(i);
+        particleSystem.AddParticle(Vector2D(1.0, 2.0) * x, Vector2D(1.0, 2.0) * 2.0 * x);
+        if (particleSystem.Capacity() != capacity) {
+            capacity = particleSystem.Capacity();
+            ++numCapacityChanges;
+        }
+    }
+
+    ASSERT_EQ(1000u, particleSystem.NumberOfParticles());
+    EXPECT_LE(1000u, particleSystem.Capacity());
+    EXPECT_GE(11u, numCapacityChanges);
+    EXPECT_EQ(1000u, particleSystem.ScalarDataAt(scalarIdx).Size());
+    EXPECT_EQ(1000u, particleSystem.VectorDataAt(vectorIdx).Size());
+
+    for (size_t i = 0; i < 1000; ++i) {
+        const double x = static_cast<double>(i);
+        EXPECT_EQ(Vector2D(1.0, 2.0) * x, particleSystem.Positions()[i]);
+        EXPECT_EQ(Vector2D(1.0, 2.0) * 2.0 * x, particleSystem.Velocities()[i]);
+        EXPECT_EQ(Vector2D(), particleSystem.Forces()[i]);
+        EXPECT_EQ(0.0, particleSystem.ScalarDataAt(scalarIdx)[i]);
+        EXPECT_EQ(Vector2D(), particleSystem.VectorDataAt(vectorIdx)[i]);
+    }
+
+    // Reserved particles are added without reallocation.
+    particleSystem.Reserve(2000);
+    EXPECT_LE(2000u, particleSystem.Capacity());
+    const Vector2D* positions = particleSystem.Positions().Data();
+    Array1<Vector2D> newPositions(1000, Vector2D(1.0, 2.0));
+    particleSystem.AddParticles(newPositions);
+    ASSERT_EQ(2000u, particleSystem.NumberOfParticles());
+    EXPECT_EQ(positions, particleSystem.Positions().Data());
+    EXPECT_EQ(Vector2D(1.0, 2.0), particleSystem.Positions()[1999]);
+    EXPECT_EQ(Vector2D(), particleSystem.Velocities()[1999]);
+}
+
+TEST(ParticleSystemData2, SwapNewPositionsAndVelocities) {
+    ParticleSystemData2 particleSystem;
+    particleSystem.AddParticles(Array1<Vector2D>({Vector2D(1.0, 2.0), Vector2D(3.0, 4.0)}),
+                                Array1<Vector2D>({Vector2D(5.0, 6.0), Vector2D(7.0, 8.0)}));
+
+    auto newPositions = particleSystem.NewPositions();
+    auto newVelocities = particleSystem.NewVelocities();
+    ASSERT_EQ(2u, newPositions.Size());
+    ASSERT_EQ(2u, newVelocities.Size());
+    newPositions[0] = Vector2D(-1.0, -2.0);
+    newPositions[1] = Vector2D(-3.0, -4.0);
+    newVelocities[0] = Vector2D(-5.0, -6.0);
+    newVelocities[1] = Vector2D(-7.0, -8.0);
+
+    const Vector2D* backPositions = newPositions.Data();
+    particleSystem.SwapNewPositionsAndVelocities();
+
+    // The buffers are exchanged, not copied.
+    EXPECT_EQ(backPositions, particleSystem.Positions().Data());
+    EXPECT_EQ(Vector2D(-3.0, -4.0), particleSystem.Positions()[1]);
+    EXPECT_EQ(Vector2D(-5.0, -6.0), particleSystem.Velocities()[0]);
+    EXPECT_EQ(Vector2D(1.0, 2.0), particleSystem.NewPositions()[0]);
+    EXPECT_EQ(Vector2D(7.0, 8.0), particleSystem.NewVelocities()[1]);
+
+    // The back buffers follow the number of particles.
+    particleSystem.AddParticle(Vector2D(9.0, 9.0));
+    EXPECT_THROW(particleSystem.SwapNewPositionsAndVelocities(), std::invalid_argument);
+    EXPECT_EQ(3u, particleSystem.NewPositions().Size());
+    EXPECT_EQ(3u, particleSystem.NewVelocities().Size());
+}
+
 TEST(ParticleSystemData2, AddParticlesException) {
     ParticleSystemData2 particleSystem;
     particleSystem.Resize(12);
@@ -194,6 +271,63 @@ TEST(ParticleSystemData2, BuildNeighborSearcher) {
     }
 }
 
+TEST(ParticleSystemData2, BuildNeighborSearchResolution) {
+    // A row of particles much longer than the former fixed 64 buckets.
+    ParticleSystemData2 particleSystem;
+    ParticleSystemData2::VectorData positions(1000);
+    for (size_t i = 0; i < positions.Size(); ++i) {
+        positions[i] = Vector2D(0.02 * i, 0.05 * (i % 3));
+    }
+    particleSystem.AddParticles(positions);
+
+    EXPECT_EQ(positions[0], particleSystem.ComputeBoundingBox().LowerCorner);
+
+    particleSystem.BuildNeighborSearch(0.05);
+    auto searcher = std::dynamic_pointer_cast<PointParallelHashGridSearch2>(
+        particleSystem.NeighborSearch());
+    ASSERT_NE(nullptr, searcher);
+
+    const HashGridStatistics& statistics = searcher->Statistics();
+    EXPECT_EQ(positions.Size(), statistics.NumberOfPoints);
+    EXPECT_LE(statistics.NumberOfBuckets, positions.Size());
+    EXPECT_EQ(0u, statistics.NumberOfCollidingBuckets);
+}
+
+TEST(ParticleSystemData2, BuildNeighborSearchUpdate) {
+    ParticleSystemData2 particleSystem;
+    ParticleSystemData2::VectorData positions(1000);
+    for (size_t i = 0; i < positions.Size(); ++i) {
+        positions[i] = Vector2D(0.02 * (i % 40), 0.02 * (i / 40));
+    }
+    particleSystem.AddParticles(positions);
+
+    particleSystem.BuildNeighborSearch(0.05);
+    auto searcher = particleSystem.NeighborSearch();
+
+    // Moving the particles without changing the bounds updates the same
+    // hash grid.
+    auto particlePositions = particleSystem.Positions();
+    for (size_t i = 1; i < particlePositions.Size(); ++i) {
+        if (particlePositions[i].x < 0.75 && particlePositions[i].y < 0.45)
+            particlePositions[i] += Vector2D(0.013, 0.007);
+    }
+
+    particleSystem.BuildNeighborSearch(0.05);
+    EXPECT_EQ(searcher, particleSystem.NeighborSearch());
+
+    auto hashGrid = std::dynamic_pointer_cast<PointParallelHashGridSearch2>(searcher);
+    ASSERT_NE(nullptr, hashGrid);
+    PointParallelHashGridSearch2 expected(hashGrid->Resolution(), hashGrid->GridSpacing());
+    expected.Build(particlePositions);
+    EXPECT_EQ(expected.SortedIndices(), hashGrid->SortedIndices());
+    EXPECT_EQ(expected.StartIndexTable(), hashGrid->StartIndexTable());
+
+    // A different number of particles builds a new one.
+    particleSystem.AddParticles(ParticleSystemData2::VectorData(1, Vector2D(0.5, 0.5)));
+    particleSystem.BuildNeighborSearch(0.05);
+    EXPECT_NE(searcher, particleSystem.NeighborSearch());
+}
+
 TEST(ParticleSystemData2, BuildNeighborLists) {
     ParticleSystemData2 particleSystem;
     ParticleSystemData2::VectorData positions = {
@@ -225,10 +359,10 @@ TEST(ParticleSystemData2, BuildNeighborLists) {
     particleSystem.BuildNeighborLists(radius);
 
     const auto& neighborLists = particleSystem.NeighborLists();
-    EXPECT_EQ(positions.Size(), neighborLists.size());
+    EXPECT_EQ(positions.Size(), neighborLists.Size());
 
-    for (size_t i = 0; i < neighborLists.size(); ++i) {
-        const auto& neighbors = neighborLists[i];
+    for (size_t i = 0; i < neighborLists.Size(); ++i) {
+        const auto neighbors = neighborLists[i];
         for (size_t ii = 0; ii < positions.Size(); ++ii) {
             if (ii != i && positions[ii].DistanceTo(positions[i]) <= radius) {
                 EXPECT_TRUE(
@@ -239,6 +373,235 @@ TEST(ParticleSystemData2, BuildNeighborLists) {
     }
 }
 
+TEST(ParticleSystemData2, BuildHalfNeighborLists) {
+    ParticleSystemData2 particleSystem;
+    ParticleSystemData2::VectorData positions(500);
+    for (size_t i = 0; i < positions.Size(); ++i) {
+        positions[i] = Vector2D((37 * i) % 100 * 0.01, 0.02 * ((53 * i) % 50));
+    }
+    particleSystem.AddParticles(positions);
+
+    // The half lists are only built on request.
+    particleSystem.BuildNeighborLists(0.05);
+    EXPECT_EQ(0u, particleSystem.HalfNeighborLists().Size());
+
+    particleSystem.BuildHalfNeighborLists();
+    const auto& lists = particleSystem.NeighborLists();
+    const auto& halfLists = particleSystem.HalfNeighborLists();
+    ASSERT_EQ(lists.Size(), halfLists.Size());
+    EXPECT_EQ(lists.NumberOfNeighbors(), 2 * halfLists.NumberOfNeighbors());
+    for (size_t i = 0; i < halfLists.Size(); ++i) {
+        for (size_t j : halfLists[i]) {
+            EXPECT_LT(i, j);
+        }
+    }
+
+    particleSystem.BuildNeighborLists(0.05);
+    EXPECT_EQ(0u, particleSystem.HalfNeighborLists().Size());
+}
+
+TEST(ParticleSystemData2, BuildVerletNeighborLists) {
+    ParticleSystemData2 particleSystem;
+    ParticleSystemData2::VectorData positions(400);
+    for (size_t i = 0; i < positions.Size(); ++i) {
+        positions[i] = Vector2D(0.05 * (i % 20), 0.05 * (i / 20));
+    }
+    particleSystem.AddParticles(positions);
+
+    const double radius = 0.12;
+    const double skin = 0.04;
+
+    auto checkNeighbors = [&]() {
+        auto x = particleSystem.Positions();
+        const auto& neighborLists = particleSystem.NeighborLists();
+        ASSERT_EQ(x.Size(), neighborLists.Size());
+        for (size_t i = 0; i < x.Size(); ++i) {
+            const auto neighbors = neighborLists[i];
+            for (size_t j = 0; j < x.Size(); ++j) {
+                if (j != i && x[i].DistanceTo(x[j]) <= radius) {
+                    EXPECT_TRUE(
+                        neighbors.end()
+                        != std::find(neighbors.begin(), neighbors.end(), j));
+                }
+            }
+        }
+    };
+
+    particleSystem.BuildNeighborLists(radius, skin);
+    EXPECT_EQ(1u, particleSystem.NumberOfNeighborListBuilds());
+    EXPECT_EQ(0u, particleSystem.NumberOfNeighborListReuses());
+    checkNeighbors();
+
+    // Moving less than half the skin radius keeps the lists.
+    auto x = particleSystem.Positions();
+    for (size_t i = 0; i < x.Size(); i += 2) {
+        x[i] += Vector2D(0.015, -0.01);
+    }
+    particleSystem.BuildNeighborLists(radius, skin);
+    EXPECT_EQ(1u, particleSystem.NumberOfNeighborListBuilds());
+    EXPECT_EQ(1u, particleSystem.NumberOfNeighborListReuses());
+    checkNeighbors();
+
+    // Moving further rebuilds them.
+    x[7] += Vector2D(0.03, 0.0);
+    particleSystem.BuildNeighborLists(radius, skin);
+    EXPECT_EQ(2u, particleSystem.NumberOfNeighborListBuilds());
+    EXPECT_EQ(1u, particleSystem.NumberOfNeighborListReuses());
+    checkNeighbors();
+
+    // So do new particles, other radii and explicit invalidation.
+    particleSystem.AddParticles(ParticleSystemData2::VectorData({{0.5, 0.5}}));
+    particleSystem.BuildNeighborLists(radius, skin);
+    EXPECT_EQ(3u, particleSystem.NumberOfNeighborListBuilds());
+    checkNeighbors();
+
+    particleSystem.BuildNeighborLists(radius, 0.5 * skin);
+    EXPECT_EQ(4u, particleSystem.NumberOfNeighborListBuilds());
+
+    particleSystem.InvalidateNeighborLists();
+    particleSystem.BuildNeighborLists(radius, 0.5 * skin);
+    EXPECT_EQ(5u, particleSystem.NumberOfNeighborListBuilds());
+    EXPECT_EQ(1u, particleSystem.NumberOfNeighborListReuses());
+}
+
+TEST(ParticleSystemData2, ReorderBySpatialKey) {
+    ParticleSystemData2 particleSystem;
+    size_t scalarIdx = particleSystem.AddScalarData();
+    size_t vectorIdx = particleSystem.AddVectorData();
+
+    ParticleSystemData2::VectorData positions(1000);
+    for (size_t i = 0; i < positions.Size(); ++i) {
+        positions[i] = Vector2D((37 * i) % 200 * 0.01, 0.05 * ((53 * i) % 100));
+    }
+    particleSystem.AddParticles(positions);
+
+    // Tag every particle with its original index.
+    auto scalars = particleSystem.ScalarDataAt(scalarIdx);
+    auto velocities = particleSystem.Velocities();
+    for (size_t i = 0; i < positions.Size(); ++i) {
+        scalars[i] = static_cast<double>(i);
+        velocities[i] = positions[i] * 2.0;
+        particleSystem.VectorDataAt(vectorIdx)[i] = positions[i] * 3.0;
+    }
+
+    particleSystem.BuildNeighborSearch(0.1);
+    particleSystem.BuildNeighborLists(0.1);
+
+    std::vector<size_t> newIndices;
+    particleSystem.SetReorderCallback([&](ConstArrayAccessor1<size_t> indices) {
+        newIndices.assign(indices.begin(), indices.end());
+    });
+    particleSystem.ReorderBySpatialKey();
+
+    ASSERT_EQ(positions.Size(), particleSystem.NumberOfParticles());
+    ASSERT_EQ(positions.Size(), newIndices.size());
+    EXPECT_EQ(0u, particleSystem.NeighborLists().Size());
+
+    // Every layer is permuted the same way and the callback reports it.
+    std::vector<bool> visited(positions.Size(), false);
+    auto x = particleSystem.Positions();
+    for (size_t i = 0; i < positions.Size(); ++i) {
+        size_t oldIndex = static_cast<size_t>(particleSystem.ScalarDataAt(scalarIdx)[i]);
+        ASSERT_LT(oldIndex, positions.Size());
+        EXPECT_FALSE(visited[oldIndex]);
+        visited[oldIndex] = true;
+
+        EXPECT_EQ(i, newIndices[oldIndex]);
+        EXPECT_EQ(positions[oldIndex], x[i]);
+        EXPECT_EQ(positions[oldIndex] * 2.0, particleSystem.Velocities()[i]);
+        EXPECT_EQ(positions[oldIndex] * 3.0, particleSystem.VectorDataAt(vectorIdx)[i]);
+    }
+
+    // Consecutive particles are closer to each other along the curve.
+    double distanceBefore = 0.0;
+    double distanceAfter = 0.0;
+    for (size_t i = 1; i < positions.Size(); ++i) {
+        distanceBefore += positions[i].DistanceTo(positions[i - 1]);
+        distanceAfter += x[i].DistanceTo(x[i - 1]);
+    }
+    EXPECT_LT(distanceAfter, 0.25 * distanceBefore);
+
+    // Reordering twice keeps the order.
+    particleSystem.ReorderBySpatialKey();
+    for (size_t i = 0; i < newIndices.size(); ++i) {
+        EXPECT_EQ(i, newIndices[i]);
+    }
+}
+
+TEST(ParticleSystemData2, RemoveParticles) {
+    ParticleSystemData2 particleSystem;
+    size_t scalarIdx = particleSystem.AddScalarData();
+    size_t vectorIdx = particleSystem.AddVectorData();
+
+    ParticleSystemData2::VectorData positions(1000);
+    for (size_t i = 0; i < positions.Size(); ++i) {
+        positions[i] = Vector2D((37 * i) % 200 * 0.01, 0.05 * ((53 * i) % 100));
+    }
+    particleSystem.AddParticles(positions);
+
+    for (size_t i = 0; i < positions.Size(); ++i) {
+        particleSystem.ScalarDataAt(scalarIdx)[i] = static_cast<double>(i);
+        particleSystem.VectorDataAt(vectorIdx)[i] = positions[i] * 3.0;
+    }
+
+    particleSystem.BuildNeighborSearch(0.1);
+    particleSystem.BuildNeighborLists(0.1);
+
+    std::vector<size_t> newIndices = particleSystem.RemoveParticles(
+            [](size_t i) { return i % 3 == 1; });
+
+    ASSERT_EQ(positions.Size(), newIndices.size());
+    ASSERT_EQ(667u, particleSystem.NumberOfParticles());
+    EXPECT_EQ(0u, particleSystem.NeighborLists().Size());
+
+    // The kept particles are compacted in order, with every layer.
+    size_t next = 0;
+    for (size_t i = 0; i < positions.Size(); ++i) {
+        if (i % 3 == 1) {
+            EXPECT_EQ(kMaxSize, newIndices[i]);
+            continue;
+        }
+
+        ASSERT_EQ(next, newIndices[i]);
+        EXPECT_EQ(positions[i], particleSystem.Positions()[next]);
+        EXPECT_EQ(static_cast<double>(i), particleSystem.ScalarDataAt(scalarIdx)[next]);
+        EXPECT_EQ(positions[i] * 3.0, particleSystem.VectorDataAt(vectorIdx)[next]);
+        ++next;
+    }
+
+    // The hash grid is remapped to the new indices.
+    auto searcher = particleSystem.NeighborSearch();
+    PointParallelHashGridSearch2 grid(
+            std::dynamic_pointer_cast<PointParallelHashGridSearch2>(searcher)->Resolution(), 0.2);
+    grid.Build(particleSystem.Positions());
+
+    const Vector2D origin = positions[500];
+    std::vector<size_t> found, expected;
+    searcher->ForEachNearbyPoint(origin, 0.1, [&](size_t j, const Vector2D&) { found.push_back(j); });
+    grid.ForEachNearbyPoint(origin, 0.1, [&](size_t j, const Vector2D&) { expected.push_back(j); });
+    std::sort(found.begin(), found.end());
+    std::sort(expected.begin(), expected.end());
+    EXPECT_FALSE(expected.empty());
+    EXPECT_EQ(expected, found);
+
+    // Removing by index, with a duplicate, then nothing.
+    Array1<size_t> indices = {0, 666, 0};
+    newIndices = particleSystem.RemoveParticles(indices);
+    ASSERT_EQ(665u, particleSystem.NumberOfParticles());
+    EXPECT_EQ(kMaxSize, newIndices[0]);
+    EXPECT_EQ(0u, newIndices[1]);
+    EXPECT_EQ(kMaxSize, newIndices[666]);
+    EXPECT_EQ(positions[2], particleSystem.Positions()[0]);
+
+    newIndices = particleSystem.RemoveParticles([](size_t) { return false; });
+    ASSERT_EQ(665u, particleSystem.NumberOfParticles());
+    for (size_t i = 0; i < newIndices.size(); ++i) {
+        EXPECT_EQ(i, newIndices[i]);
+    }
+
+    EXPECT_THROW(particleSystem.RemoveParticles(Array1<size_t>({665})), std::invalid_argument);
+}
+
 TEST(ParticleSystemData2, Serialization) 
 {
     ParticleSystemData2 particleSystem;
@@ -300,14 +663,14 @@ TEST(ParticleSystemData2, Serialization)
 
     const auto& neighborLists = particleSystem.NeighborLists();
     const auto& neighborLists2 = particleSystem2.NeighborLists();
-    EXPECT_EQ(neighborLists.size(), neighborLists2.size());
+    EXPECT_EQ(neighborLists.Size(), neighborLists2.Size());
 
-    for (size_t i = 0; i < neighborLists.size(); ++i) {
-        const auto& neighbors = neighborLists[i];
-        const auto& neighbors2 = neighborLists2[i];
-        EXPECT_EQ(neighbors.size(), neighbors2.size());
+    for (size_t i = 0; i < neighborLists.Size(); ++i) {
+        const auto neighbors = neighborLists[i];
+        const auto neighbors2 = neighborLists2[i];
+        EXPECT_EQ(neighbors.Size(), neighbors2.Size());
 
-        for (size_t j = 0; j < neighbors.size(); ++j) {
+        for (size_t j = 0; j < neighbors.Size(); ++j) {
             EXPECT_EQ(neighbors[j], neighbors2[j]);
         }
     }
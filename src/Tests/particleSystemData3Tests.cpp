@@ -1,5 +1,7 @@
+#include <NeighborhoodSearch/point3_parallel_hash_grid_search.h>
 #include <ParticleSim/particle_system_data3.h>
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <vector>
 
 using namespace jet;
@@ -111,6 +113,50 @@ TEST(ParticleSystemData3, AddParticles) {
     EXPECT_EQ(Vector3D(2.0, 1.0, 3.0), f[13]);
 }
 
+TEST(ParticleSystemData3, AddParticleGrowth) {
+    ParticleSystemData3 particleSystem;
+    size_t scalarIdx = particleSystem.AddScalarData(5.0);
+    size_t vectorIdx = particleSystem.AddVectorData();
+
+    // The capacity of every layer doubles, so it only changes a few times.
+    size_t numCapacityChanges = 0;
+    size_t capacity = particleSystem.Capacity();
+    for (size_t i = 0; i < 1000; ++i) {
+        const double x = static_cast<double>(i);
+        particleSystem.AddParticle(Vector3D(1.0, 2.0, 3.0) * x, Vector3D(1.0, 2.0, 3.0) * 2.0 * x);
+        if (particleSystem.Capacity() != capacity) {
+            capacity = particleSystem.Capacity();
+            ++numCapacityChanges;
+        }
+    }
+
+    ASSERT_EQ(1000u, particleSystem.NumberOfParticles());
+    EXPECT_LE(1000u, particleSystem.Capacity());
+    EXPECT_GE(11u, numCapacityChanges);
+    EXPECT_EQ(1000u, particleSystem.ScalarDataAt(scalarIdx).Size());
+    EXPECT_EQ(1000u, particleSystem.VectorDataAt(vectorIdx).Size());
+
+    for (size_t i = 0; i < 1000; ++i) {
+        const double x = static_cast<double>(i);
+        EXPECT_EQ(Vector3D(1.0, 2.0, 3.0) * x, particleSystem.Positions()[i]);
+        EXPECT_EQ(Vector3D(1.0, 2.0, 3.0) * 2.0 * x, particleSystem.Velocities()[i]);
+        EXPECT_EQ(Vector3D(), particleSystem.Forces()[i]);
+        EXPECT_EQ(0.0, particleSystem.ScalarDataAt(scalarIdx)[i]);
+        EXPECT_EQ(Vector3D(), particleSystem.VectorDataAt(vectorIdx)[i]);
+    }
+
+    // Reserved particles are added without reallocation.
+    particleSystem.Reserve(2000);
+    EXPECT_LE(2000u, particleSystem.Capacity());
+    const Vector3D* positions = particleSystem.Positions().Data();
+    Array1<Vector3D> newPositions(1000, Vector3D(1.0, 2.0, 3.0));
+    particleSystem.AddParticles(newPositions);
+    ASSERT_EQ(2000u, particleSystem.NumberOfParticles());
+    EXPECT_EQ(positions, particleSystem.Positions().Data());
+    EXPECT_EQ(Vector3D(1.0, 2.0, 3.0), particleSystem.Positions()[1999]);
+    EXPECT_EQ(Vector3D(), particleSystem.Velocities()[1999]);
+}
+
 TEST(ParticleSystemData3, AddParticlesException) {
     ParticleSystemData3 particleSystem;
     particleSystem.Resize(12);
@@ -197,6 +243,28 @@ TEST(ParticleSystemData3, BuildNeighborSearcher) {
     }
 }
 
+TEST(ParticleSystemData3, BuildNeighborSearchResolution) {
+    // A row of particles much longer than the former fixed 64 buckets.
+    ParticleSystemData3 particleSystem;
+    ParticleSystemData3::VectorData positions(1000);
+    for (size_t i = 0; i < positions.Size(); ++i) {
+        positions[i] = Vector3D(0.02 * i, 0.05 * (i % 3), 0.0);
+    }
+    particleSystem.AddParticles(positions);
+
+    EXPECT_EQ(positions[0], particleSystem.ComputeBoundingBox().LowerCorner);
+
+    particleSystem.BuildNeighborSearch(0.05);
+    auto searcher = std::dynamic_pointer_cast<PointParallelHashGridSearch3>(
+        particleSystem.NeighborSearch());
+    ASSERT_NE(nullptr, searcher);
+
+    const HashGridStatistics& statistics = searcher->Statistics();
+    EXPECT_EQ(positions.Size(), statistics.NumberOfPoints);
+    EXPECT_LE(statistics.NumberOfBuckets, positions.Size());
+    EXPECT_EQ(0u, statistics.NumberOfCollidingBuckets);
+}
+
 TEST(ParticleSystemData3, BuildNeighborLists) {
     ParticleSystemData3 particleSystem;
     ParticleSystemData3::VectorData positions = {
@@ -228,10 +296,10 @@ TEST(ParticleSystemData3, BuildNeighborLists) {
     particleSystem.BuildNeighborLists(radius);
 
     const auto& neighborLists = particleSystem.NeighborLists();
-    EXPECT_EQ(positions.Size(), neighborLists.size());
+    EXPECT_EQ(positions.Size(), neighborLists.Size());
 
-    for (size_t i = 0; i < neighborLists.size(); ++i) {
-        const auto& neighbors = neighborLists[i];
+    for (size_t i = 0; i < neighborLists.Size(); ++i) {
+        const auto neighbors = neighborLists[i];
         for (size_t ii = 0; ii < positions.Size(); ++ii) {
             if (ii != i && positions[ii].DistanceTo(positions[i]) <= radius) {
                 EXPECT_TRUE(
@@ -242,6 +310,144 @@ TEST(ParticleSystemData3, BuildNeighborLists) {
     }
 }
 
+TEST(ParticleSystemData3, ReorderBySpatialKey) {
+    ParticleSystemData3 particleSystem;
+    size_t scalarIdx = particleSystem.AddScalarData();
+    size_t vectorIdx = particleSystem.AddVectorData();
+
+    ParticleSystemData3::VectorData positions(1000);
+    for (size_t i = 0; i < positions.Size(); ++i) {
+        positions[i] = Vector3D((37 * i) % 200 * 0.01, 0.05 * ((53 * i) % 100), 0.1 * (i % 7));
+    }
+    particleSystem.AddParticles(positions);
+
+    // Tag every particle with its original index.
+    auto scalars = particleSystem.ScalarDataAt(scalarIdx);
+    auto velocities = particleSystem.Velocities();
+    for (size_t i = 0; i < positions.Size(); ++i) {
+        scalars[i] = static_cast<double>(i);
+        velocities[i] = positions[i] * 2.0;
+        particleSystem.VectorDataAt(vectorIdx)[i] = positions[i] * 3.0;
+    }
+
+    particleSystem.BuildNeighborSearch(0.1);
+    particleSystem.BuildNeighborLists(0.1);
+
+    std::vector<size_t> newIndices;
+    particleSystem.SetReorderCallback([&](ConstArrayAccessor1<size_t> indices) {
+        newIndices.assign(indices.begin(), indices.end());
+    });
+    particleSystem.ReorderBySpatialKey();
+
+    ASSERT_EQ(positions.Size(), particleSystem.NumberOfParticles());
+    ASSERT_EQ(positions.Size(), newIndices.size());
+    EXPECT_EQ(0u, particleSystem.NeighborLists().Size());
+
+    // Every layer is permuted the same way and the callback reports it.
+    std::vector<bool> visited(positions.Size(), false);
+    auto x = particleSystem.Positions();
+    for (size_t i = 0; i < positions.Size(); ++i) {
+        size_t oldIndex = static_cast<size_t>(particleSystem.ScalarDataAt(scalarIdx)[i]);
+        ASSERT_LT(oldIndex, positions.Size());
+        EXPECT_FALSE(visited[oldIndex]);
+        visited[oldIndex] = true;
+
+        EXPECT_EQ(i, newIndices[oldIndex]);
+        EXPECT_EQ(positions[oldIndex], x[i]);
+        EXPECT_EQ(positions[oldIndex] * 2.0, particleSystem.Velocities()[i]);
+        EXPECT_EQ(positions[oldIndex] * 3.0, particleSystem.VectorDataAt(vectorIdx)[i]);
+    }
+
+    // Consecutive particles are closer to each other along the curve.
+    double distanceBefore = 0.0;
+    double distanceAfter = 0.0;
+    for (size_t i = 1; i < positions.Size(); ++i) {
+        distanceBefore += positions[i].DistanceTo(positions[i - 1]);
+        distanceAfter += x[i].DistanceTo(x[i - 1]);
+    }
+    EXPECT_LT(distanceAfter, 0.25 * distanceBefore);
+
+    // Reordering twice keeps the order.
+    particleSystem.ReorderBySpatialKey();
+    for (size_t i = 0; i < newIndices.size(); ++i) {
+        EXPECT_EQ(i, newIndices[i]);
+    }
+}
+
+TEST(ParticleSystemData3, RemoveParticles) {
+    ParticleSystemData3 particleSystem;
+    size_t scalarIdx = particleSystem.AddScalarData();
+    size_t vectorIdx = particleSystem.AddVectorData();
+
+    ParticleSystemData3::VectorData positions(1000);
+    for (size_t i = 0; i < positions.Size(); ++i) {
+        positions[i] = Vector3D((37 * i) % 200 * 0.01, 0.05 * ((53 * i) % 100), 0.02 * ((71 * i) % 50));
+    }
+    particleSystem.AddParticles(positions);
+
+    for (size_t i = 0; i < positions.Size(); ++i) {
+        particleSystem.ScalarDataAt(scalarIdx)[i] = static_cast<double>(i);
+        particleSystem.VectorDataAt(vectorIdx)[i] = positions[i] * 3.0;
+    }
+
+    particleSystem.BuildNeighborSearch(0.1);
+    particleSystem.BuildNeighborLists(0.1);
+
+    std::vector<size_t> newIndices = particleSystem.RemoveParticles(
+            [](size_t i) { return i % 3 == 1; });
+
+    ASSERT_EQ(positions.Size(), newIndices.size());
+    ASSERT_EQ(667u, particleSystem.NumberOfParticles());
+    EXPECT_EQ(0u, particleSystem.NeighborLists().Size());
+
+    // The kept particles are compacted in order, with every layer.
+    size_t next = 0;
+    for (size_t i = 0; i < positions.Size(); ++i) {
+        if (i % 3 == 1) {
+            EXPECT_EQ(kMaxSize, newIndices[i]);
+            continue;
+        }
+
+        ASSERT_EQ(next, newIndices[i]);
+        EXPECT_EQ(positions[i], particleSystem.Positions()[next]);
+        EXPECT_EQ(static_cast<double>(i), particleSystem.ScalarDataAt(scalarIdx)[next]);
+        EXPECT_EQ(positions[i] * 3.0, particleSystem.VectorDataAt(vectorIdx)[next]);
+        ++next;
+    }
+
+    // The hash grid is remapped to the new indices.
+    auto searcher = particleSystem.NeighborSearch();
+    PointParallelHashGridSearch3 grid(
+            std::dynamic_pointer_cast<PointParallelHashGridSearch3>(searcher)->Resolution(), 0.2);
+    grid.Build(particleSystem.Positions());
+
+    const Vector3D origin = positions[500];
+    std::vector<size_t> found, expected;
+    searcher->ForEachNearbyPoint(origin, 0.1, [&](size_t j, const Vector3D&) { found.push_back(j); });
+    grid.ForEachNearbyPoint(origin, 0.1, [&](size_t j, const Vector3D&) { expected.push_back(j); });
+    std::sort(found.begin(), found.end());
+    std::sort(expected.begin(), expected.end());
+    EXPECT_FALSE(expected.empty());
+    EXPECT_EQ(expected, found);
+
+    // Removing by index, with a duplicate, then nothing.
+    Array1<size_t> indices = {0, 666, 0};
+    newIndices = particleSystem.RemoveParticles(indices);
+    ASSERT_EQ(665u, particleSystem.NumberOfParticles());
+    EXPECT_EQ(kMaxSize, newIndices[0]);
+    EXPECT_EQ(0u, newIndices[1]);
+    EXPECT_EQ(kMaxSize, newIndices[666]);
+    EXPECT_EQ(positions[2], particleSystem.Positions()[0]);
+
+    newIndices = particleSystem.RemoveParticles([](size_t) { return false; });
+    ASSERT_EQ(665u, particleSystem.NumberOfParticles());
+    for (size_t i = 0; i < newIndices.size(); ++i) {
+        EXPECT_EQ(i, newIndices[i]);
+    }
+
+    EXPECT_THROW(particleSystem.RemoveParticles(Array1<size_t>({665})), std::invalid_argument);
+}
+
 TEST(ParticleSystemData3, Serialization) {
     ParticleSystemData3 particleSystem;
 
@@ -303,14 +509,14 @@ TEST(ParticleSystemData3, Serialization) {
 
     const auto& neighborLists = particleSystem.NeighborLists();
     const auto& neighborLists2 = particleSystem2.NeighborLists();
-    EXPECT_EQ(neighborLists.size(), neighborLists2.size());
+    EXPECT_EQ(neighborLists.Size(), neighborLists2.Size());
 
-    for (size_t i = 0; i < neighborLists.size(); ++i) {
-        const auto& neighbors = neighborLists[i];
-        const auto& neighbors2 = neighborLists2[i];
-        EXPECT_EQ(neighbors.size(), neighbors2.size());
+    for (size_t i = 0; i < neighborLists.Size(); ++i) {
+        const auto neighbors = neighborLists[i];
+        const auto neighbors2 = neighborLists2[i];
+        EXPECT_EQ(neighbors.Size(), neighbors2.Size());
 
-        for (size_t j = 0; j < neighbors.size(); ++j) {
+        for (size_t j = 0; j < neighbors.Size(); ++j) {
             EXPECT_EQ(neighbors[j], neighbors2[j]);
         }
     }
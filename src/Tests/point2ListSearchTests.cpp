@@ -2,6 +2,8 @@
 #include <NeighborhoodSearch/point2_list search.h>
 #include <gtest/gtest.h>
 
+#include <vector>
+
 using namespace jet;
 
 TEST(PointListSearch2, ForEachNearbyPoint) {
@@ -26,4 +28,26 @@ TEST(PointListSearch2, ForEachNearbyPoint) {
                 EXPECT_EQ(points[2], pt);
             }
         });
-}
\ No newline at end of file
+}
+TEST(PointListSearch2, VisitNearbyPoints) {
+    Array1<Vector2D> points = {
+        Vector2D(1, 3),
+        Vector2D(2, 5),
+        Vector2D(-1, 3)
+    };
+
+    PointListSearch2 searcher;
+    searcher.Build(points.Accessor());
+
+    const PointNeighborSearch2& base = searcher;
+    std::vector<size_t> found;
+    base.VisitNearbyPoints(
+        Vector2D(0, 0),
+        std::sqrt(10.0),
+        [&](size_t i, const Vector2D& pt) {
+            EXPECT_EQ(points[i], pt);
+            found.push_back(i);
+        });
+
+    EXPECT_EQ(std::vector<size_t>({0, 2}), found);
+}
@@ -0,0 +1,129 @@
+#include <Arrays/array1.h>
+#include <IO/Serialization/factory.h>
+#include <NeighborhoodSearch/point3_compact_hash_grid_search.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace jet;
+
+namespace
+{
+    // Two clusters of points far apart, so that a dense grid would need a
+    // huge resolution or wrap the clusters onto each other.
+    Array1<Vector3D> MakeSparsePoints()
+    {
+        std::mt19937 rng;
+        std::uniform_real_distribution<> d(0.0, 1.0);
+
+        Array1<Vector3D> points(2000);
+        for (size_t i = 0; i < points.Size(); ++i) {
+            points[i] = Vector3D(d(rng), d(rng), d(rng));
+            if (i % 2 == 1)
+                points[i] += Vector3D(1e6, -1e6, 1e6);
+        }
+        return points;
+    }
+
+    void ExpectSameNeighbors(const PointNeighborSearch3& searcher,
+                             const Array1<Vector3D>& points, double radius)
+    {
+        for (size_t i = 0; i < points.Size(); ++i) {
+            std::vector<size_t> expected;
+            for (size_t j = 0; j < points.Size(); ++j) {
+                if (points[i].DistanceTo(points[j]) <= radius)
+                    expected.push_back(j);
+            }
+
+            std::vector<size_t> found;
+            searcher.ForEachNearbyPoint(points[i], radius,
+                [&](size_t j, const Vector3D& pt) {
+                    EXPECT_EQ(points[j], pt);
+                    found.push_back(j);
+                });
+            std::sort(found.begin(), found.end());
+
+            EXPECT_EQ(expected, found);
+            EXPECT_TRUE(searcher.HasNearbyPoint(points[i], radius));
+        }
+    }
+}
+
+TEST(PointCompactHashGridSearch3, ForEachNearbyPoint) {
+    Array1<Vector3D> points = MakeSparsePoints();
+
+    const double radius = 0.1;
+    PointCompactHashGridSearch3 searcher(2.0 * radius);
+    searcher.Build(points.Accessor());
+
+    ExpectSameNeighbors(searcher, points, radius);
+    EXPECT_FALSE(searcher.HasNearbyPoint(Vector3D(1e6, -1e6, 1e6) * 0.5, radius));
+
+    size_t count = 0;
+    searcher.VisitNearbyPoints(points[0], radius, [&](size_t, const Vector3D&) { ++count; });
+    EXPECT_LT(0u, count);
+}
+
+TEST(PointCompactHashGridSearch3, ForEachNearbyPointEmpty) {
+    Array1<Vector3D> points;
+
+    PointCompactHashGridSearch3 searcher(1.0);
+    searcher.Build(points.Accessor());
+
+    searcher.ForEachNearbyPoint(Vector3D(), 0.5,
+        [](size_t, const Vector3D&) {
+            FAIL();
+        });
+    EXPECT_FALSE(searcher.HasNearbyPoint(Vector3D(), 0.5));
+    EXPECT_EQ(0u, searcher.NumberOfOccupiedCells());
+}
+
+TEST(PointCompactHashGridSearch3, OccupiedCells) {
+    Array1<Vector3D> points = MakeSparsePoints();
+
+    PointCompactHashGridSearch3 searcher(0.5);
+    searcher.Build(points.Accessor());
+
+    // Each cluster spans 8 cells and the table only stores those.
+    EXPECT_EQ(16u, searcher.NumberOfOccupiedCells());
+    EXPECT_LE(2 * searcher.NumberOfOccupiedCells(), searcher.TableCapacity());
+    EXPECT_GE(4 * searcher.NumberOfOccupiedCells(), searcher.TableCapacity());
+
+    // The points of a cell are contiguous and keep their original order.
+    const auto& sortedIndices = searcher.SortedIndices();
+    ASSERT_EQ(points.Size(), sortedIndices.size());
+    for (size_t i = 1; i < sortedIndices.size(); ++i) {
+        if (searcher.GetCell(points[sortedIndices[i]]) == searcher.GetCell(points[sortedIndices[i - 1]])) {
+            EXPECT_LT(sortedIndices[i - 1], sortedIndices[i]);
+        }
+    }
+}
+
+TEST(PointCompactHashGridSearch3, CopyAndSerialization) {
+    Array1<Vector3D> points = MakeSparsePoints();
+
+    const double radius = 0.1;
+    PointCompactHashGridSearch3 searcher(2.0 * radius);
+    searcher.Build(points.Accessor());
+
+    PointCompactHashGridSearch3 copy(searcher);
+    ExpectSameNeighbors(copy, points, radius);
+
+    auto clone = searcher.Clone();
+    ExpectSameNeighbors(*clone, points, radius);
+
+    std::vector<uint8_t> buffer;
+    searcher.Serialize(&buffer);
+
+    auto deserialized = Factory::BuildPointNeighborSearch3("PointCompactHashGridSearch3");
+    ASSERT_NE(nullptr, deserialized);
+    EXPECT_EQ("PointCompactHashGridSearch3", deserialized->TypeName());
+    deserialized->Deserialize(buffer);
+    ExpectSameNeighbors(*deserialized, points, radius);
+
+    auto builder = PointCompactHashGridSearch3::builder().WithGridSpacing(2.0 * radius).MakeShared();
+    builder->Build(points.Accessor());
+    ExpectSameNeighbors(*builder, points, radius);
+}
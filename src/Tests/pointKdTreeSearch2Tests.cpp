@@ -0,0 +1,202 @@
+#include <Arrays/array1.h>
+#include <IO/Serialization/factory.h>
+#include <NeighborhoodSearch/point2_kdtree_search.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace jet;
+
+namespace
+{
+    // Random points with a few duplicates, which end up on both sides of
+    // a split.
+    Array1<Vector2D> MakePoints(size_t numberOfPoints)
+    {
+        std::mt19937 rng;
+        std::uniform_real_distribution<> d(0.0, 1.0);
+
+        Array1<Vector2D> points(numberOfPoints);
+        for (size_t i = 0; i < points.Size(); ++i) {
+            if (i % 10 == 9)
+                points[i] = points[i - 1];
+            else
+                points[i] = Vector2D(d(rng), d(rng));
+        }
+        return points;
+    }
+
+    void ExpectSameNeighbors(const PointNeighborSearch2& searcher,
+                             const Array1<Vector2D>& points, double radius)
+    {
+        for (size_t i = 0; i < points.Size(); ++i) {
+            std::vector<size_t> expected;
+            for (size_t j = 0; j < points.Size(); ++j) {
+                if (points[i].DistanceTo(points[j]) <= radius)
+                    expected.push_back(j);
+            }
+
+            std::vector<size_t> found;
+            searcher.ForEachNearbyPoint(points[i], radius,
+                [&](size_t j, const Vector2D& pt) {
+                    EXPECT_EQ(points[j], pt);
+                    found.push_back(j);
+                });
+            std::sort(found.begin(), found.end());
+
+            EXPECT_EQ(expected, found);
+            EXPECT_TRUE(searcher.HasNearbyPoint(points[i], radius));
+        }
+    }
+
+    // Returns the distances of the k nearest points, nearest first.
+    std::vector<double> BruteForceKNearest(const Array1<Vector2D>& points,
+                                           const Vector2D& origin, size_t k)
+    {
+        std::vector<double> distances;
+        for (size_t j = 0; j < points.Size(); ++j)
+            distances.push_back(origin.DistanceTo(points[j]));
+        std::sort(distances.begin(), distances.end());
+        distances.resize(std::min(k, distances.size()));
+        return distances;
+    }
+
+    void ExpectSameKNearest(const PointKdTreeSearch2& searcher,
+                            const Array1<Vector2D>& points, const Vector2D& origin, size_t k)
+    {
+        std::vector<double> found;
+        searcher.ForEachKNearest(origin, k, [&](size_t j, const Vector2D& pt) {
+            EXPECT_EQ(points[j], pt);
+            found.push_back(origin.DistanceTo(pt));
+        });
+
+        EXPECT_EQ(BruteForceKNearest(points, origin, k), found);
+    }
+}
+
+TEST(PointKdTreeSearch2, ForEachNearbyPoint) {
+    Array1<Vector2D> points = MakePoints(1000);
+
+    PointKdTreeSearch2 searcher;
+    searcher.Build(points.Accessor());
+
+    ExpectSameNeighbors(searcher, points, 0.05);
+    EXPECT_FALSE(searcher.HasNearbyPoint(Vector2D(3.0, 3.0), 0.5));
+
+    size_t count = 0;
+    searcher.VisitNearbyPoints(points[0], 0.05, [&](size_t, const Vector2D&) { ++count; });
+    EXPECT_LT(0u, count);
+}
+
+TEST(PointKdTreeSearch2, ForEachNearbyPointEmpty) {
+    Array1<Vector2D> points;
+
+    PointKdTreeSearch2 searcher;
+    searcher.Build(points.Accessor());
+
+    searcher.ForEachNearbyPoint(Vector2D(), 0.5,
+        [](size_t, const Vector2D&) {
+            FAIL();
+        });
+    searcher.ForEachKNearest(Vector2D(), 3,
+        [](size_t, const Vector2D&) {
+            FAIL();
+        });
+    EXPECT_FALSE(searcher.HasNearbyPoint(Vector2D(), 0.5));
+    EXPECT_EQ(kMaxSize, searcher.NearestPoint(Vector2D()));
+    EXPECT_EQ(0u, searcher.NumberOfNodes());
+}
+
+TEST(PointKdTreeSearch2, ForEachKNearest) {
+    Array1<Vector2D> points = MakePoints(1000);
+
+    PointKdTreeSearch2 searcher(4);
+    searcher.Build(points.Accessor());
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<> d(-0.5, 1.5);
+    for (int i = 0; i < 100; ++i) {
+        const Vector2D origin(d(rng), d(rng));
+        ExpectSameKNearest(searcher, points, origin, 1);
+        ExpectSameKNearest(searcher, points, origin, 16);
+
+        const size_t nearest = searcher.NearestPoint(origin);
+        ASSERT_LT(nearest, points.Size());
+        EXPECT_EQ(BruteForceKNearest(points, origin, 1)[0], origin.DistanceTo(points[nearest]));
+    }
+
+    // Asking for more points than available visits all of them.
+    ExpectSameKNearest(searcher, points, Vector2D(), 2000);
+}
+
+TEST(PointKdTreeSearch2, ParallelBuild) {
+    // Large enough for the subtrees to be built in parallel.
+    Array1<Vector2D> points = MakePoints(100000);
+
+    PointKdTreeSearch2 searcher;
+    searcher.Build(points.Accessor());
+
+    // Each leaf holds at most 8 points and every internal node has two
+    // children.
+    EXPECT_LE(2 * points.Size() / 8 - 1, searcher.NumberOfNodes());
+    EXPECT_GE(2 * points.Size() / 2 - 1, searcher.NumberOfNodes());
+
+    const auto& sortedIndices = searcher.SortedIndices();
+    std::vector<size_t> indices(sortedIndices.begin(), sortedIndices.end());
+    std::sort(indices.begin(), indices.end());
+    for (size_t i = 0; i < indices.size(); ++i)
+        EXPECT_EQ(i, indices[i]);
+
+    for (size_t i = 0; i < points.Size(); i += 997) {
+        ExpectSameKNearest(searcher, points, points[i], 10);
+
+        const double radius = 0.005;
+        size_t expected = 0;
+        for (size_t j = 0; j < points.Size(); ++j) {
+            if (points[i].DistanceTo(points[j]) <= radius)
+                ++expected;
+        }
+
+        size_t found = 0;
+        searcher.ForEachNearbyPoint(points[i], radius, [&](size_t, const Vector2D&) { ++found; });
+        EXPECT_EQ(expected, found);
+    }
+}
+
+TEST(PointKdTreeSearch2, CopyAndSerialization) {
+    Array1<Vector2D> points = MakePoints(500);
+
+    const double radius = 0.05;
+    PointKdTreeSearch2 searcher(4);
+    searcher.Build(points.Accessor());
+
+    PointKdTreeSearch2 copy(searcher);
+    ExpectSameNeighbors(copy, points, radius);
+    EXPECT_EQ(4u, copy.MaxLeafSize());
+
+    auto clone = searcher.Clone();
+    ExpectSameNeighbors(*clone, points, radius);
+
+    std::vector<uint8_t> buffer;
+    searcher.Serialize(&buffer);
+
+    auto deserialized = Factory::BuildPointNeighborSearch2("PointKdTreeSearch2");
+    ASSERT_NE(nullptr, deserialized);
+    EXPECT_EQ("PointKdTreeSearch2", deserialized->TypeName());
+    deserialized->Deserialize(buffer);
+    ExpectSameNeighbors(*deserialized, points, radius);
+
+    auto tree = std::dynamic_pointer_cast<PointKdTreeSearch2>(deserialized);
+    ASSERT_NE(nullptr, tree);
+    EXPECT_EQ(4u, tree->MaxLeafSize());
+    EXPECT_EQ(searcher.NumberOfNodes(), tree->NumberOfNodes());
+    EXPECT_EQ(searcher.SortedIndices(), tree->SortedIndices());
+
+    auto builder = PointKdTreeSearch2::builder().WithMaxLeafSize(16).MakeShared();
+    builder->Build(points.Accessor());
+    ExpectSameNeighbors(*builder, points, radius);
+    EXPECT_EQ(16u, builder->MaxLeafSize());
+}
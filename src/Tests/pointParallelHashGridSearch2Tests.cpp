@@ -2,6 +2,10 @@
 #include <NeighborhoodSearch/point2_parallel_hash_grid_search.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <random>
+#include <vector>
+
 using namespace jet;
 
 TEST(PointParallelHashGridSearch2, ForEachNearbyPoint) {
@@ -39,4 +43,197 @@ TEST(PointParallelHashGridSearch2, ForEachNearbyPointEmpty) {
         std::sqrt(10.0),
         [](size_t, const Vector2D&) {
         });
-}
\ No newline at end of file
+}
+TEST(PointParallelHashGridSearch2, VisitNearbyPoints) {
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<> d(0.0, 1.0);
+
+    Array1<Vector2D> points(1000);
+    for (size_t i = 0; i < points.Size(); ++i) {
+        points[i] = Vector2D(d(rng), d(rng));
+    }
+
+    const double radius = 0.05;
+    PointParallelHashGridSearch2 searcher(16, 16, 2.0 * radius);
+    searcher.Build(points.Accessor());
+    const PointNeighborSearch2& base = searcher;
+
+    for (size_t i = 0; i < points.Size(); i += 7) {
+        const Vector2D& origin = points[i];
+
+        // Virtual query through std::function.
+        std::vector<size_t> expected;
+        base.ForEachNearbyPoint(origin, radius,
+            [&](size_t j, const Vector2D&) { expected.push_back(j); });
+
+        // Templated query on the concrete class.
+        std::vector<size_t> foundTemplated;
+        searcher.ForEachNearbyPoint(origin, radius,
+            [&](size_t j, const Vector2D&) { foundTemplated.push_back(j); });
+
+        // Visitor query through the base class.
+        std::vector<size_t> foundVisited;
+        base.VisitNearbyPoints(origin, radius,
+            [&](size_t j, const Vector2D& pt) {
+                EXPECT_EQ(points[j], pt);
+                foundVisited.push_back(j);
+            });
+
+        EXPECT_EQ(expected, foundTemplated);
+        EXPECT_EQ(expected, foundVisited);
+
+        // The candidates expose the coordinate arrays for the SIMD filter.
+        PointNeighborSearch2::NearbyPointCandidates candidates;
+        searcher.GetNearbyPointCandidates(origin, radius, &candidates);
+        for (const auto& range : candidates.Ranges) {
+            ASSERT_NE(nullptr, range.Xs);
+            ASSERT_NE(nullptr, range.Ys);
+            for (size_t k = 0; k < range.Size; ++k) {
+                EXPECT_EQ(range.Positions[k].x, range.Xs[k]);
+                EXPECT_EQ(range.Positions[k].y, range.Ys[k]);
+            }
+        }
+
+        for (size_t j = 0; j < points.Size(); ++j) {
+            bool isFound = std::find(expected.begin(), expected.end(), j) != expected.end();
+            EXPECT_EQ(origin.DistanceTo(points[j]) <= radius, isFound);
+        }
+    }
+}
+
+TEST(PointParallelHashGridSearch2, Statistics) {
+    // Cells 0 and 4 along x wrap into the same bucket.
+    Array1<Vector2D> points = {
+        Vector2D(0.5, 0.5),
+        Vector2D(0.6, 0.5),
+        Vector2D(4.5, 0.5),
+        Vector2D(1.5, 0.5)
+    };
+
+    PointParallelHashGridSearch2 searcher(4, 4, 1.0);
+    searcher.Build(points.Accessor());
+
+    const HashGridStatistics& statistics = searcher.Statistics();
+    EXPECT_EQ(4u, statistics.NumberOfPoints);
+    EXPECT_EQ(16u, statistics.NumberOfBuckets);
+    EXPECT_EQ(2u, statistics.NumberOfNonEmptyBuckets);
+    EXPECT_EQ(1u, statistics.NumberOfCollidingBuckets);
+    EXPECT_EQ(3u, statistics.MaxNumberOfPointsInBucket);
+    EXPECT_DOUBLE_EQ(2.0 / 16.0, statistics.Occupancy());
+    EXPECT_DOUBLE_EQ(2.0, statistics.AverageNumberOfPointsPerNonEmptyBucket());
+
+    PointParallelHashGridSearch2 copy(searcher);
+    EXPECT_EQ(1u, copy.Statistics().NumberOfCollidingBuckets);
+
+    searcher.Build(Array1<Vector2D>().Accessor());
+    EXPECT_EQ(0u, searcher.Statistics().NumberOfPoints);
+    EXPECT_EQ(0u, searcher.Statistics().NumberOfNonEmptyBuckets);
+    EXPECT_EQ(0u, searcher.Statistics().MaxNumberOfPointsInBucket);
+}
+
+namespace
+{
+    void ExpectSameHashGrid(const PointParallelHashGridSearch2& expected,
+                            const PointParallelHashGridSearch2& actual)
+    {
+        EXPECT_EQ(expected.Keys(), actual.Keys());
+        EXPECT_EQ(expected.SortedIndices(), actual.SortedIndices());
+        EXPECT_EQ(expected.StartIndexTable(), actual.StartIndexTable());
+        EXPECT_EQ(expected.EndIndexTable(), actual.EndIndexTable());
+    }
+}
+
+TEST(PointParallelHashGridSearch2, Update) {
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(0.0, 1.0);
+    std::uniform_real_distribution<> jitter(-0.005, 0.005);
+
+    Array1<Vector2D> points(20000);
+    for (size_t i = 0; i < points.Size(); ++i)
+        points[i] = Vector2D(d(rng), d(rng));
+
+    PointParallelHashGridSearch2 searcher(16, 16, 0.05);
+    searcher.Build(points.Accessor());
+
+    // Small moves change the bucket of a few points, larger ones of most
+    // points, and wrap some of them around the grid.
+    for (double scale : {0.0, 1.0, 10.0, 100.0}) {
+        for (size_t i = 0; i < points.Size(); ++i)
+            points[i] += scale * Vector2D(jitter(rng), jitter(rng));
+
+        searcher.Update(points.Accessor());
+
+        PointParallelHashGridSearch2 expected(16, 16, 0.05);
+        expected.Build(points.Accessor());
+        ExpectSameHashGrid(expected, searcher);
+
+        const Vector2D origin = points[0];
+        size_t count = 0;
+        searcher.ForEachNearbyPoint(origin, 0.02, [&](size_t j, const Vector2D& pt) {
+            EXPECT_EQ(points[j], pt);
+            EXPECT_LE(origin.DistanceTo(pt), 0.02);
+            ++count;
+        });
+        EXPECT_LT(0u, count);
+    }
+
+    EXPECT_THROW(searcher.Update(Array1<Vector2D>(3).Accessor()), std::invalid_argument);
+}
+
+TEST(PointParallelHashGridSearch2, AddAndRemove) {
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(0.0, 1.0);
+
+    Array1<Vector2D> points(10000);
+    for (size_t i = 0; i < points.Size(); ++i)
+        points[i] = Vector2D(d(rng), d(rng));
+
+    PointParallelHashGridSearch2 searcher(16, 16, 0.05);
+    searcher.Build(Array1<Vector2D>().Accessor());
+
+    // Add the points in three batches.
+    Array1<Vector2D> batch;
+    for (size_t i = 0; i < points.Size(); ++i) {
+        batch.Append(points[i]);
+        if (i == 0 || i == 4999 || i + 1 == points.Size()) {
+            searcher.Add(batch.Accessor());
+            batch.Clear();
+        }
+    }
+
+    PointParallelHashGridSearch2 expected(16, 16, 0.05);
+    expected.Build(points.Accessor());
+    ExpectSameHashGrid(expected, searcher);
+
+    // Remove every third point, with duplicated indices.
+    Array1<size_t> removed;
+    Array1<Vector2D> remaining;
+    for (size_t i = 0; i < points.Size(); ++i) {
+        if (i % 3 == 0) {
+            removed.Append(i);
+            removed.Append(i);
+        } else {
+            remaining.Append(points[i]);
+        }
+    }
+
+    searcher.Remove(removed.Accessor());
+    expected.Build(remaining.Accessor());
+    ExpectSameHashGrid(expected, searcher);
+
+    searcher.ForEachNearbyPoint(remaining[0], 0.02, [&](size_t j, const Vector2D& pt) {
+        EXPECT_EQ(remaining[j], pt);
+    });
+
+    // Remove all the points.
+    Array1<size_t> all(remaining.Size());
+    for (size_t i = 0; i < all.Size(); ++i)
+        all[i] = i;
+
+    searcher.Remove(all.Accessor());
+    expected.Build(Array1<Vector2D>().Accessor());
+    ExpectSameHashGrid(expected, searcher);
+    EXPECT_FALSE(searcher.HasNearbyPoint(remaining[0], 0.02));
+
+    EXPECT_THROW(searcher.Remove(Array1<size_t>(1, 0).Accessor()), std::invalid_argument);
+}
@@ -0,0 +1,85 @@
+#include<simd.h>
+#include<gtest/gtest.h>
+
+#include<random>
+#include<vector>
+
+using namespace jet;
+
+TEST(Simd, ForEachPointInRadius2) {
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(0.0, 1.0);
+
+    const size_t N = 37;
+    std::vector<double> xs(N), ys(N);
+    for (size_t i = 0; i < N; ++i) {
+        xs[i] = d(rng);
+        ys[i] = d(rng);
+    }
+
+    // Every range length covers the SIMD blocks and the scalar remainder.
+    const double originX = 0.4, originY = 0.6, radiusSq = 0.1;
+    for (size_t begin = 0; begin < 9; ++begin) {
+        for (size_t end = begin; end <= N; ++end) {
+            std::vector<size_t> expected;
+            for (size_t j = begin; j < end; ++j) {
+                const double dx = xs[j] - originX;
+                const double dy = ys[j] - originY;
+                if (dx * dx + dy * dy <= radiusSq)
+                    expected.push_back(j);
+            }
+
+            std::vector<size_t> found;
+            ForEachPointInRadius(xs.data(), ys.data(), begin, end, originX, originY, radiusSq,
+                    [&](size_t j) { found.push_back(j); });
+
+            EXPECT_EQ(expected, found);
+        }
+    }
+}
+
+TEST(Simd, ForEachPointInRadius3) {
+    std::mt19937 rng;
+    std::uniform_real_distribution<> d(0.0, 1.0);
+
+    const size_t N = 37;
+    std::vector<double> xs(N), ys(N), zs(N);
+    for (size_t i = 0; i < N; ++i) {
+        xs[i] = d(rng);
+        ys[i] = d(rng);
+        zs[i] = d(rng);
+    }
+
+    const double originX = 0.4, originY = 0.6, originZ = 0.5, radiusSq = 0.15;
+    for (size_t begin = 0; begin < 9; ++begin) {
+        for (size_t end = begin; end <= N; ++end) {
+            std::vector<size_t> expected;
+            for (size_t j = begin; j < end; ++j) {
+                const double dx = xs[j] - originX;
+                const double dy = ys[j] - originY;
+                const double dz = zs[j] - originZ;
+                if (dx * dx + dy * dy + dz * dz <= radiusSq)
+                    expected.push_back(j);
+            }
+
+            std::vector<size_t> found;
+            ForEachPointInRadius(xs.data(), ys.data(), zs.data(), begin, end,
+                    originX, originY, originZ, radiusSq,
+                    [&](size_t j) { found.push_back(j); });
+
+            EXPECT_EQ(expected, found);
+        }
+    }
+}
+
+TEST(Simd, ForEachPointInRadiusOnBoundary) {
+    // Points exactly at the radius are included, as with the scalar test.
+    std::vector<double> xs = {1.0, 0.0, -1.0, 0.0, 2.0, 0.5, 0.0, 1.0, 0.0};
+    std::vector<double> ys = {0.0, 1.0, 0.0, -1.0, 0.0, 0.5, 0.0, 1.0, 1.5};
+
+    std::vector<size_t> found;
+    ForEachPointInRadius(xs.data(), ys.data(), 0, xs.size(), 0.0, 0.0, 1.0,
+            [&](size_t j) { found.push_back(j); });
+
+    EXPECT_EQ(std::vector<size_t>({0, 1, 2, 3, 5, 6}), found);
+}
@@ -1,6 +1,8 @@
 #include <ParticleSim/SPH/sph_kernels2.h>
 #include <gtest/gtest.h>
 
+#include <cmath>
+
 using namespace jet;
 
 TEST(SPHStdKernel2, Constructors) {
@@ -101,3 +103,41 @@ TEST(SPHSpikyKernel2, SecondDerivative) {
     EXPECT_LT(value1, value0);
     EXPECT_LT(value2, value1);
 }
+
+TEST(SPHStdKernel2F, MatchesDoublePrecision) {
+    SPHStdKernel2 kernel(10.0);
+    SPHStdKernel2F kernelF(10.0f);
+
+    for (int i = 0; i <= 10; ++i) {
+        const double distance = static_cast<double>(i);
+        const float distanceF = static_cast<float>(i);
+        EXPECT_NEAR(kernel(distance), kernelF(distanceF), 1e-6 * kernel(0.0));
+        EXPECT_NEAR(kernel.FirstDerivative(distance), kernelF.FirstDerivative(distanceF),
+                    1e-6 * kernel(0.0));
+        EXPECT_NEAR(kernel.SecondDerivative(distance), kernelF.SecondDerivative(distanceF),
+                    1e-6 * std::abs(kernel.SecondDerivative(0.0)));
+    }
+
+    Vector2F gradient = kernelF.Gradient(Vector2F(0, 5));
+    EXPECT_FLOAT_EQ(0.0f, gradient.x);
+    EXPECT_FLOAT_EQ(static_cast<float>(kernel.Gradient(Vector2D(0, 5)).y), gradient.y);
+}
+
+TEST(SPHSpikyKernel2F, MatchesDoublePrecision) {
+    SPHSpikyKernel2 kernel(10.0);
+    SPHSpikyKernel2F kernelF(10.0f);
+
+    for (int i = 0; i <= 10; ++i) {
+        const double distance = static_cast<double>(i);
+        const float distanceF = static_cast<float>(i);
+        EXPECT_NEAR(kernel(distance), kernelF(distanceF), 1e-6 * kernel(0.0));
+        EXPECT_NEAR(kernel.FirstDerivative(distance), kernelF.FirstDerivative(distanceF),
+                    1e-6 * std::abs(kernel.FirstDerivative(0.0)));
+        EXPECT_NEAR(kernel.SecondDerivative(distance), kernelF.SecondDerivative(distanceF),
+                    1e-6 * kernel.SecondDerivative(0.0));
+    }
+
+    Vector2F gradient = kernelF.Gradient(Vector2F(0, 5));
+    EXPECT_FLOAT_EQ(0.0f, gradient.x);
+    EXPECT_FLOAT_EQ(static_cast<float>(kernel.Gradient(Vector2D(0, 5)).y), gradient.y);
+}
@@ -1,6 +1,14 @@
 #include <ParticleSim/SPH/sph_solver2.h>
+#include <ParticleSim/Collision/rigid_body2_collider.h>
+#include <Geometry/PointGenerator/volume_particle_emitter2.h>
+#include <Geometry/Sphere/sphere2.h>
+#include <Geometry/Surface/surface_to_implicit2.h>
 #include <gtest/gtest.h>
 
+#include <memory>
+#include <mutex>
+#include <string>
+
 using namespace jet;
 
 TEST(SPHSolver2, UpdateEmpty) {
@@ -54,4 +62,155 @@ TEST(SPHSolver2, Parameters) {
     EXPECT_DOUBLE_EQ(0.0, solver.TimeStepLimitScale());
 
     EXPECT_TRUE(solver.SPHSystemData() != nullptr);
+
+    EXPECT_EQ(ExecutionPolicy::kAuto, solver.GetExecutionPolicy());
+    solver.SetExecutionPolicy(ExecutionPolicy::kSerial);
+    EXPECT_EQ(ExecutionPolicy::kSerial, solver.GetExecutionPolicy());
+
+    EXPECT_FALSE(solver.IsUsingHalfNeighborLists());
+    solver.SetIsUsingHalfNeighborLists(true);
+    EXPECT_TRUE(solver.IsUsingHalfNeighborLists());
+}
+
+TEST(SPHSolver2, HalfNeighborLists) {
+    auto simulate = [](bool isUsingHalfNeighborLists) {
+        SPHSolver2 solver(1000.0, 0.02, 1.8);
+        solver.SetIsUsingHalfNeighborLists(isUsingHalfNeighborLists);
+
+        auto sphere = std::make_shared<Sphere2>(Vector2D(0.5, 0.5), 0.2);
+        auto emitter = std::make_shared<VolumeParticleEmitter2>(
+            std::make_shared<SurfaceToImplicit2>(sphere),
+            BoundingBox2D(Vector2D(0, 0), Vector2D(1, 1)), 0.02);
+        solver.SetEmitter(emitter);
+
+        for (unsigned int i = 0; i < 3; ++i) {
+            solver.Update(Frame(i, 1.0 / 60.0));
+        }
+
+        auto x = solver.SPHSystemData()->Positions();
+        return std::vector<Vector2D>(x.begin(), x.end());
+    };
+
+    auto full = simulate(false);
+    auto half = simulate(true);
+
+    ASSERT_EQ(full.size(), half.size());
+    EXPECT_LT(0u, full.size());
+    for (size_t i = 0; i < full.size(); ++i) {
+        EXPECT_NEAR(full[i].x, half[i].x, 1e-9);
+        EXPECT_NEAR(full[i].y, half[i].y, 1e-9);
+    }
+}
+
+TEST(SPHSolver2, ColliderUpdatedBeforeEmitter) {
+    SPHSolver2 solver(1000.0, 0.02, 1.8);
+    solver.SetExecutionPolicy(ExecutionPolicy::kParallel);
+
+    std::mutex mutex;
+    std::string order;
+
+    auto collider = RigidBodyCollider2::builder()
+        .WithSurface(std::make_shared<Sphere2>(Vector2D(0.5, 0.5), 1.0))
+        .MakeShared();
+    collider->SetOnBeginUpdateCallback([&](Collider2*, double, double) {
+        std::lock_guard<std::mutex> lock(mutex);
+        order += 'c';
+    });
+    solver.SetCollider(collider);
+
+    auto emitter = std::make_shared<VolumeParticleEmitter2>(
+        std::make_shared<SurfaceToImplicit2>(std::make_shared<Sphere2>(Vector2D(0.5, 0.5), 0.2)),
+        BoundingBox2D(Vector2D(0, 0), Vector2D(1, 1)), 0.02);
+    emitter->SetOnBeginUpdateCallback([&](ParticleEmitter2*, double, double) {
+        std::lock_guard<std::mutex> lock(mutex);
+        order += 'e';
+    });
+    solver.SetEmitter(emitter);
+
+    for (unsigned int i = 0; i < 3; ++i) {
+        solver.Update(Frame(i, 1.0 / 60.0));
+    }
+
+    ASSERT_LT(0u, order.size());
+    EXPECT_EQ(0u, order.size() % 2);
+    for (size_t i = 0; i < order.size(); i += 2) {
+        EXPECT_EQ("ce", order.substr(i, 2));
+    }
+}
+
+TEST(SPHSolver2, NeighborListSkinRadius) {
+    auto simulate = [](double skinRadius, size_t* numberOfReuses) {
+        SPHSolver2 solver(1000.0, 0.02, 1.8);
+        solver.SPHSystemData()->SetNeighborListSkinRadius(skinRadius);
+
+        auto sphere = std::make_shared<Sphere2>(Vector2D(0.5, 0.5), 0.2);
+        auto emitter = std::make_shared<VolumeParticleEmitter2>(
+            std::make_shared<SurfaceToImplicit2>(sphere),
+            BoundingBox2D(Vector2D(0, 0), Vector2D(1, 1)), 0.02);
+        solver.SetEmitter(emitter);
+
+        for (unsigned int i = 0; i < 3; ++i) {
+            solver.Update(Frame(i, 1.0 / 60.0));
+        }
+
+        *numberOfReuses = solver.SPHSystemData()->NumberOfNeighborListReuses();
+        auto x = solver.SPHSystemData()->Positions();
+        return std::vector<Vector2D>(x.begin(), x.end());
+    };
+
+    size_t numberOfReuses = 0;
+    auto expected = simulate(0.0, &numberOfReuses);
+    EXPECT_EQ(0u, numberOfReuses);
+
+    auto verlet = simulate(0.2 * 0.02 * 1.8, &numberOfReuses);
+    EXPECT_LT(0u, numberOfReuses);
+
+    ASSERT_EQ(expected.size(), verlet.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_NEAR(expected[i].x, verlet[i].x, 1e-9);
+        EXPECT_NEAR(expected[i].y, verlet[i].y, 1e-9);
+    }
+}
+
+TEST(SPHSolver2, SpatialReordering) {
+    auto simulate = [](unsigned int interval) {
+        SPHSolver2 solver(1000.0, 0.02, 1.8);
+        solver.SetSpatialReorderingInterval(interval);
+        EXPECT_EQ(interval, solver.SpatialReorderingInterval());
+
+        auto sphere = std::make_shared<Sphere2>(Vector2D(0.5, 0.5), 0.2);
+        auto emitter = std::make_shared<VolumeParticleEmitter2>(
+            std::make_shared<SurfaceToImplicit2>(sphere),
+            BoundingBox2D(Vector2D(0, 0), Vector2D(1, 1)), 0.02);
+        solver.SetEmitter(emitter);
+        solver.Update(Frame(0, 1.0 / 60.0));
+
+        // Tag the particles to find them after the reordering.
+        auto particles = solver.SPHSystemData();
+        size_t tagIdx = particles->AddScalarData();
+        auto tags = particles->ScalarDataAt(tagIdx);
+        for (size_t i = 0; i < tags.Size(); ++i) {
+            tags[i] = static_cast<double>(i);
+        }
+
+        for (unsigned int i = 1; i < 3; ++i) {
+            solver.Update(Frame(i, 1.0 / 60.0));
+        }
+
+        std::vector<Vector2D> x(particles->NumberOfParticles());
+        for (size_t i = 0; i < x.size(); ++i) {
+            x[static_cast<size_t>(particles->ScalarDataAt(tagIdx)[i])]
+                = particles->Positions()[i];
+        }
+        return x;
+    };
+
+    auto expected = simulate(0);
+    auto reordered = simulate(2);
+
+    ASSERT_EQ(expected.size(), reordered.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_NEAR(expected[i].x, reordered[i].x, 1e-9);
+        EXPECT_NEAR(expected[i].y, reordered[i].y, 1e-9);
+    }
 }
@@ -0,0 +1,87 @@
+#include <ParticleSim/SPH/sph_system_data2.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace jet;
+
+TEST(SPHSystemData2, ComputeSPHDensitiesSinglePrecision) {
+    const double spacing = 0.02;
+
+    SPHSystemData2 particles;
+    particles.SetTargetSpacing(spacing);
+
+    Array1<Vector2D> positions;
+    for (int j = 0; j < 30; ++j) {
+        for (int i = 0; i < 30; ++i)
+            positions.Append(Vector2D(spacing * i + 0.1 * spacing * std::sin(j), spacing * j));
+    }
+    particles.AddParticles(positions);
+
+    particles.BuildNeighborSearch();
+    particles.BuildNeighborLists();
+    particles.UpdateDensities();
+
+    Array1<Vector2F> positionsF(positions.Size());
+    for (size_t i = 0; i < positions.Size(); ++i)
+        positionsF[i] = Vector2F(static_cast<float>(positions[i].x), static_cast<float>(positions[i].y));
+
+    Array1<float> densitiesF(positions.Size());
+    ComputeSPHDensities(positionsF.ConstAccessor(), particles.NeighborLists(),
+                static_cast<float>(particles.KernelRadius()), static_cast<float>(particles.Mass()),
+                densitiesF.Accessor());
+
+    auto densities = particles.Densities();
+    double maxRelativeError = 0.0;
+    for (size_t i = 0; i < positions.Size(); ++i)
+        maxRelativeError = std::max(maxRelativeError, std::abs(densitiesF[i] - densities[i]) / densities[i]);
+
+    EXPECT_LT(maxRelativeError, 1e-5);
+
+    // The double path computed through the neighbor lists is the same as
+    // UpdateDensities.
+    Array1<double> listDensities(positions.Size());
+    ComputeSPHDensities(positions.ConstAccessor(), particles.NeighborLists(),
+                particles.KernelRadius(), particles.Mass(), listDensities.Accessor());
+    for (size_t i = 0; i < positions.Size(); ++i)
+        EXPECT_NEAR(densities[i], listDensities[i], 1e-9 * densities[i]);
+
+    // The sums do not depend on the execution policy.
+    Array1<float> serialDensitiesF(positions.Size());
+    ComputeSPHDensities(positionsF.ConstAccessor(), particles.NeighborLists(),
+                static_cast<float>(particles.KernelRadius()), static_cast<float>(particles.Mass()),
+                serialDensitiesF.Accessor(), ExecutionPolicy::kSerial);
+    for (size_t i = 0; i < positions.Size(); ++i)
+        EXPECT_EQ(densitiesF[i], serialDensitiesF[i]);
+}
+
+TEST(SPHSystemData2, BuildNeighborSearchWithSkinRadius) {
+    const double spacing = 0.02;
+
+    SPHSystemData2 particles;
+    particles.SetTargetSpacing(spacing);
+    particles.SetNeighborListSkinRadius(0.5 * spacing);
+
+    Array1<Vector2D> positions;
+    for (int j = 0; j < 20; ++j) {
+        for (int i = 0; i < 20; ++i)
+            positions.Append(Vector2D(spacing * i, spacing * j));
+    }
+    particles.AddParticles(positions);
+
+    particles.BuildNeighborSearch();
+    particles.BuildNeighborLists();
+    EXPECT_EQ(1u, particles.NumberOfNeighborListBuilds());
+
+    // Moving a particle less than half the skin radius keeps the lists, but
+    // the neighbor search follows the particle.
+    const Vector2D origin(-particles.KernelRadius() - 0.05 * spacing, 0.0);
+    EXPECT_EQ(0.0, particles.SumOfKernelsNearby(origin));
+
+    particles.Positions()[0] = Vector2D(-0.1 * spacing, 0.0);
+    particles.BuildNeighborSearch();
+    particles.BuildNeighborLists();
+    EXPECT_EQ(1u, particles.NumberOfNeighborListBuilds());
+    EXPECT_LT(0.0, particles.SumOfKernelsNearby(origin));
+}
@@ -0,0 +1,165 @@
+#include <task_graph.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace jet;
+
+TEST(TaskGraph, Empty) {
+    TaskGraph graph;
+    graph.Run();
+
+    EXPECT_EQ(0u, graph.NumberOfNodes());
+    EXPECT_TRUE(graph.CriticalPath().empty());
+    EXPECT_DOUBLE_EQ(0.0, graph.CriticalPathTimeInSeconds());
+}
+
+TEST(TaskGraph, Dependencies) {
+    for (ExecutionPolicy policy : {ExecutionPolicy::kSerial, ExecutionPolicy::kParallel}) {
+        TaskGraph graph;
+
+        std::mutex mutex;
+        std::vector<char> order;
+        auto record = [&](char c) {
+            return [&, c]() {
+                std::lock_guard<std::mutex> lock(mutex);
+                order.push_back(c);
+            };
+        };
+
+        // Diamond: a -> (b, c) -> d, plus an independent node e.
+        auto a = graph.AddNode("a", record('a'));
+        auto b = graph.AddNode("b", record('b'));
+        auto c = graph.AddNode("c", record('c'));
+        auto d = graph.AddNode("d", record('d'));
+        graph.AddNode("e", record('e'));
+        graph.AddDependency(a, b);
+        graph.AddDependency(a, c);
+        graph.AddDependency(b, d);
+        graph.AddDependency(c, d);
+
+        // The graph can be run several times.
+        for (int iter = 0; iter < 10; ++iter) {
+            order.clear();
+            graph.Run(policy);
+
+            ASSERT_EQ(5u, order.size());
+            auto position = [&](char ch) {
+                return std::find(order.begin(), order.end(), ch) - order.begin();
+            };
+            EXPECT_LT(position('a'), position('b'));
+            EXPECT_LT(position('a'), position('c'));
+            EXPECT_LT(position('b'), position('d'));
+            EXPECT_LT(position('c'), position('d'));
+            EXPECT_LT(position('e'), 5);
+        }
+    }
+}
+
+TEST(TaskGraph, AutoPolicy) {
+    TaskGraph graph;
+
+    std::mutex mutex;
+    std::vector<std::thread::id> threads;
+    auto record = [&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        threads.push_back(std::this_thread::get_id());
+    };
+    auto a = graph.AddNode("a", record);
+    auto b = graph.AddNode("b", record);
+    graph.AddNode("c", record);
+    graph.AddDependency(a, b);
+
+    // Small work runs on the calling thread.
+    graph.Run(ExecutionPolicy::kAuto, kAutoParallelThreshold - 1);
+    ASSERT_EQ(3u, threads.size());
+    for (const std::thread::id& id : threads) {
+        EXPECT_EQ(std::this_thread::get_id(), id);
+    }
+
+    threads.clear();
+    graph.Run(ExecutionPolicy::kAuto, kAutoParallelThreshold);
+    EXPECT_EQ(3u, threads.size());
+}
+
+TEST(TaskGraph, NestedParallelFor) {
+    TaskGraph graph;
+
+    std::vector<double> x(10000, 1.0);
+    std::vector<double> y(10000, 2.0);
+    double sum = 0.0;
+
+    auto scaleX = graph.AddNode("scale x", [&]() {
+        ParallelFor(kZeroSize, x.size(), [&](size_t i) { x[i] *= 3.0; });
+    });
+    auto scaleY = graph.AddNode("scale y", [&]() {
+        ParallelFor(kZeroSize, y.size(), [&](size_t i) { y[i] *= 0.5; });
+    });
+    auto dot = graph.AddNode("dot", [&]() {
+        sum = ParallelSum(kZeroSize, x.size(), [&](size_t i) { return x[i] * y[i]; });
+    });
+    graph.AddDependency(scaleX, dot);
+    graph.AddDependency(scaleY, dot);
+
+    graph.Run();
+    EXPECT_DOUBLE_EQ(30000.0, sum);
+}
+
+TEST(TaskGraph, CriticalPath) {
+    TaskGraph graph;
+
+    auto sleep = [](int ms) {
+        return [ms]() { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); };
+    };
+
+    // a (5ms) -> b (30ms) -> d (5ms)
+    //         -> c (1ms)  -> d
+    auto a = graph.AddNode("a", sleep(5));
+    auto b = graph.AddNode("b", sleep(30));
+    auto c = graph.AddNode("c", sleep(1));
+    auto d = graph.AddNode("d", sleep(5));
+    graph.AddDependency(a, b);
+    graph.AddDependency(a, c);
+    graph.AddDependency(b, d);
+    graph.AddDependency(c, d);
+
+    graph.Run();
+
+    EXPECT_EQ(std::vector<TaskGraph::NodeId>({a, b, d}), graph.CriticalPath());
+    EXPECT_EQ("b", graph.NodeName(b));
+    EXPECT_GE(graph.NodeDurationInSeconds(b), 0.03);
+    EXPECT_GE(graph.CriticalPathTimeInSeconds(), 0.04);
+    EXPECT_GE(graph.LastRunTimeInSeconds(), 0.04);
+}
+
+TEST(TaskGraph, NodeException) {
+    TaskGraph graph;
+    bool isSuccessorRun = false;
+    auto a = graph.AddNode("a", []() { throw std::runtime_error("a"); });
+    auto b = graph.AddNode("b", [&]() { isSuccessorRun = true; });
+    graph.AddDependency(a, b);
+
+    EXPECT_THROW(graph.Run(), std::runtime_error);
+    EXPECT_FALSE(isSuccessorRun);
+}
+
+TEST(TaskGraph, InvalidGraph) {
+    TaskGraph graph;
+    auto a = graph.AddNode("a", []() {});
+    auto b = graph.AddNode("b", []() {});
+
+    EXPECT_THROW(graph.AddDependency(a, a), std::invalid_argument);
+    EXPECT_THROW(graph.AddDependency(a, 7), std::invalid_argument);
+
+    graph.AddDependency(a, b);
+    graph.AddDependency(b, a);
+    EXPECT_THROW(graph.Run(), std::invalid_argument);
+
+    graph.Clear();
+    EXPECT_EQ(0u, graph.NumberOfNodes());
+}
@@ -15,45 +15,48 @@
 
 namespace jet
 {
+    // All the functions below take an optional ExecutionPolicy as their last
+    // argument, which defaults to running in parallel.
+
     //! \brief Assigns \p value to 1D array \p output with \p size.
     //!
     //! This funciton assigns \p value to 1D array output with \p size. The output
     //! array must support random access operator [].
     template<typename ArrayType, typename T>
-    void SetRange1(size_t size, const T& value, ArrayType* output);
+    void SetRange1(size_t size, const T& value, ArrayType* output, ExecutionPolicy policy = ExecutionPolicy::kParallel);
 
     //! \brief Assigns \p value to 1D array \p output from \p begin to \p end.
     template<typename ArrayType, typename T>
-    void SetRange1(size_t begin, size_t end, const T& value, ArrayType* output);
+    void SetRange1(size_t begin, size_t end, const T& value, ArrayType* output, ExecutionPolicy policy = ExecutionPolicy::kParallel);
 
     //! \brief Copies \p input array to \p output array with \p size
     template<typename ArrayType1, typename ArrayType2>
-    void CopyRange1(const ArrayType1& input, size_t size, const ArrayType2* output);
+    void CopyRange1(const ArrayType1& input, size_t size, ArrayType2* output, ExecutionPolicy policy = ExecutionPolicy::kParallel);
 
     //! \brief Copies \p input array to \p output array from \p begin to \p end.
     template<typename ArrayType1, typename ArrayType2>
-    void CopyRange1(const ArrayType1& input, size_t begin, size_t end, ArrayType2* output);
+    void CopyRange1(const ArrayType1& input, size_t begin, size_t end, ArrayType2* output, ExecutionPolicy policy = ExecutionPolicy::kParallel);
     
     //! \brief Copies 2D \p input array to \p output array with \p sizeX and \p sizeY.
     template<typename ArrayType1, typename ArrayType2>
     void CopyRange2(const ArrayType1& input, size_t sizeX,
-                size_t sizeY, ArrayType2* output);
+                size_t sizeY, ArrayType2* output, ExecutionPolicy policy = ExecutionPolicy::kParallel);
     
     //! \brief Copies 2D \p input array to \p output array from ( \p beginX, \p beginY) to ( \p endX, \p endY).
     template<typename ArrayType1, typename ArrayType2>
     void CopyRange2(const ArrayType1& input, size_t beginX, size_t endX,
-                    size_t beginY, size_t endY, ArrayType2* output);
+                    size_t beginY, size_t endY, ArrayType2* output, ExecutionPolicy policy = ExecutionPolicy::kParallel);
 
 
     //! Copies the 3D  \p input array to \p output array with \p sizeX, \p sizeY and \p sizeZ.
     template<typename ArrayType1, typename ArrayType2>
-    void CopyRange3(const ArrayType1& input, size_t sizeX, size_t sizeY, size_t sizeZ, ArrayType2* output);
+    void CopyRange3(const ArrayType1& input, size_t sizeX, size_t sizeY, size_t sizeZ, ArrayType2* output, ExecutionPolicy policy = ExecutionPolicy::kParallel);
 
     //! Copies the 3D \p input array to \p output array with ( \p beginX, \p beginY, \p beginZ) to
     //! ( \p endX, \p endY, \p endZ).
     template<typename ArrayType1, typename ArrayType2>
     void CopyRange3(const ArrayType1& input, size_t beginX, size_t endX,
-                    size_t beginY, size_t endY, size_t beginZ, size_t endZ, ArrayType2* output);
+                    size_t beginY, size_t endY, size_t beginZ, size_t endZ, ArrayType2* output, ExecutionPolicy policy = ExecutionPolicy::kParallel);
 
     
     //! \brief Extrapolates 2D input data from 'valid' (1) to 'invalid' (0) region.
@@ -64,7 +67,7 @@ namespace jet
     //! The input parameters 'valid' and 'data' shoudl be collocated.
     template<typename T>
     void ExtrapolateToRegion(const ConstArrayAccessor2<T>& input, const ConstArrayAccessor2<char>& valid,
-                            unsigned int numberOfIterations, ArrayAccessor2<T> output);
+                            unsigned int numberOfIterations, ArrayAccessor2<T> output, ExecutionPolicy policy = ExecutionPolicy::kParallel);
 
     
     //! \brief Extrapolates 3D input data from 'valid' (1) to 'invalid' (0) region.
@@ -75,7 +78,7 @@ namespace jet
     //! The input parameters 'valid' and 'data' shoudl be collocated.
     template<typename T>
     void ExtrapolateToRegion(const ConstArrayAccessor3<T>& input, const ConstArrayAccessor3<char>& valid,
-                            unsigned int numberOfIterations, ArrayAccessor3<T> output);
+                            unsigned int numberOfIterations, ArrayAccessor3<T> output, ExecutionPolicy policy = ExecutionPolicy::kParallel);
     
     
     //! \brief Converts 2D to CSV stream.
@@ -88,65 +91,74 @@ namespace jet
 
 
     template<typename ArrayType, typename T>
-    void SetRange1(size_t size, const T& value, ArrayType* output)
+    void SetRange1(size_t size, const T& value, ArrayType* output, ExecutionPolicy policy)
     {
-        SetRange1(kZeroSize, size, value, output);
+        SetRange1(kZeroSize, size, value, output, policy);
     }
 
     template<typename ArrayType, typename T>
-    void SetRange1(size_t begin, size_t end, const T& value, ArrayType* output)
+    void SetRange1(size_t begin, size_t end, const T& value, ArrayType* output,
+                    ExecutionPolicy policy)
     {
-        ParallelFor(begin, end, 
-            [&](size_t i )
+        ParallelRangeFor(begin, end,
+            [&](size_t rangeBegin, size_t rangeEnd)
             {
-                (*output)[i] = value;
-            });
+                ArrayType& out = *output;
+                for (size_t i = rangeBegin; i < rangeEnd; ++i)
+                    out[i] = value;
+            }, policy);
     }
 
     template<typename ArrayType1, typename ArrayType2>
-    void CopyRange1(const ArrayType1& input, size_t size, ArrayType2* output)
+    void CopyRange1(const ArrayType1& input, size_t size, ArrayType2* output, ExecutionPolicy policy)
     {
-        CopyRange1(input, 0, size, output);
+        CopyRange1(input, 0, size, output, policy);
     }
 
     template<typename ArrayType1, typename ArrayType2>
-    void CopyRange1(const ArrayType1& input, size_t begin, size_t end, ArrayType2* output)
+    void CopyRange1(const ArrayType1& input, size_t begin, size_t end, ArrayType2* output,
+                    ExecutionPolicy policy)
     {
-        ParallelFor(begin, end,
-                    [&input, &output](size_t i){
-                        (*output)[i] = input[i];
-                    });
+        ParallelRangeFor(begin, end,
+                    [&input, &output](size_t rangeBegin, size_t rangeEnd){
+                        ArrayType2& out = *output;
+                        for (size_t i = rangeBegin; i < rangeEnd; ++i)
+                            out[i] = input[i];
+                    }, policy);
     }
 
     template<typename ArrayType1, typename ArrayType2>
-    void CopyRange2(const ArrayType1& input, size_t sizeX, size_t sizeY, ArrayType2* output)
+    void CopyRange2(const ArrayType1& input, size_t sizeX, size_t sizeY, ArrayType2* output,
+                    ExecutionPolicy policy)
     {
-        CopyRange2(input, kZeroSize, sizeX, kZeroSize, sizeY, output);
+        CopyRange2(input, kZeroSize, sizeX, kZeroSize, sizeY, output, policy);
     }
 
     template<typename ArrayType1, typename ArrayType2>
-    void CopyRange2(const ArrayType1& input, size_t beginX, size_t endX, size_t beginY, size_t endY, ArrayType2* output)
+    void CopyRange2(const ArrayType1& input, size_t beginX, size_t endX, size_t beginY, size_t endY, ArrayType2* output,
+                    ExecutionPolicy policy)
     {
         ParallelFor(beginX, endX, beginY, endY,
                     [&input, &output](size_t i, size_t j){
                         (*output)(i,j) = input(i,j);
-                    });
+                    }, policy);
     }
 
     template<typename ArrayType1, typename ArrayType2>
-    void CopyRange3(const ArrayType1& input, size_t sizeX, size_t sizeY, size_t sizeZ, ArrayType2* output)
+    void CopyRange3(const ArrayType1& input, size_t sizeX, size_t sizeY, size_t sizeZ, ArrayType2* output,
+                    ExecutionPolicy policy)
     {
-        CopyRange3(input, kZeroSize, sizeX, kZeroSize, sizeY, kZeroSize, sizeZ, output);
+        CopyRange3(input, kZeroSize, sizeX, kZeroSize, sizeY, kZeroSize, sizeZ, output, policy);
     }
 
     template<typename ArrayType1, typename ArrayType2>
     void CopyRange3(const ArrayType1& input, size_t beginX, size_t endX, size_t beginY, size_t endY,
-                        size_t beginZ, size_t endZ, ArrayType2* output)
+                        size_t beginZ, size_t endZ, ArrayType2* output, ExecutionPolicy policy)
     {
         ParallelFor(beginX, endX, beginY, endY, beginZ, endZ,
                     [&input, &output](size_t i, size_t j, size_t k){
                         (*output)(i,j,k) = input(i,j,k);
-                    });
+                    }, policy);
     }
 
     template <typename T>
@@ -154,7 +166,8 @@ namespace jet
         const ConstArrayAccessor2<T>& input,
         const ConstArrayAccessor2<char>& valid,
         unsigned int numberOfIterations,
-        ArrayAccessor2<T> output) {
+        ArrayAccessor2<T> output,
+        ExecutionPolicy policy) {
         const Size2 size = input.Size();
 
         JET_ASSERT(size == valid.size());
@@ -163,10 +176,11 @@ namespace jet
         Array2<char> valid0(size);
         Array2<char> valid1(size);
 
-        valid0.ParallelForEachIndex([&](size_t i, size_t j) {
-            valid0(i, j) = valid(i, j);
-            output(i, j) = input(i, j);
-        });
+        // The arrays are collocated, so they can be copied with linear indices.
+        ParallelFor(kZeroSize, size.x * size.y, [&](size_t idx) {
+            valid0[idx] = valid[idx];
+            output[idx] = input[idx];
+        }, policy);
 
         for (unsigned int iter = 0; iter < numberOfIterations; ++iter) {
             valid0.ForEachIndex([&](size_t i, size_t j) {
@@ -214,7 +228,8 @@ namespace jet
         const ConstArrayAccessor3<T>& input,
         const ConstArrayAccessor3<char>& valid,
         unsigned int numberOfIterations,
-        ArrayAccessor3<T> output) {
+        ArrayAccessor3<T> output,
+        ExecutionPolicy policy) {
         const Size3 size = input.Size();
 
         JET_ASSERT(size == valid.Size());
@@ -223,10 +238,11 @@ namespace jet
         Array3<char> valid0(size);
         Array3<char> valid1(size);
 
-        valid0.ParallelForEachIndex([&](size_t i, size_t j, size_t k) {
-            valid0(i, j, k) = valid(i, j, k);
-            output(i, j, k) = input(i, j, k);
-        });
+        // The arrays are collocated, so they can be copied with linear indices.
+        ParallelFor(kZeroSize, size.x * size.y * size.z, [&](size_t idx) {
+            valid0[idx] = valid[idx];
+            output[idx] = input[idx];
+        }, policy);
 
         for (unsigned int iter = 0; iter < numberOfIterations; ++iter) {
             valid0.ForEachIndex([&](size_t i, size_t j, size_t k) {
@@ -61,6 +61,13 @@ namespace jet{
         //! Resizes the array with \p size and fill the new element with \p initVal.
         void Resize(size_t size, const T& initVal = T());
 
+        //! Reserves memory for at least \p capacity elements without changing
+        //! the size, so that growing up to \p capacity does not reallocate.
+        void Reserve(size_t capacity);
+
+        //! Returns the number of elements the array can hold without reallocation.
+        size_t Capacity() const;
+
         //! Returns the reference to the i-th element.
         T& At(size_t i);
 
@@ -103,6 +110,9 @@ namespace jet{
         //! Appends \p other array at the end of the array.
         void Append(const Array& other);
 
+        //! Appends the elements of \p other accessor at the end of the array.
+        void Append(const ConstArrayAccessor1<T>& other);
+
         //! 
         //! \brief Iterates the array and invoke the give \p func for each element.
         //!
@@ -285,6 +295,18 @@ namespace jet{
         _data.resize(size, initVal);
     }
 
+    template <typename T>
+    void Array<T, 1>::Reserve(size_t capacity)
+    {
+        _data.reserve(capacity);
+    }
+
+    template <typename T>
+    size_t Array<T, 1>::Capacity() const
+    {
+        return _data.capacity();
+    }
+
     template<typename T>
     T& Array<T,1>::At(size_t i)
     {
@@ -370,6 +392,12 @@ namespace jet{
         _data.insert(_data.end(), other._data.begin(), other._data.end());
     }
 
+    template<typename T>
+    void Array<T,1>::Append(const ConstArrayAccessor1<T>& other)
+    {
+        _data.insert(_data.end(), other.begin(), other.end());
+    }
+
     template <typename T>
     template <typename Callback>
     void Array<T,1>::ForEach(Callback func) const
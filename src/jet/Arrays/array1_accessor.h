@@ -395,8 +395,10 @@ namespace jet
     template <typename T>
     template <typename Callback>
     void ArrayAccessor<T, 1>::ParallelForEach(Callback func) {
-        ParallelFor(kZeroSize, Size(), [&](size_t i) {
-            func(At(i));
+        T* const data = _data;
+        ParallelRangeFor(kZeroSize, Size(), [&func, data](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                func(data[i]);
         });
     }
 
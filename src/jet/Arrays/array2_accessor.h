@@ -575,7 +575,7 @@ namespace jet
     template <typename T>
     template <typename Callback>
     void ArrayAccessor<T, 2>::ParallelForEachIndex(Callback func) const {
-        ParallelFor(kZeroSize, _size.x, kZeroSize, _size.y, func);
+        ParallelTiledFor(kZeroSize, _size.x, kZeroSize, _size.y, func);
     }
 
 
@@ -761,7 +761,7 @@ namespace jet
     template <typename T>
     template <typename Callback>
     void ConstArrayAccessor<T, 2>::ParallelForEachIndex(Callback func) const {
-        ParallelFor(kZeroSize, _size.x, kZeroSize, _size.y, func);
+        ParallelTiledFor(kZeroSize, _size.x, kZeroSize, _size.y, func);
     }
 
     template <typename T>
@@ -597,7 +597,7 @@ namespace jet
     template <typename T>
     template <typename Callback>
     void ArrayAccessor<T, 3>::ParallelForEachIndex(Callback func) const {
-        ParallelFor(
+        ParallelTiledFor(
             kZeroSize, _size.x, kZeroSize, _size.y, kZeroSize, _size.z, func);
     }
 
@@ -793,7 +793,7 @@ namespace jet
     template <typename T>
     template <typename Callback>
     void ConstArrayAccessor<T, 3>::ParallelForEachIndex(Callback func) const {
-        ParallelFor(
+        ParallelTiledFor(
             kZeroSize, _size.x, kZeroSize, _size.y, kZeroSize, _size.z, func);
     }
 
@@ -36,6 +36,9 @@ namespace jet
         //! Constructs a box with other box instance.
         BoundingBox(const BoundingBox& other);
 
+        //! Copies other box instance to this box.
+        BoundingBox& operator=(const BoundingBox& other) = default;
+
         //! Returns true if box this and \p other box overlaps.
         bool Overlaps(const BoundingBox& other) const;
 
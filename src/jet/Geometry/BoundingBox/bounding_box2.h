@@ -50,6 +50,9 @@ namespace jet
         //! Constructs a box with other box instance.
         BoundingBox(const BoundingBox& other);
 
+        //! Copies other box instance to this box.
+        BoundingBox& operator=(const BoundingBox& other) = default;
+
         //! Returns the width of the box
         T Width() const;
 
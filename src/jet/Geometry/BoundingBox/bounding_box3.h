@@ -48,6 +48,9 @@ namespace jet
         //! Copy constructor
         BoundingBox(const BoundingBox& other);
 
+        //! Copies other box instance to this box.
+        BoundingBox& operator=(const BoundingBox& other) = default;
+
         //! Returns the width of the box.
         T Width() const;
 
@@ -1,15 +1,19 @@
 #include <jet.h>
 #include <Matrix/matrix2.h>
+#include <parallel.h>
+#include <NeighborhoodSearch/hash_grid_utils.h>
 #include <NeighborhoodSearch/point2_hash_grid_search.h>
 #include <Samplers/Samplers.h>
 #include <Geometry/Surface/surface_to_implicit2.h>
 #include "volume_particle_emitter2.h"
 #include <Geometry/PointGenerator/triangle_point_generator.h>
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 namespace jet
 {
-    static const size_t kDefaultHashGridResolution = 64;
-
     VolumeParticleEmitter2::VolumeParticleEmitter2(const ImplicitSurface2Ptr& implicitSurface,
                         const BoundingBox2D& bounds, double spacing,
                         const Vector2D& initialVelocity,
@@ -55,32 +59,66 @@ namespace jet
 
         if (_AllowOverlapping || _IsOneShot)
         {
+            // The candidates are generated serially so that the random numbers
+            // are drawn in the same order, then the signed distances are
+            // evaluated in parallel and the inside candidates are compacted.
+            const std::mt19937 rngBeforeEmit = _rng;
+
+            std::vector<Vector2D> candidates;
             _PointsGen->ForEachPoint(_Bounds, _Spacing,
                         [&](const Vector2D& point){
                             double newAngleInRadians = (Random() - 0.5) * kTwoPiD;
                             Matrix2x2D rotationMatrix = Matrix2x2D::MakeRotationMatrix(newAngleInRadians);
                             Vector2D randomDir = rotationMatrix * Vector2D();
                             Vector2D offset = maxJitterDist * randomDir;
-                            Vector2D candidate = point + offset;
-                            if (_ImplicitSurface->SignedDistance(candidate) <= 0.0)
-                            {
-                                if (_NumberOfEmittedParticles < _MaxNumberOfParticles)
-                                {
-                                    newPositions->Append(candidate);
-                                    ++_NumberOfEmittedParticles;
-                                }
-                                else
-                                    return false;
-                            }
+                            candidates.push_back(point + offset);
                             return true;
-
                         });
+
+            std::vector<size_t> candidateIndices(candidates.size());
+            ParallelFor(kZeroSize, candidates.size(), [&](size_t i){
+                candidateIndices[i] = i;
+            });
+
+            std::vector<size_t> insideIndices(candidates.size());
+            size_t NumInside = ParallelCompact(candidateIndices.begin(), candidateIndices.end(),
+                        [&](size_t i){
+                            return _ImplicitSurface->SignedDistance(candidates[i]) <= 0.0;
+                        }, insideIndices.begin());
+
+            const size_t NumRemaining = _MaxNumberOfParticles - std::min(_NumberOfEmittedParticles, _MaxNumberOfParticles);
+            if (NumInside > NumRemaining)
+            {
+                // The points after the first candidate exceeding the limit
+                // were never visited before, so rewind the generator to keep
+                // the same random sequence for the next emissions.
+                _rng = rngBeforeEmit;
+                for (size_t i = 0; i <= insideIndices[NumRemaining]; ++i)
+                    Random();
+
+                NumInside = NumRemaining;
+            }
+
+            const size_t NumExisting = newPositions->Size();
+            newPositions->Resize(NumExisting + NumInside);
+            ParallelFor(kZeroSize, NumInside, [&](size_t i){
+                (*newPositions)[NumExisting + i] = candidates[insideIndices[i]];
+            });
+            _NumberOfEmittedParticles += NumInside;
         }
         else
         {
-            // Use serial hash grid search for continuous update.
-            PointHashGridSearch2 neighborSearch(Size2(kDefaultHashGridResolution, kDefaultHashGridResolution)
-                                , 2.0 * _Spacing);
+            // Use serial hash grid search for continuous update. The queries
+            // are all in the emission region, so the grid is sized for it and
+            // for the particles which can end up there. Particles elsewhere
+            // wrap around the table.
+            BoundingBox2D searchBounds = _Bounds;
+            searchBounds.Expand(2.0 * _Spacing);
+            const size_t MaxNumCandidates = static_cast<size_t>(
+                        std::ceil(_Bounds.Width() / _Spacing) * std::ceil(_Bounds.Height() / _Spacing));
+            const Size2 Resolution = SuggestHashGridResolution(searchBounds,
+                        particles->NumberOfParticles() + MaxNumCandidates, 2.0 * _Spacing);
+            PointHashGridSearch2 neighborSearch(Resolution, 2.0 * _Spacing);
             if (!_AllowOverlapping)
                 neighborSearch.Build(particles->Positions());
             
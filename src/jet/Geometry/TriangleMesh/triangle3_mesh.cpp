@@ -110,17 +110,21 @@ namespace jet
 
     BoundingBox3D TriangleMesh3::BoundingBoxLocal() const
     {
-        BoundingBox3D box;
         size_t n = _PointIndices.Size();
-        for(size_t i = 0; i < n; ++i)
-        {
-            const Point3UI& face = _PointIndices[i];
-            box.Merge(_Points[face[0]]);
-            box.Merge(_Points[face[1]]);
-            box.Merge(_Points[face[2]]);
-        }
-        
-        return box;
+        return ParallelReduce(kZeroSize, n, BoundingBox3D(),
+                    [&](size_t i)
+                    {
+                        const Point3UI& face = _PointIndices[i];
+                        BoundingBox3D box(_Points[face[0]], _Points[face[1]]);
+                        box.Merge(_Points[face[2]]);
+                        return box;
+                    },
+                    [](const BoundingBox3D& a, const BoundingBox3D& b)
+                    {
+                        BoundingBox3D box = a;
+                        box.Merge(b);
+                        return box;
+                    });
     }
 
     
@@ -1,9 +1,13 @@
 #include <jet.h>
 #include "factory.h"
 
+#include <NeighborhoodSearch/point2_compact_hash_grid_search.h>
 #include <NeighborhoodSearch/point2_hash_grid_search.h>
+#include <NeighborhoodSearch/point2_kdtree_search.h>
 #include <NeighborhoodSearch/point2_parallel_hash_grid_search.h>
+#include <NeighborhoodSearch/point3_compact_hash_grid_search.h>
 #include <NeighborhoodSearch/point3_hash_grid_search.h>
+#include <NeighborhoodSearch/point3_kdtree_search.h>
 #include <NeighborhoodSearch/point3_parallel_hash_grid_search.h>
 
 #include <string>
@@ -34,9 +38,13 @@ namespace jet
         {
             REGISTER_POINT_NEIGHBOR_SEARCH2_BUILDER(PointHashGridSearch2)
             REGISTER_POINT_NEIGHBOR_SEARCH2_BUILDER(PointParallelHashGridSearch2)
+            REGISTER_POINT_NEIGHBOR_SEARCH2_BUILDER(PointCompactHashGridSearch2)
+            REGISTER_POINT_NEIGHBOR_SEARCH2_BUILDER(PointKdTreeSearch2)
             
             REGISTER_POINT_NEIGHBOR_SEARCH3_BUILDER(PointHashGridSearch3)
             REGISTER_POINT_NEIGHBOR_SEARCH3_BUILDER(PointParallelHashGridSearch3)
+            REGISTER_POINT_NEIGHBOR_SEARCH3_BUILDER(PointCompactHashGridSearch3)
+            REGISTER_POINT_NEIGHBOR_SEARCH3_BUILDER(PointKdTreeSearch3)
         }
     };
 
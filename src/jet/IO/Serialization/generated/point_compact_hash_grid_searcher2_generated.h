@@ -0,0 +1,76 @@
+// automatically generated by the FlatBuffers compiler, do not modify
+
+#ifndef FLATBUFFERS_GENERATED_POINTCOMPACTHASHGRIDSEARCHER2_JET_FBS_H_
+#define FLATBUFFERS_GENERATED_POINTCOMPACTHASHGRIDSEARCHER2_JET_FBS_H_
+
+#include "flatbuffers/flatbuffers.h"
+
+#include "basic_types_generated.h"
+
+namespace jet {
+namespace fbs {
+
+struct PointCompactHashGridSearcher2;
+
+struct PointCompactHashGridSearcher2 FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum {
+    VT_GRIDSPACING = 4,
+    VT_POINTS = 6,
+    VT_SORTEDINDICES = 8
+  };
+  double gridSpacing() const { return GetField<double>(VT_GRIDSPACING, 0.0); }
+  const flatbuffers::Vector<const jet::fbs::Vector2D *> *points() const { return GetPointer<const flatbuffers::Vector<const jet::fbs::Vector2D *> *>(VT_POINTS); }
+  const flatbuffers::Vector<uint64_t> *sortedIndices() const { return GetPointer<const flatbuffers::Vector<uint64_t> *>(VT_SORTEDINDICES); }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<double>(verifier, VT_GRIDSPACING) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_POINTS) &&
+           verifier.Verify(points()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_SORTEDINDICES) &&
+           verifier.Verify(sortedIndices()) &&
+           verifier.EndTable();
+  }
+};
+
+struct PointCompactHashGridSearcher2Builder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_gridSpacing(double gridSpacing) { fbb_.AddElement<double>(PointCompactHashGridSearcher2::VT_GRIDSPACING, gridSpacing, 0.0); }
+  void add_points(flatbuffers::Offset<flatbuffers::Vector<const jet::fbs::Vector2D *>> points) { fbb_.AddOffset(PointCompactHashGridSearcher2::VT_POINTS, points); }
+  void add_sortedIndices(flatbuffers::Offset<flatbuffers::Vector<uint64_t>> sortedIndices) { fbb_.AddOffset(PointCompactHashGridSearcher2::VT_SORTEDINDICES, sortedIndices); }
+  PointCompactHashGridSearcher2Builder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  PointCompactHashGridSearcher2Builder &operator=(const PointCompactHashGridSearcher2Builder &);
+  flatbuffers::Offset<PointCompactHashGridSearcher2> Finish() {
+    auto o = flatbuffers::Offset<PointCompactHashGridSearcher2>(fbb_.EndTable(start_, 3));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<PointCompactHashGridSearcher2> CreatePointCompactHashGridSearcher2(flatbuffers::FlatBufferBuilder &_fbb,
+    double gridSpacing = 0.0,
+    flatbuffers::Offset<flatbuffers::Vector<const jet::fbs::Vector2D *>> points = 0,
+    flatbuffers::Offset<flatbuffers::Vector<uint64_t>> sortedIndices = 0) {
+  PointCompactHashGridSearcher2Builder builder_(_fbb);
+  builder_.add_gridSpacing(gridSpacing);
+  builder_.add_sortedIndices(sortedIndices);
+  builder_.add_points(points);
+  return builder_.Finish();
+}
+
+inline flatbuffers::Offset<PointCompactHashGridSearcher2> CreatePointCompactHashGridSearcher2Direct(flatbuffers::FlatBufferBuilder &_fbb,
+    double gridSpacing = 0.0,
+    const std::vector<const jet::fbs::Vector2D *> *points = nullptr,
+    const std::vector<uint64_t> *sortedIndices = nullptr) {
+  return CreatePointCompactHashGridSearcher2(_fbb, gridSpacing, points ? _fbb.CreateVector<const jet::fbs::Vector2D *>(*points) : 0, sortedIndices ? _fbb.CreateVector<uint64_t>(*sortedIndices) : 0);
+}
+
+inline const jet::fbs::PointCompactHashGridSearcher2 *GetPointCompactHashGridSearcher2(const void *buf) { return flatbuffers::GetRoot<jet::fbs::PointCompactHashGridSearcher2>(buf); }
+
+inline bool VerifyPointCompactHashGridSearcher2Buffer(flatbuffers::Verifier &verifier) { return verifier.VerifyBuffer<jet::fbs::PointCompactHashGridSearcher2>(nullptr); }
+
+inline void FinishPointCompactHashGridSearcher2Buffer(flatbuffers::FlatBufferBuilder &fbb, flatbuffers::Offset<jet::fbs::PointCompactHashGridSearcher2> root) { fbb.Finish(root); }
+
+}  // namespace fbs
+}  // namespace jet
+
+#endif  // FLATBUFFERS_GENERATED_POINTCOMPACTHASHGRIDSEARCHER2_JET_FBS_H_
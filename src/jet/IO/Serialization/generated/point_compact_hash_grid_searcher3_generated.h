@@ -0,0 +1,76 @@
+// automatically generated by the FlatBuffers compiler, do not modify
+
+#ifndef FLATBUFFERS_GENERATED_POINTCOMPACTHASHGRIDSEARCHER3_JET_FBS_H_
+#define FLATBUFFERS_GENERATED_POINTCOMPACTHASHGRIDSEARCHER3_JET_FBS_H_
+
+#include "flatbuffers/flatbuffers.h"
+
+#include "basic_types_generated.h"
+
+namespace jet {
+namespace fbs {
+
+struct PointCompactHashGridSearcher3;
+
+struct PointCompactHashGridSearcher3 FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum {
+    VT_GRIDSPACING = 4,
+    VT_POINTS = 6,
+    VT_SORTEDINDICES = 8
+  };
+  double gridSpacing() const { return GetField<double>(VT_GRIDSPACING, 0.0); }
+  const flatbuffers::Vector<const jet::fbs::Vector3D *> *points() const { return GetPointer<const flatbuffers::Vector<const jet::fbs::Vector3D *> *>(VT_POINTS); }
+  const flatbuffers::Vector<uint64_t> *sortedIndices() const { return GetPointer<const flatbuffers::Vector<uint64_t> *>(VT_SORTEDINDICES); }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<double>(verifier, VT_GRIDSPACING) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_POINTS) &&
+           verifier.Verify(points()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_SORTEDINDICES) &&
+           verifier.Verify(sortedIndices()) &&
+           verifier.EndTable();
+  }
+};
+
+struct PointCompactHashGridSearcher3Builder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_gridSpacing(double gridSpacing) { fbb_.AddElement<double>(PointCompactHashGridSearcher3::VT_GRIDSPACING, gridSpacing, 0.0); }
+  void add_points(flatbuffers::Offset<flatbuffers::Vector<const jet::fbs::Vector3D *>> points) { fbb_.AddOffset(PointCompactHashGridSearcher3::VT_POINTS, points); }
+  void add_sortedIndices(flatbuffers::Offset<flatbuffers::Vector<uint64_t>> sortedIndices) { fbb_.AddOffset(PointCompactHashGridSearcher3::VT_SORTEDINDICES, sortedIndices); }
+  PointCompactHashGridSearcher3Builder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  PointCompactHashGridSearcher3Builder &operator=(const PointCompactHashGridSearcher3Builder &);
+  flatbuffers::Offset<PointCompactHashGridSearcher3> Finish() {
+    auto o = flatbuffers::Offset<PointCompactHashGridSearcher3>(fbb_.EndTable(start_, 3));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<PointCompactHashGridSearcher3> CreatePointCompactHashGridSearcher3(flatbuffers::FlatBufferBuilder &_fbb,
+    double gridSpacing = 0.0,
+    flatbuffers::Offset<flatbuffers::Vector<const jet::fbs::Vector3D *>> points = 0,
+    flatbuffers::Offset<flatbuffers::Vector<uint64_t>> sortedIndices = 0) {
+  PointCompactHashGridSearcher3Builder builder_(_fbb);
+  builder_.add_gridSpacing(gridSpacing);
+  builder_.add_sortedIndices(sortedIndices);
+  builder_.add_points(points);
+  return builder_.Finish();
+}
+
+inline flatbuffers::Offset<PointCompactHashGridSearcher3> CreatePointCompactHashGridSearcher3Direct(flatbuffers::FlatBufferBuilder &_fbb,
+    double gridSpacing = 0.0,
+    const std::vector<const jet::fbs::Vector3D *> *points = nullptr,
+    const std::vector<uint64_t> *sortedIndices = nullptr) {
+  return CreatePointCompactHashGridSearcher3(_fbb, gridSpacing, points ? _fbb.CreateVector<const jet::fbs::Vector3D *>(*points) : 0, sortedIndices ? _fbb.CreateVector<uint64_t>(*sortedIndices) : 0);
+}
+
+inline const jet::fbs::PointCompactHashGridSearcher3 *GetPointCompactHashGridSearcher3(const void *buf) { return flatbuffers::GetRoot<jet::fbs::PointCompactHashGridSearcher3>(buf); }
+
+inline bool VerifyPointCompactHashGridSearcher3Buffer(flatbuffers::Verifier &verifier) { return verifier.VerifyBuffer<jet::fbs::PointCompactHashGridSearcher3>(nullptr); }
+
+inline void FinishPointCompactHashGridSearcher3Buffer(flatbuffers::FlatBufferBuilder &fbb, flatbuffers::Offset<jet::fbs::PointCompactHashGridSearcher3> root) { fbb.Finish(root); }
+
+}  // namespace fbs
+}  // namespace jet
+
+#endif  // FLATBUFFERS_GENERATED_POINTCOMPACTHASHGRIDSEARCHER3_JET_FBS_H_
@@ -0,0 +1,76 @@
+// automatically generated by the FlatBuffers compiler, do not modify
+
+#ifndef FLATBUFFERS_GENERATED_POINTKDTREESEARCHER2_JET_FBS_H_
+#define FLATBUFFERS_GENERATED_POINTKDTREESEARCHER2_JET_FBS_H_
+
+#include "flatbuffers/flatbuffers.h"
+
+#include "basic_types_generated.h"
+
+namespace jet {
+namespace fbs {
+
+struct PointKdTreeSearcher2;
+
+struct PointKdTreeSearcher2 FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum {
+    VT_MAXLEAFSIZE = 4,
+    VT_POINTS = 6,
+    VT_SORTEDINDICES = 8
+  };
+  uint64_t maxLeafSize() const { return GetField<uint64_t>(VT_MAXLEAFSIZE, 0); }
+  const flatbuffers::Vector<const jet::fbs::Vector2D *> *points() const { return GetPointer<const flatbuffers::Vector<const jet::fbs::Vector2D *> *>(VT_POINTS); }
+  const flatbuffers::Vector<uint64_t> *sortedIndices() const { return GetPointer<const flatbuffers::Vector<uint64_t> *>(VT_SORTEDINDICES); }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint64_t>(verifier, VT_MAXLEAFSIZE) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_POINTS) &&
+           verifier.Verify(points()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_SORTEDINDICES) &&
+           verifier.Verify(sortedIndices()) &&
+           verifier.EndTable();
+  }
+};
+
+struct PointKdTreeSearcher2Builder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_maxLeafSize(uint64_t maxLeafSize) { fbb_.AddElement<uint64_t>(PointKdTreeSearcher2::VT_MAXLEAFSIZE, maxLeafSize, 0); }
+  void add_points(flatbuffers::Offset<flatbuffers::Vector<const jet::fbs::Vector2D *>> points) { fbb_.AddOffset(PointKdTreeSearcher2::VT_POINTS, points); }
+  void add_sortedIndices(flatbuffers::Offset<flatbuffers::Vector<uint64_t>> sortedIndices) { fbb_.AddOffset(PointKdTreeSearcher2::VT_SORTEDINDICES, sortedIndices); }
+  PointKdTreeSearcher2Builder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  PointKdTreeSearcher2Builder &operator=(const PointKdTreeSearcher2Builder &);
+  flatbuffers::Offset<PointKdTreeSearcher2> Finish() {
+    auto o = flatbuffers::Offset<PointKdTreeSearcher2>(fbb_.EndTable(start_, 3));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<PointKdTreeSearcher2> CreatePointKdTreeSearcher2(flatbuffers::FlatBufferBuilder &_fbb,
+    uint64_t maxLeafSize = 0,
+    flatbuffers::Offset<flatbuffers::Vector<const jet::fbs::Vector2D *>> points = 0,
+    flatbuffers::Offset<flatbuffers::Vector<uint64_t>> sortedIndices = 0) {
+  PointKdTreeSearcher2Builder builder_(_fbb);
+  builder_.add_maxLeafSize(maxLeafSize);
+  builder_.add_sortedIndices(sortedIndices);
+  builder_.add_points(points);
+  return builder_.Finish();
+}
+
+inline flatbuffers::Offset<PointKdTreeSearcher2> CreatePointKdTreeSearcher2Direct(flatbuffers::FlatBufferBuilder &_fbb,
+    uint64_t maxLeafSize = 0,
+    const std::vector<const jet::fbs::Vector2D *> *points = nullptr,
+    const std::vector<uint64_t> *sortedIndices = nullptr) {
+  return CreatePointKdTreeSearcher2(_fbb, maxLeafSize, points ? _fbb.CreateVector<const jet::fbs::Vector2D *>(*points) : 0, sortedIndices ? _fbb.CreateVector<uint64_t>(*sortedIndices) : 0);
+}
+
+inline const jet::fbs::PointKdTreeSearcher2 *GetPointKdTreeSearcher2(const void *buf) { return flatbuffers::GetRoot<jet::fbs::PointKdTreeSearcher2>(buf); }
+
+inline bool VerifyPointKdTreeSearcher2Buffer(flatbuffers::Verifier &verifier) { return verifier.VerifyBuffer<jet::fbs::PointKdTreeSearcher2>(nullptr); }
+
+inline void FinishPointKdTreeSearcher2Buffer(flatbuffers::FlatBufferBuilder &fbb, flatbuffers::Offset<jet::fbs::PointKdTreeSearcher2> root) { fbb.Finish(root); }
+
+}  // namespace fbs
+}  // namespace jet
+
+#endif  // FLATBUFFERS_GENERATED_POINTKDTREESEARCHER2_JET_FBS_H_
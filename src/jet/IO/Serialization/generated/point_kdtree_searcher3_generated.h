@@ -0,0 +1,76 @@
+// automatically generated by the FlatBuffers compiler, do not modify
+
+#ifndef FLATBUFFERS_GENERATED_POINTKDTREESEARCHER3_JET_FBS_H_
+#define FLATBUFFERS_GENERATED_POINTKDTREESEARCHER3_JET_FBS_H_
+
+#include "flatbuffers/flatbuffers.h"
+
+#include "basic_types_generated.h"
+
+namespace jet {
+namespace fbs {
+
+struct PointKdTreeSearcher3;
+
+struct PointKdTreeSearcher3 FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum {
+    VT_MAXLEAFSIZE = 4,
+    VT_POINTS = 6,
+    VT_SORTEDINDICES = 8
+  };
+  uint64_t maxLeafSize() const { return GetField<uint64_t>(VT_MAXLEAFSIZE, 0); }
+  const flatbuffers::Vector<const jet::fbs::Vector3D *> *points() const { return GetPointer<const flatbuffers::Vector<const jet::fbs::Vector3D *> *>(VT_POINTS); }
+  const flatbuffers::Vector<uint64_t> *sortedIndices() const { return GetPointer<const flatbuffers::Vector<uint64_t> *>(VT_SORTEDINDICES); }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint64_t>(verifier, VT_MAXLEAFSIZE) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_POINTS) &&
+           verifier.Verify(points()) &&
+           VerifyField<flatbuffers::uoffset_t>(verifier, VT_SORTEDINDICES) &&
+           verifier.Verify(sortedIndices()) &&
+           verifier.EndTable();
+  }
+};
+
+struct PointKdTreeSearcher3Builder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_maxLeafSize(uint64_t maxLeafSize) { fbb_.AddElement<uint64_t>(PointKdTreeSearcher3::VT_MAXLEAFSIZE, maxLeafSize, 0); }
+  void add_points(flatbuffers::Offset<flatbuffers::Vector<const jet::fbs::Vector3D *>> points) { fbb_.AddOffset(PointKdTreeSearcher3::VT_POINTS, points); }
+  void add_sortedIndices(flatbuffers::Offset<flatbuffers::Vector<uint64_t>> sortedIndices) { fbb_.AddOffset(PointKdTreeSearcher3::VT_SORTEDINDICES, sortedIndices); }
+  PointKdTreeSearcher3Builder(flatbuffers::FlatBufferBuilder &_fbb) : fbb_(_fbb) { start_ = fbb_.StartTable(); }
+  PointKdTreeSearcher3Builder &operator=(const PointKdTreeSearcher3Builder &);
+  flatbuffers::Offset<PointKdTreeSearcher3> Finish() {
+    auto o = flatbuffers::Offset<PointKdTreeSearcher3>(fbb_.EndTable(start_, 3));
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<PointKdTreeSearcher3> CreatePointKdTreeSearcher3(flatbuffers::FlatBufferBuilder &_fbb,
+    uint64_t maxLeafSize = 0,
+    flatbuffers::Offset<flatbuffers::Vector<const jet::fbs::Vector3D *>> points = 0,
+    flatbuffers::Offset<flatbuffers::Vector<uint64_t>> sortedIndices = 0) {
+  PointKdTreeSearcher3Builder builder_(_fbb);
+  builder_.add_maxLeafSize(maxLeafSize);
+  builder_.add_sortedIndices(sortedIndices);
+  builder_.add_points(points);
+  return builder_.Finish();
+}
+
+inline flatbuffers::Offset<PointKdTreeSearcher3> CreatePointKdTreeSearcher3Direct(flatbuffers::FlatBufferBuilder &_fbb,
+    uint64_t maxLeafSize = 0,
+    const std::vector<const jet::fbs::Vector3D *> *points = nullptr,
+    const std::vector<uint64_t> *sortedIndices = nullptr) {
+  return CreatePointKdTreeSearcher3(_fbb, maxLeafSize, points ? _fbb.CreateVector<const jet::fbs::Vector3D *>(*points) : 0, sortedIndices ? _fbb.CreateVector<uint64_t>(*sortedIndices) : 0);
+}
+
+inline const jet::fbs::PointKdTreeSearcher3 *GetPointKdTreeSearcher3(const void *buf) { return flatbuffers::GetRoot<jet::fbs::PointKdTreeSearcher3>(buf); }
+
+inline bool VerifyPointKdTreeSearcher3Buffer(flatbuffers::Verifier &verifier) { return verifier.VerifyBuffer<jet::fbs::PointKdTreeSearcher3>(nullptr); }
+
+inline void FinishPointKdTreeSearcher3Buffer(flatbuffers::FlatBufferBuilder &fbb, flatbuffers::Offset<jet::fbs::PointKdTreeSearcher3> root) { fbb.Finish(root); }
+
+}  // namespace fbs
+}  // namespace jet
+
+#endif  // FLATBUFFERS_GENERATED_POINTKDTREESEARCHER3_JET_FBS_H_
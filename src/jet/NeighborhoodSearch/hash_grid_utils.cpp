@@ -0,0 +1,114 @@
+#include <jet.h>
+#include <macros.h>
+#include "hash_grid_utils.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace jet
+{
+    namespace
+    {
+        // Returns the number of grid cells spanned by [lower, upper] along one axis.
+        double NumberOfCells(double lower, double upper, double gridSpacing)
+        {
+            if (upper < lower)
+                return 1.0;
+
+            return std::floor(upper / gridSpacing) - std::floor(lower / gridSpacing) + 1.0;
+        }
+
+        // Scales down the number of cells of each axis so that their product
+        // is about maxNumberOfBuckets. The axes with few cells, e.g. the thin
+        // axis of a flat domain, are kept, and the rest of the budget is split
+        // evenly between the other axes.
+        template<size_t N>
+        void FitToNumberOfBuckets(std::array<double, N>* cells, double maxNumberOfBuckets)
+        {
+            double product = 1.0;
+            for (double c : *cells)
+                product *= c;
+
+            if (product <= maxNumberOfBuckets)
+                return;
+
+            std::array<size_t, N> axes;
+            for (size_t a = 0; a < N; ++a)
+                axes[a] = a;
+            std::sort(axes.begin(), axes.end(),
+                        [&](size_t a, size_t b) { return (*cells)[a] < (*cells)[b]; });
+
+            double budget = maxNumberOfBuckets;
+            for (size_t k = 0; k < N; ++k)
+            {
+                const double remaining = static_cast<double>(N - k);
+                if ((*cells)[axes[k]] <= std::pow(budget, 1.0 / remaining))
+                {
+                    budget /= (*cells)[axes[k]];
+                    continue;
+                }
+
+                // The remaining axes all exceed their share, scale them uniformly.
+                double remainingProduct = 1.0;
+                for (size_t j = k; j < N; ++j)
+                    remainingProduct *= (*cells)[axes[j]];
+
+                const double scale = std::pow(budget / remainingProduct, 1.0 / remaining);
+                for (size_t j = k; j < N; ++j)
+                    (*cells)[axes[j]] = std::round((*cells)[axes[j]] * scale);
+                return;
+            }
+        }
+
+        size_t ToResolution(double numberOfCells)
+        {
+            return static_cast<size_t>(std::max(numberOfCells, 2.0));
+        }
+    }
+
+    double HashGridStatistics::Occupancy() const
+    {
+        if (NumberOfBuckets == 0)
+            return 0.0;
+
+        return static_cast<double>(NumberOfNonEmptyBuckets) / static_cast<double>(NumberOfBuckets);
+    }
+
+    double HashGridStatistics::AverageNumberOfPointsPerNonEmptyBucket() const
+    {
+        if (NumberOfNonEmptyBuckets == 0)
+            return 0.0;
+
+        return static_cast<double>(NumberOfPoints) / static_cast<double>(NumberOfNonEmptyBuckets);
+    }
+
+    Size2 SuggestHashGridResolution(const BoundingBox2D& bounds, size_t numberOfPoints,
+                    double gridSpacing, double loadFactor)
+    {
+        JET_THROW_INVALID_ARG_IF(gridSpacing <= 0.0 || loadFactor <= 0.0);
+
+        std::array<double, 2> cells = {
+            NumberOfCells(bounds.LowerCorner.x, bounds.UpperCorner.x, gridSpacing),
+            NumberOfCells(bounds.LowerCorner.y, bounds.UpperCorner.y, gridSpacing)
+        };
+        FitToNumberOfBuckets(&cells, std::max(numberOfPoints / loadFactor, 1.0));
+
+        return Size2(ToResolution(cells[0]), ToResolution(cells[1]));
+    }
+
+    Size3 SuggestHashGridResolution(const BoundingBox3D& bounds, size_t numberOfPoints,
+                    double gridSpacing, double loadFactor)
+    {
+        JET_THROW_INVALID_ARG_IF(gridSpacing <= 0.0 || loadFactor <= 0.0);
+
+        std::array<double, 3> cells = {
+            NumberOfCells(bounds.LowerCorner.x, bounds.UpperCorner.x, gridSpacing),
+            NumberOfCells(bounds.LowerCorner.y, bounds.UpperCorner.y, gridSpacing),
+            NumberOfCells(bounds.LowerCorner.z, bounds.UpperCorner.z, gridSpacing)
+        };
+        FitToNumberOfBuckets(&cells, std::max(numberOfPoints / loadFactor, 1.0));
+
+        return Size3(ToResolution(cells[0]), ToResolution(cells[1]), ToResolution(cells[2]));
+    }
+}
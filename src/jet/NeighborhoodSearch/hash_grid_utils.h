@@ -0,0 +1,125 @@
+#pragma once
+
+#include <Geometry/BoundingBox/bounding_box2.h>
+#include <Geometry/BoundingBox/bounding_box3.h>
+#include <Size/size2.h>
+#include <Size/size3.h>
+#include <constants.h>
+#include <parallel.h>
+
+#include <vector>
+
+namespace jet
+{
+    //! Default maximum average number of points per bucket of an
+    //! automatically sized hash grid.
+    constexpr double kDefaultHashGridLoadFactor = 1.0;
+
+    //! \brief Statistics of the buckets of a hash grid, computed when it is built.
+    //!
+    //! The grid cells are wrapped into the buckets of the table, so distant
+    //! cells can share a bucket. A query then has to filter out the points of
+    //! the other cells, which is what the colliding buckets count.
+    struct HashGridStatistics
+    {
+        //! Number of points in the grid.
+        size_t NumberOfPoints = 0;
+
+        //! Number of buckets of the table.
+        size_t NumberOfBuckets = 0;
+
+        //! Number of buckets holding at least one point.
+        size_t NumberOfNonEmptyBuckets = 0;
+
+        //! Number of buckets holding the points of more than one grid cell.
+        size_t NumberOfCollidingBuckets = 0;
+
+        //! Number of points of the fullest bucket.
+        size_t MaxNumberOfPointsInBucket = 0;
+
+        //! Returns the fraction of non-empty buckets.
+        double Occupancy() const;
+
+        //! Returns the average number of points per non-empty bucket.
+        double AverageNumberOfPointsPerNonEmptyBucket() const;
+    };
+
+    //! \brief Returns a hash grid resolution for the given points.
+    //!
+    //! The resolution covers the grid cells of \p bounds, so that the cells do
+    //! not collide, unless it would need more than \p numberOfPoints /
+    //! \p loadFactor buckets. In that case, the axes with the most cells are
+    //! scaled down to about that number of buckets. Each axis has at least 2
+    //! buckets so that the nearby buckets of a query are distinct.
+    //!
+    //! \param[in] bounds         The bounding box of the points.
+    //! \param[in] numberOfPoints The number of points.
+    //! \param[in] gridSpacing    The grid spacing.
+    //! \param[in] loadFactor     The maximum average number of points per bucket.
+    Size2 SuggestHashGridResolution(const BoundingBox2D& bounds, size_t numberOfPoints,
+                    double gridSpacing, double loadFactor = kDefaultHashGridLoadFactor);
+
+    //! \brief Returns a hash grid resolution for the given points.
+    //!
+    //! 3D version of SuggestHashGridResolution.
+    Size3 SuggestHashGridResolution(const BoundingBox3D& bounds, size_t numberOfPoints,
+                    double gridSpacing, double loadFactor = kDefaultHashGridLoadFactor);
+
+    //! \brief Computes the statistics of a hash grid sorted by bucket.
+    //!
+    //! \param[in] startIndexTable The start index of each bucket, or kMaxSize if empty.
+    //! \param[in] endIndexTable   The end index of each bucket.
+    //! \param[in] numberOfPoints  The number of points.
+    //! \param[in] isSameCell      Function called as isSameCell(i, j) which
+    //!                            returns true if the sorted points i and j
+    //!                            are in the same grid cell.
+    //!
+    //! \tparam SameCellFunction Function type.
+    template<typename SameCellFunction>
+    HashGridStatistics ComputeHashGridStatistics(const std::vector<size_t>& startIndexTable,
+                    const std::vector<size_t>& endIndexTable, size_t numberOfPoints,
+                    const SameCellFunction& isSameCell);
+
+    template<typename SameCellFunction>
+    HashGridStatistics ComputeHashGridStatistics(const std::vector<size_t>& startIndexTable,
+                    const std::vector<size_t>& endIndexTable, size_t numberOfPoints,
+                    const SameCellFunction& isSameCell)
+    {
+        HashGridStatistics statistics;
+        statistics.NumberOfPoints = numberOfPoints;
+        statistics.NumberOfBuckets = startIndexTable.size();
+
+        auto NumPointsInBucket = [&](size_t i) -> size_t
+                {
+                    if (startIndexTable[i] == kMaxSize)
+                        return 0;
+                    return endIndexTable[i] - startIndexTable[i];
+                };
+
+        statistics.MaxNumberOfPointsInBucket = std::max(kZeroSize,
+                    ParallelMax(kZeroSize, startIndexTable.size(), NumPointsInBucket));
+        statistics.NumberOfNonEmptyBuckets = ParallelSum(kZeroSize, startIndexTable.size(),
+                [&](size_t i) -> size_t
+                {
+                    return startIndexTable[i] != kMaxSize ? 1 : 0;
+                });
+
+        // A bucket collides if any of its points is in another cell than the first one.
+        statistics.NumberOfCollidingBuckets = ParallelSum(kZeroSize, startIndexTable.size(),
+                [&](size_t i) -> size_t
+                {
+                    const size_t start = startIndexTable[i];
+                    if (start == kMaxSize)
+                        return 0;
+
+                    for (size_t j = start + 1; j < endIndexTable[i]; ++j)
+                    {
+                        if (!isSameCell(start, j))
+                            return 1;
+                    }
+                    return 0;
+                });
+
+        return statistics;
+    }
+}
@@ -51,29 +51,7 @@ namespace jet
     void PointHashGridSearch2::ForEachNearbyPoint(const Vector2D& origin,
                         double radius, const ForEachNearbyPointCallback& callback) const
     {
-        if (_Buckets.empty())
-            return;
-
-        size_t NearbyKeys[4];
-        GetNearbyKeys(origin, NearbyKeys);
-
-        const double QueryRadiusSq = radius * radius;
-
-        for(int i = 0; i < 4; ++i)
-        {
-            const auto& bucket = _Buckets[NearbyKeys[i]];
-            size_t NumberOfPointsInBucket = bucket.size();
-
-            for (size_t j = 0; j < NumberOfPointsInBucket; ++j)
-            {
-                size_t PointIndex = bucket[j];
-                double rSquared = (_Points[PointIndex] - origin).LengthSquared();
-                if (rSquared <= QueryRadiusSq)
-                {
-                    callback(PointIndex, _Points[PointIndex]);
-                }
-            }
-        }
+        ForEachNearbyPoint<ForEachNearbyPointCallback>(origin, radius, callback);
     }
 
     bool PointHashGridSearch2::HasNearbyPoint(const Vector2D& origin, double radius) const
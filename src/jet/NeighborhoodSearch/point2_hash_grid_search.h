@@ -58,6 +58,21 @@ namespace jet
         //! \param[in] callback The callback function
         void ForEachNearbyPoint(const Vector2D& origin, double radius, 
                     const ForEachNearbyPointCallback& callback) const override;
+
+        //! \brief Invokes the callback function for each nearby point around the
+        //! origin within given radius.
+        //!
+        //! Same as the virtual ForEachNearbyPoint, but \p callback is called
+        //! directly instead of through a std::function, so it can be inlined.
+        //!
+        //! \param[in] origin The origin position.
+        //! \param[in] radius The search radius.
+        //! \param[in] callback The callback function, called as callback(index, position).
+        //!
+        //! \tparam Callback Callback function type.
+        template<typename Callback>
+        void ForEachNearbyPoint(const Vector2D& origin, double radius,
+                    const Callback& callback) const;
         
 
         //! Returns true if there are any nearby points for given origin within radius.
@@ -166,4 +181,33 @@ namespace jet
         Size2 _Resolution{64,64};
         double _GridSpacing = 1.0;
     };
-}
\ No newline at end of file
+
+    template<typename Callback>
+    void PointHashGridSearch2::ForEachNearbyPoint(const Vector2D& origin, double radius,
+                    const Callback& callback) const
+    {
+        if (_Buckets.empty())
+            return;
+
+        size_t NearbyKeys[4];
+        GetNearbyKeys(origin, NearbyKeys);
+
+        const double QueryRadiusSq = radius * radius;
+
+        for(int i = 0; i < 4; ++i)
+        {
+            const auto& bucket = _Buckets[NearbyKeys[i]];
+            size_t NumberOfPointsInBucket = bucket.size();
+
+            for (size_t j = 0; j < NumberOfPointsInBucket; ++j)
+            {
+                size_t PointIndex = bucket[j];
+                double rSquared = (_Points[PointIndex] - origin).LengthSquared();
+                if (rSquared <= QueryRadiusSq)
+                {
+                    callback(PointIndex, _Points[PointIndex]);
+                }
+            }
+        }
+    }
+}
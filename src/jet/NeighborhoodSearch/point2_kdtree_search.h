@@ -0,0 +1,245 @@
+#pragma once
+
+#include <constants.h>
+#include <NeighborhoodSearch/point2_neighbor_search.h>
+#include <utility>
+#include <vector>
+
+namespace jet
+{
+    //! \brief KD-tree based 2D point search.
+    //!
+    //! This class implements 2D point search with a balanced KD-tree. The tree
+    //! is built by splitting the points at the median of the axis of largest
+    //! extent, with the subtrees built in parallel, and stored as a flat array
+    //! of nodes in depth-first order. The points are reordered so that each
+    //! leaf holds a contiguous range of them. In addition to the radius
+    //! queries, the tree answers k-nearest-neighbor and nearest point queries,
+    //! and it does not depend on a grid spacing.
+    class PointKdTreeSearch2 final : public PointNeighborSearch2
+    {
+    public:
+        JET_NEIGHBOR_SEARCH2_TYPE_NAME(PointKdTreeSearch2)
+
+        class Builder;
+
+        //! \brief Constructs an empty tree.
+        //!
+        //! \param[in] maxLeafSize The maximum number of points in a leaf.
+        explicit PointKdTreeSearch2(size_t maxLeafSize = 8);
+
+        //! Copy constructor.
+        PointKdTreeSearch2(const PointKdTreeSearch2& other);
+
+        //! \brief Builds internal acceleration structure for given points list.
+        //!
+        //! The subtrees are built in parallel.
+        //!
+        //! \param[in] points The points to be added.
+        void Build(const ConstArrayAccessor1<Vector2D>& points) override;
+
+        //! Invokes the callback function for each nearby point around the origin
+        //! within given radius.
+        //!
+        //! \param[in] origin The origin position.
+        //! \param[in] radius The search radius.
+        //! \param[in] callback The callback function.
+        void ForEachNearbyPoint(const Vector2D& origin, double radius,
+                    const ForEachNearbyPointCallback& callback) const override;
+
+        //! \brief Invokes the callback function for each nearby point around the
+        //! origin within given radius.
+        //!
+        //! Same as the virtual ForEachNearbyPoint, but \p callback is called
+        //! directly instead of through a std::function, so it can be inlined.
+        //!
+        //! \param[in] origin The origin position.
+        //! \param[in] radius The search radius.
+        //! \param[in] callback The callback function, called as callback(index, position).
+        //!
+        //! \tparam Callback Callback function type.
+        template<typename Callback>
+        void ForEachNearbyPoint(const Vector2D& origin, double radius,
+                    const Callback& callback) const;
+
+        //! \brief Returns the candidates for the nearby points around the origin
+        //! within given radius.
+        //!
+        //! The candidates are the leaves overlapping the query, which are
+        //! contiguous ranges of the sorted points, so nothing is copied.
+        void GetNearbyPointCandidates(const Vector2D& origin, double radius,
+                    NearbyPointCandidates* candidates) const override;
+
+        //! Returns true if there are any nearby points for given origin within radius
+        //!
+        //! \param[in] origin The origin.
+        //! \param[in] radius The radius.
+        //!
+        //! \return True if has nearby point, false otherwise.
+        bool HasNearbyPoint(const Vector2D& origin, double radius) const override;
+
+        //! \brief Invokes the callback function for each of the k nearest points
+        //! to the origin.
+        //!
+        //! The points are visited from the nearest to the farthest. If there
+        //! are fewer than \p k points, all of them are visited.
+        //!
+        //! \param[in] origin The origin position.
+        //! \param[in] k The number of points to visit.
+        //! \param[in] callback The callback function, called as callback(index, position).
+        //!
+        //! \tparam Callback Callback function type.
+        template<typename Callback>
+        void ForEachKNearest(const Vector2D& origin, size_t k, const Callback& callback) const;
+
+        //! \brief Returns the index of the nearest point to the origin.
+        //!
+        //! \param[in] origin The origin position.
+        //!
+        //! \return The index of the nearest point, or kMaxSize if there is no point.
+        size_t NearestPoint(const Vector2D& origin) const;
+
+        //! Returns the maximum number of points in a leaf.
+        size_t MaxLeafSize() const;
+
+        //! Returns the number of nodes of the tree.
+        size_t NumberOfNodes() const;
+
+        //! \brief Returns the sorted indices of the points.
+        //!
+        //! The points are sorted by leaf, and this list maps sorted index i to
+        //! original index j.
+        //!
+        //! \return The sorted indices of the points.
+        const std::vector<size_t>& SortedIndices() const;
+
+        //! \brief Creates a new instance of the object with same properties than original
+        //!
+        //! \return Copy of this object.
+        PointNeighborSearch2Ptr Clone() const override;
+
+        //! Assignment Operator.
+        PointKdTreeSearch2& operator=(const PointKdTreeSearch2& other);
+
+        //! Copy from the other instance.
+        void Set(const PointKdTreeSearch2& other);
+
+        //! Serializes the neighbor search into the buffer.
+        void Serialize(std::vector<uint8_t>* buffer) const override;
+
+        //! Deserializes the neighbor search from the buffer.
+        void Deserialize(const std::vector<uint8_t>& buffer) override;
+
+        //! Returns builder for PointKdTreeSearch2
+        static Builder builder();
+
+    private:
+        // Node of the tree. The left child of an internal node follows it in
+        // the array, and its right child is at index Right. Leaves have
+        // Right == 0 and hold the sorted points [Start, End).
+        struct Node
+        {
+            size_t Start;
+            size_t End;
+            size_t Right;
+            size_t Axis;
+            double Split;
+        };
+
+        // The depth of a median split tree is below 64 for any point count.
+        static constexpr size_t kMaxDepth = 64;
+
+        size_t _MaxLeafSize = 8;
+        std::vector<Vector2D> _Points;
+        std::vector<size_t> _SortedIndices;
+        std::vector<Node> _Nodes;
+
+        void BuildNode(const ConstArrayAccessor1<Vector2D>& points, size_t nodeIndex,
+                    size_t start, size_t end, unsigned int numThreads);
+        void FindKNearest(const Vector2D& origin, size_t k,
+                    std::vector<std::pair<double, size_t>>* nearest) const;
+    };
+
+    typedef std::shared_ptr<PointKdTreeSearch2> PointKdTreeSearch2Ptr;
+
+    //! \brief Frontend to create PointKdTreeSearch2 object.
+    class PointKdTreeSearch2::Builder final
+        : public PointNeighborSearchBuilder2
+    {
+    public:
+        //! Returns the builder with the maximum number of points in a leaf.
+        Builder& WithMaxLeafSize(size_t maxLeafSize);
+
+        //! Builds PointKdTreeSearch2 instance.
+        PointKdTreeSearch2 Build() const;
+
+        //! Builds shared pointer of PointKdTreeSearch2 instance.
+        PointKdTreeSearch2Ptr MakeShared() const;
+
+        //! Returns the shared pointer of PointNeighborSearch2 type.
+        PointNeighborSearch2Ptr BuildPointNeighborSearch() const override;
+
+    private:
+        size_t _MaxLeafSize = 8;
+    };
+
+    template<typename Callback>
+    void PointKdTreeSearch2::ForEachNearbyPoint(const Vector2D& origin, double radius,
+                    const Callback& callback) const
+    {
+        if (_Nodes.empty())
+            return;
+
+        const double QueryRadiusSq = radius * radius;
+
+        size_t stack[kMaxDepth];
+        size_t stackSize = 0;
+        stack[stackSize++] = 0;
+
+        while (stackSize > 0)
+        {
+            const Node* node = &_Nodes[stack[--stackSize]];
+
+            while (node->Right != 0)
+            {
+                const double diff = origin[node->Axis] - node->Split;
+                const size_t left = static_cast<size_t>(node - _Nodes.data()) + 1;
+
+                if (diff - radius <= 0.0 && diff + radius >= 0.0)
+                {
+                    stack[stackSize++] = node->Right;
+                    node = &_Nodes[left];
+                }
+                else
+                {
+                    node = &_Nodes[diff < 0.0 ? left : node->Right];
+                }
+            }
+
+            for (size_t j = node->Start; j < node->End; ++j)
+            {
+                Vector2D Direction = _Points[j] - origin;
+                double DistanceSq = Direction.LengthSquared();
+                if (DistanceSq <= QueryRadiusSq)
+                    callback(_SortedIndices[j], _Points[j]);
+            }
+        }
+    }
+
+    template<typename Callback>
+    void PointKdTreeSearch2::ForEachKNearest(const Vector2D& origin, size_t k,
+                    const Callback& callback) const
+    {
+        // Take over the storage of the buffer of this thread. A nested query
+        // from the callback finds an empty buffer and allocates its own.
+        thread_local std::vector<std::pair<double, size_t>> buffer;
+        std::vector<std::pair<double, size_t>> nearest = std::move(buffer);
+
+        FindKNearest(origin, k, &nearest);
+
+        for (const auto& candidate : nearest)
+            callback(_SortedIndices[candidate.second], _Points[candidate.second]);
+
+        buffer = std::move(nearest);
+    }
+}
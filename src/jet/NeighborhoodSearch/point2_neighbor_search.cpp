@@ -8,4 +8,21 @@ namespace jet
 
     PointNeighborSearch2::~PointNeighborSearch2()
     {}
+
+    void PointNeighborSearch2::GetNearbyPointCandidates(const Vector2D& origin, double radius,
+                NearbyPointCandidates* candidates) const
+    {
+        candidates->Indices.clear();
+        candidates->Positions.clear();
+
+        ForEachNearbyPoint(origin, radius,
+                    [candidates](size_t i, const Vector2D& position)
+                    {
+                        candidates->Indices.push_back(i);
+                        candidates->Positions.push_back(position);
+                    });
+
+        candidates->Ranges.assign(1, NearbyPointRange{candidates->Indices.data(),
+                    candidates->Positions.data(), candidates->Indices.size()});
+    }
 }
@@ -2,10 +2,12 @@
 
 #include <Arrays/array1_accessor.h>
 #include <IO/Serialization/serialization.h>
+#include <simd.h>
 #include <Vector/vector2.h>
 #include <functional>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace jet
@@ -24,6 +26,32 @@ namespace jet
         //! nearby point, and the second is the position of the point.
         typedef std::function<void(size_t, const Vector2D&)> ForEachNearbyPointCallback;
 
+        //! \brief Range of candidate points of a query.
+        //!
+        //! The k-th candidate has the index Indices[k] and the position
+        //! Positions[k], for k < Size. If the search also stores the
+        //! coordinates as separate arrays, Xs and Ys point to them and the
+        //! candidates are filtered with ForEachPointInRadius.
+        struct NearbyPointRange
+        {
+            const size_t* Indices;
+            const Vector2D* Positions;
+            size_t Size;
+            const double* Xs = nullptr;
+            const double* Ys = nullptr;
+        };
+
+        //! \brief Candidate points of a query, as a list of ranges.
+        //!
+        //! Indices and Positions are storage for the derived classes whose
+        //! points are not laid out contiguously.
+        struct NearbyPointCandidates
+        {
+            std::vector<NearbyPointRange> Ranges;
+            std::vector<size_t> Indices;
+            std::vector<Vector2D> Positions;
+        };
+
         //! Default constructor.
         PointNeighborSearch2();
 
@@ -44,6 +72,37 @@ namespace jet
         virtual void ForEachNearbyPoint(const Vector2D& origin, double radius, 
                     const ForEachNearbyPointCallback& callback) const = 0;
 
+        //! \brief Returns the candidates for the nearby points around the origin
+        //! within given radius.
+        //!
+        //! The candidates contain every point within \p radius of \p origin,
+        //! and possibly points further away. The ranges point into the internal
+        //! storage of the search or of \p candidates, and are valid until
+        //! either is modified. The default implementation copies the result
+        //! of ForEachNearbyPoint into a single range.
+        //!
+        //! \param[in]  origin     The origin position.
+        //! \param[in]  radius     The search radius.
+        //! \param[out] candidates The candidates. Previous content is removed.
+        virtual void GetNearbyPointCandidates(const Vector2D& origin, double radius,
+                    NearbyPointCandidates* candidates) const;
+
+        //! \brief Invokes \p callback for each nearby point around the origin
+        //! within given radius.
+        //!
+        //! Unlike ForEachNearbyPoint, this function makes a single virtual call
+        //! to GetNearbyPointCandidates per query, then filters the candidates
+        //! and calls \p callback directly, so the callback can be inlined.
+        //!
+        //! \param[in] origin   The origin position.
+        //! \param[in] radius   The search radius.
+        //! \param[in] callback The callback function, called as callback(index, position).
+        //!
+        //! \tparam Callback Callback function type.
+        template<typename Callback>
+        void VisitNearbyPoints(const Vector2D& origin, double radius,
+                    const Callback& callback) const;
+
 
         //! Returns true if there are any nearby points for given origin within radius.
         //!
@@ -80,4 +139,38 @@ namespace jet
         std::string TypeName() const override { \
             return #DerivedClassName; \
         }
-}
\ No newline at end of file
+
+    template<typename Callback>
+    void PointNeighborSearch2::VisitNearbyPoints(const Vector2D& origin, double radius,
+                    const Callback& callback) const
+    {
+        // Take over the storage of the buffer of this thread. A nested query
+        // from the callback finds an empty buffer and allocates its own.
+        thread_local NearbyPointCandidates buffer;
+        NearbyPointCandidates candidates = std::move(buffer);
+
+        GetNearbyPointCandidates(origin, radius, &candidates);
+
+        const double QueryRadiusSq = radius * radius;
+        for (const NearbyPointRange& range : candidates.Ranges)
+        {
+            if (range.Xs != nullptr)
+            {
+                ForEachPointInRadius(range.Xs, range.Ys, 0, range.Size,
+                            origin.x, origin.y, QueryRadiusSq,
+                            [&](size_t k){
+                                callback(range.Indices[k], range.Positions[k]);
+                            });
+                continue;
+            }
+
+            for (size_t k = 0; k < range.Size; ++k)
+            {
+                if ((range.Positions[k] - origin).LengthSquared() <= QueryRadiusSq)
+                    callback(range.Indices[k], range.Positions[k]);
+            }
+        }
+
+        buffer = std::move(candidates);
+    }
+}
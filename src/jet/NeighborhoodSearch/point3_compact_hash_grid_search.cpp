@@ -0,0 +1,334 @@
+#include <jet.h>
+#include <IO/Serialization/fbs_helpers.h>
+#include <IO/Serialization/generated/point_compact_hash_grid_searcher3_generated.h>
+
+#include <parallel.h>
+#include <constants.h>
+#include "point3_compact_hash_grid_search.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace jet
+{
+    namespace
+    {
+        // Mixes the coordinates of a cell into a 64-bit hash.
+        uint64_t HashCell(const Point3I& cell)
+        {
+            uint64_t h = static_cast<uint64_t>(cell.x) * 0x9E3779B97F4A7C15ull;
+            h ^= static_cast<uint64_t>(cell.y) * 0xC2B2AE3D27D4EB4Full;
+            h ^= static_cast<uint64_t>(cell.z) * 0x165667B19E3779F9ull;
+            return h ^ (h >> 32);
+        }
+
+        bool IsLessCell(const Point3I& a, const Point3I& b)
+        {
+            if (a.z != b.z)
+                return a.z < b.z;
+            return a.y < b.y || (a.y == b.y && a.x < b.x);
+        }
+    }
+
+    PointCompactHashGridSearch3::PointCompactHashGridSearch3(double gridSpacing)
+                        : _GridSpacing(gridSpacing)
+    {
+        BuildCells(std::vector<Point3I>());
+    }
+
+    PointCompactHashGridSearch3::PointCompactHashGridSearch3(const PointCompactHashGridSearch3& other)
+    {
+        Set(other);
+    }
+
+    void PointCompactHashGridSearch3::Build(const ConstArrayAccessor1<Vector3D>& points)
+    {
+        size_t NumPoints = points.Size();
+        std::vector<Point3I> cells(NumPoints);
+        _SortedIndices.resize(NumPoints);
+        _Points.resize(NumPoints);
+
+        ParallelFor(kZeroSize, NumPoints, [&](size_t i){
+            _SortedIndices[i] = i;
+            cells[i] = GetCell(points[i]);
+        });
+
+        // Sort the points by cell. Ties are broken by index so that the order
+        // of the points within a cell does not depend on the sort.
+        ParallelSort(_SortedIndices.begin(), _SortedIndices.end(),
+                [&](size_t a, size_t b){
+                    if (IsLessCell(cells[a], cells[b]))
+                        return true;
+                    if (IsLessCell(cells[b], cells[a]))
+                        return false;
+                    return a < b;
+                });
+
+        std::vector<Point3I> sortedCells(NumPoints);
+        ParallelFor(kZeroSize, NumPoints, [&](size_t i){
+            _Points[i] = points[_SortedIndices[i]];
+            sortedCells[i] = cells[_SortedIndices[i]];
+        });
+
+        BuildCells(sortedCells);
+    }
+
+    void PointCompactHashGridSearch3::BuildCells(const std::vector<Point3I>& sortedCells)
+    {
+        const size_t NumPoints = sortedCells.size();
+
+        // Each run of equal cells in the sorted points is an occupied cell.
+        std::vector<size_t> pointIndices(NumPoints);
+        ParallelFor(kZeroSize, NumPoints, [&](size_t i){
+            pointIndices[i] = i;
+        });
+
+        _CellOffsets.resize(NumPoints + 1);
+        const size_t NumCells = ParallelCompact(pointIndices.begin(), pointIndices.end(),
+                [&](size_t i){
+                    return i == 0 || !(sortedCells[i] == sortedCells[i - 1]);
+                }, _CellOffsets.begin());
+        _CellOffsets.resize(NumCells + 1);
+        _CellOffsets[NumCells] = NumPoints;
+        _CellOffsets.shrink_to_fit();
+
+        _Cells.resize(NumCells);
+        _Cells.shrink_to_fit();
+        ParallelFor(kZeroSize, NumCells, [&](size_t k){
+            _Cells[k] = sortedCells[_CellOffsets[k]];
+        });
+
+        // The table is at most half full, so the probe sequences stay short
+        // and always end at an empty slot.
+        size_t capacity = 2;
+        while (capacity < 2 * NumCells)
+            capacity *= 2;
+
+        _Table.assign(capacity, kMaxSize);
+        _Table.shrink_to_fit();
+
+        const size_t mask = capacity - 1;
+        for (size_t k = 0; k < NumCells; ++k)
+        {
+            size_t slot = static_cast<size_t>(HashCell(_Cells[k])) & mask;
+            while (_Table[slot] != kMaxSize)
+                slot = (slot + 1) & mask;
+
+            _Table[slot] = k;
+        }
+    }
+
+    size_t PointCompactHashGridSearch3::FindCell(const Point3I& cell) const
+    {
+        const size_t mask = _Table.size() - 1;
+        size_t slot = static_cast<size_t>(HashCell(cell)) & mask;
+
+        while (_Table[slot] != kMaxSize)
+        {
+            if (_Cells[_Table[slot]] == cell)
+                return _Table[slot];
+
+            slot = (slot + 1) & mask;
+        }
+        return kMaxSize;
+    }
+
+    void PointCompactHashGridSearch3::ForEachNearbyPoint(const Vector3D& origin,
+                double radius, const ForEachNearbyPointCallback& callback) const
+    {
+        ForEachNearbyPoint<ForEachNearbyPointCallback>(origin, radius, callback);
+    }
+
+    void PointCompactHashGridSearch3::GetNearbyPointCandidates(const Vector3D& origin, double radius,
+                NearbyPointCandidates* candidates) const
+    {
+        UNUSED_VARIABLE(radius);
+
+        Point3I NearbyCells[8];
+        GetNearbyCells(origin, NearbyCells);
+
+        candidates->Ranges.clear();
+        for (int i = 0; i < 8; ++i)
+        {
+            const size_t k = FindCell(NearbyCells[i]);
+            if (k == kMaxSize)
+                continue;
+
+            const size_t start = _CellOffsets[k];
+            candidates->Ranges.push_back(NearbyPointRange{_SortedIndices.data() + start,
+                        _Points.data() + start, _CellOffsets[k + 1] - start});
+        }
+    }
+
+    bool PointCompactHashGridSearch3::HasNearbyPoint(const Vector3D& origin, double radius) const
+    {
+        Point3I NearbyCells[8];
+        GetNearbyCells(origin, NearbyCells);
+
+        const double QueryRadiusSq = radius * radius;
+
+        for (int i = 0; i < 8; ++i)
+        {
+            const size_t k = FindCell(NearbyCells[i]);
+            if (k == kMaxSize)
+                continue;
+
+            for (size_t j = _CellOffsets[k]; j < _CellOffsets[k + 1]; ++j)
+            {
+                Vector3D direction = _Points[j] - origin;
+                if (direction.LengthSquared() <= QueryRadiusSq)
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    size_t PointCompactHashGridSearch3::NumberOfOccupiedCells() const
+    {
+        return _Cells.size();
+    }
+
+    size_t PointCompactHashGridSearch3::TableCapacity() const
+    {
+        return _Table.size();
+    }
+
+    const std::vector<size_t>& PointCompactHashGridSearch3::SortedIndices() const
+    {
+        return _SortedIndices;
+    }
+
+    Point3I PointCompactHashGridSearch3::GetCell(const Vector3D& position) const
+    {
+        Point3I cell;
+        cell.x = static_cast<ssize_t>(std::floor(position.x / _GridSpacing));
+        cell.y = static_cast<ssize_t>(std::floor(position.y / _GridSpacing));
+        cell.z = static_cast<ssize_t>(std::floor(position.z / _GridSpacing));
+        return cell;
+    }
+
+    void PointCompactHashGridSearch3::GetNearbyCells(const Vector3D& position, Point3I* NearbyCells) const
+    {
+        // The grid spacing is at least twice the search radius, so the 2x2x2
+        // cells on the side of the origin within its cell cover the query.
+        const Point3I OriginCell = GetCell(position);
+        const ssize_t dx = (OriginCell.x + 0.5) * _GridSpacing <= position.x ? 1 : -1;
+        const ssize_t dy = (OriginCell.y + 0.5) * _GridSpacing <= position.y ? 1 : -1;
+        const ssize_t dz = (OriginCell.z + 0.5) * _GridSpacing <= position.z ? 1 : -1;
+
+        for (int i = 0; i < 8; ++i)
+        {
+            NearbyCells[i] = OriginCell;
+            if (i & 4)
+                NearbyCells[i].x += dx;
+            if (i & 2)
+                NearbyCells[i].y += dy;
+            if (i & 1)
+                NearbyCells[i].z += dz;
+        }
+    }
+
+    PointNeighborSearch3Ptr PointCompactHashGridSearch3::Clone() const
+    {
+        return CLONE_W_CUSTOM_DELETER(PointCompactHashGridSearch3);
+    }
+
+    PointCompactHashGridSearch3& PointCompactHashGridSearch3::operator=(const PointCompactHashGridSearch3& other)
+    {
+        Set(other);
+        return *this;
+    }
+
+    void PointCompactHashGridSearch3::Set(const PointCompactHashGridSearch3& other)
+    {
+        _GridSpacing = other._GridSpacing;
+        _Points = other._Points;
+        _SortedIndices = other._SortedIndices;
+        _Cells = other._Cells;
+        _CellOffsets = other._CellOffsets;
+        _Table = other._Table;
+    }
+
+    void PointCompactHashGridSearch3::Serialize(std::vector<uint8_t>* buffer) const
+    {
+        flatbuffers::FlatBufferBuilder builder(1024);
+
+        // Copy Points
+        std::vector<fbs::Vector3D> points;
+        for (const auto& pt: _Points)
+            points.push_back(JetToFbs(pt));
+
+        auto fbsPoints = builder.CreateVectorOfStructs(points.data(), points.size());
+
+        // The cells and the table are rebuilt from the sorted points.
+        std::vector<uint64_t> sortedIndices(_SortedIndices.begin(), _SortedIndices.end());
+        auto fbsSortedIndices = builder.CreateVector(sortedIndices.data(), sortedIndices.size());
+
+        auto fbsSearch = fbs::CreatePointCompactHashGridSearcher3(
+                            builder,
+                            _GridSpacing,
+                            fbsPoints,
+                            fbsSortedIndices);
+
+        builder.Finish(fbsSearch);
+
+        uint8_t * buf = builder.GetBufferPointer();
+        size_t size = builder.GetSize();
+
+        buffer->resize(size);
+        memcpy(buffer->data(), buf, size);
+    }
+
+    void PointCompactHashGridSearch3::Deserialize(const std::vector<uint8_t>& buffer)
+    {
+        auto fbsSearch = fbs::GetPointCompactHashGridSearcher3(buffer.data());
+
+        _GridSpacing = fbsSearch->gridSpacing();
+
+        auto fbsPoints = fbsSearch->points();
+        _Points.resize(fbsPoints->size());
+        for (uint32_t i = 0; i < fbsPoints->size(); ++i)
+            _Points[i] = FbsToJet(*fbsPoints->Get(i));
+
+        auto fbsSortedIndices = fbsSearch->sortedIndices();
+        _SortedIndices.resize(fbsSortedIndices->size());
+        for (uint32_t i = 0; i < fbsSortedIndices->size(); ++i)
+            _SortedIndices[i] = static_cast<size_t>(fbsSortedIndices->Get(i));
+
+        std::vector<Point3I> sortedCells(_Points.size());
+        ParallelFor(kZeroSize, _Points.size(), [&](size_t i){
+            sortedCells[i] = GetCell(_Points[i]);
+        });
+        BuildCells(sortedCells);
+    }
+
+    PointCompactHashGridSearch3::Builder PointCompactHashGridSearch3::builder()
+    {
+        return Builder();
+    }
+
+    PointCompactHashGridSearch3::Builder&
+    PointCompactHashGridSearch3::Builder::WithGridSpacing(double gridSpacing)
+    {
+        _GridSpacing = gridSpacing;
+        return *this;
+    }
+
+    PointCompactHashGridSearch3 PointCompactHashGridSearch3::Builder::Build() const
+    {
+        return PointCompactHashGridSearch3(_GridSpacing);
+    }
+
+    PointCompactHashGridSearch3Ptr PointCompactHashGridSearch3::Builder::MakeShared() const
+    {
+        return std::shared_ptr<PointCompactHashGridSearch3>(new PointCompactHashGridSearch3(_GridSpacing),
+                        [](PointCompactHashGridSearch3* obj){
+                            delete obj;
+                        });
+    }
+
+    PointNeighborSearch3Ptr PointCompactHashGridSearch3::Builder::BuildPointNeighborSearch() const
+    {
+        return MakeShared();
+    }
+}
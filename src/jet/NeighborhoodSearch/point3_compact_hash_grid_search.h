@@ -0,0 +1,190 @@
+#pragma once
+
+#include <constants.h>
+#include <NeighborhoodSearch/point3_neighbor_search.h>
+#include <Points/point3.h>
+#include <vector>
+
+namespace jet
+{
+    //! \brief Compact hash grid based 3D point search.
+    //!
+    //! This class implements 3D point search with a hash grid which only stores
+    //! the occupied cells. The points are sorted by cell in parallel, and each
+    //! occupied cell is recorded in an open-addressing table with linear probing,
+    //! keyed by its full integer coordinate. Unlike PointParallelHashGridSearch3,
+    //! distant cells never share a bucket and the memory is proportional to the
+    //! number of points and occupied cells rather than to the grid resolution,
+    //! which suits sparse points in large or unbounded domains.
+    class PointCompactHashGridSearch3 final : public PointNeighborSearch3
+    {
+    public:
+        JET_NEIGHBOR_SEARCH3_TYPE_NAME(PointCompactHashGridSearch3)
+
+        class Builder;
+
+        //! \brief Constructs a hash grid with given grid spacing.
+        //!
+        //! The grid spacing must be 2x or greater than search radius.
+        //!
+        //! \param[in] gridSpacing The grid spacing.
+        explicit PointCompactHashGridSearch3(double gridSpacing);
+
+        //! Copy constructor.
+        PointCompactHashGridSearch3(const PointCompactHashGridSearch3& other);
+
+        //! \brief Builds internal acceleration structure for given points list.
+        //!
+        //! This function sorts the points by cell in parallel and builds the
+        //! table of the occupied cells.
+        //!
+        //! \param[in] points The points to be added.
+        void Build(const ConstArrayAccessor1<Vector3D>& points) override;
+
+        //! Invokes the callback function for each nearby point around the origin
+        //! within given radius.
+        //!
+        //! \param[in] origin The origin position.
+        //! \param[in] radius The search radius.
+        //! \param[in] callback The callback function.
+        void ForEachNearbyPoint(const Vector3D& origin, double radius,
+                    const ForEachNearbyPointCallback& callback) const override;
+
+        //! \brief Invokes the callback function for each nearby point around the
+        //! origin within given radius.
+        //!
+        //! Same as the virtual ForEachNearbyPoint, but \p callback is called
+        //! directly instead of through a std::function, so it can be inlined.
+        //!
+        //! \param[in] origin The origin position.
+        //! \param[in] radius The search radius.
+        //! \param[in] callback The callback function, called as callback(index, position).
+        //!
+        //! \tparam Callback Callback function type.
+        template<typename Callback>
+        void ForEachNearbyPoint(const Vector3D& origin, double radius,
+                    const Callback& callback) const;
+
+        //! \brief Returns the candidates for the nearby points around the origin
+        //! within given radius.
+        //!
+        //! The candidates are the occupied cells around the origin, which are
+        //! contiguous ranges of the sorted points, so nothing is copied.
+        void GetNearbyPointCandidates(const Vector3D& origin, double radius,
+                    NearbyPointCandidates* candidates) const override;
+
+        //! Returns true if there are any nearby points for given origin within radius
+        //!
+        //! \param[in] origin The origin.
+        //! \param[in] radius The radius.
+        //!
+        //! \return True if has nearby point, false otherwise.
+        bool HasNearbyPoint(const Vector3D& origin, double radius) const override;
+
+        //! Returns the number of occupied cells.
+        size_t NumberOfOccupiedCells() const;
+
+        //! Returns the number of slots of the open-addressing table.
+        size_t TableCapacity() const;
+
+        //! \brief Returns the sorted indices of the points.
+        //!
+        //! The points are sorted by cell, and this list maps sorted index i to
+        //! original index j.
+        //!
+        //! \return The sorted indices of the points.
+        const std::vector<size_t>& SortedIndices() const;
+
+        //! Gets the cell of a point.
+        //!
+        //! \param[in] position The position of the point.
+        //!
+        //! \return The cell coordinate.
+        Point3I GetCell(const Vector3D& position) const;
+
+        //! \brief Creates a new instance of the object with same properties than original
+        //!
+        //! \return Copy of this object.
+        PointNeighborSearch3Ptr Clone() const override;
+
+        //! Assignment Operator.
+        PointCompactHashGridSearch3& operator=(const PointCompactHashGridSearch3& other);
+
+        //! Copy from the other instance.
+        void Set(const PointCompactHashGridSearch3& other);
+
+        //! Serializes the neighbor search into the buffer.
+        void Serialize(std::vector<uint8_t>* buffer) const override;
+
+        //! Deserializes the neighbor search from the buffer.
+        void Deserialize(const std::vector<uint8_t>& buffer) override;
+
+        //! Returns builder for PointCompactHashGridSearch3
+        static Builder builder();
+
+    private:
+        double _GridSpacing = 1.0;
+        std::vector<Vector3D> _Points;
+        std::vector<size_t> _SortedIndices;
+
+        // Occupied cells, the points of _Cells[k] are in
+        // [_CellOffsets[k], _CellOffsets[k + 1]).
+        std::vector<Point3I> _Cells;
+        std::vector<size_t> _CellOffsets;
+
+        // Open-addressing table of indices into _Cells, kMaxSize for empty slots.
+        std::vector<size_t> _Table;
+
+        void BuildCells(const std::vector<Point3I>& sortedCells);
+        size_t FindCell(const Point3I& cell) const;
+        void GetNearbyCells(const Vector3D& position, Point3I* NearbyCells) const;
+    };
+
+    typedef std::shared_ptr<PointCompactHashGridSearch3> PointCompactHashGridSearch3Ptr;
+
+    //! \brief Frontend to create PointCompactHashGridSearch3 object.
+    class PointCompactHashGridSearch3::Builder final
+        : public PointNeighborSearchBuilder3
+    {
+    public:
+        //! Returns the builder with grid spacing.
+        Builder& WithGridSpacing(double gridSpacing);
+
+        //! Builds PointCompactHashGridSearch3 instance.
+        PointCompactHashGridSearch3 Build() const;
+
+        //! Builds shared pointer of PointCompactHashGridSearch3 instance.
+        PointCompactHashGridSearch3Ptr MakeShared() const;
+
+        //! Returns the shared pointer of PointNeighborSearch3 type.
+        PointNeighborSearch3Ptr BuildPointNeighborSearch() const override;
+
+    private:
+        double _GridSpacing = 1.0;
+    };
+
+    template<typename Callback>
+    void PointCompactHashGridSearch3::ForEachNearbyPoint(const Vector3D& origin, double radius,
+                    const Callback& callback) const
+    {
+        Point3I NearbyCells[8];
+        GetNearbyCells(origin, NearbyCells);
+
+        const double QueryRadiusSq = radius * radius;
+
+        for (int i = 0; i < 8; ++i)
+        {
+            const size_t k = FindCell(NearbyCells[i]);
+            if (k == kMaxSize)
+                continue;
+
+            for (size_t j = _CellOffsets[k]; j < _CellOffsets[k + 1]; ++j)
+            {
+                Vector3D Direction = _Points[j] - origin;
+                double DistanceSq = Direction.LengthSquared();
+                if (DistanceSq <= QueryRadiusSq)
+                    callback(_SortedIndices[j], _Points[j]);
+            }
+        }
+    }
+}
@@ -52,29 +52,7 @@ namespace jet
     void PointHashGridSearch3::ForEachNearbyPoint(const Vector3D& origin,
                         double radius, const ForEachNearbyPointCallback& callback) const
     {
-        if (_Buckets.empty())
-            return;
-
-        size_t NearbyKeys[8];
-        GetNearbyKeys(origin, NearbyKeys);
-
-        const double QueryRadiusSq = radius * radius;
-
-        for(int i = 0; i < 8; ++i)
-        {
-            const auto& bucket = _Buckets[NearbyKeys[i]];
-            size_t NumberOfPointsInBucket = bucket.size();
-
-            for (size_t j = 0; j < NumberOfPointsInBucket; ++j)
-            {
-                size_t PointIndex = bucket[j];
-                double rSquared = (_Points[PointIndex] - origin).LengthSquared();
-                if (rSquared <= QueryRadiusSq)
-                {
-                    callback(PointIndex, _Points[PointIndex]);
-                }
-            }
-        }
+        ForEachNearbyPoint<ForEachNearbyPointCallback>(origin, radius, callback);
     }
 
     bool PointHashGridSearch3::HasNearbyPoint(const Vector3D& origin, double radius) const
@@ -0,0 +1,388 @@
+#include <jet.h>
+#include <IO/Serialization/fbs_helpers.h>
+#include <IO/Serialization/generated/point_kdtree_searcher3_generated.h>
+
+#include <parallel.h>
+#include <constants.h>
+#include "point3_kdtree_search.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace jet
+{
+    namespace
+    {
+        // Subtrees with fewer points are built on the calling thread.
+        constexpr size_t kMinParallelBuildSize = 4096;
+
+        // Returns the number of nodes of the trees of n and n + 1 points.
+        // Both halves of a split of n or n + 1 points have n / 2 or
+        // n / 2 + 1 points, so one recursion level per halving is enough.
+        std::pair<size_t, size_t> CountNodes(size_t n, size_t maxLeafSize)
+        {
+            if (n + 1 <= maxLeafSize)
+                return std::make_pair(kOneSize, kOneSize);
+
+            const std::pair<size_t, size_t> half = CountNodes(n / 2, maxLeafSize);
+            const size_t a = half.first;
+            const size_t b = half.second;
+
+            if (n % 2 == 0)
+                return std::make_pair(n <= maxLeafSize ? 1 : 1 + 2 * a, 1 + a + b);
+
+            return std::make_pair(n <= maxLeafSize ? 1 : 1 + a + b, 1 + 2 * b);
+        }
+
+        size_t NumberOfTreeNodes(size_t n, size_t maxLeafSize)
+        {
+            return n == 0 ? 0 : CountNodes(n, maxLeafSize).first;
+        }
+    }
+
+    PointKdTreeSearch3::PointKdTreeSearch3(size_t maxLeafSize)
+                        : _MaxLeafSize(maxLeafSize)
+    {
+        JET_THROW_INVALID_ARG_IF(maxLeafSize == 0);
+    }
+
+    PointKdTreeSearch3::PointKdTreeSearch3(const PointKdTreeSearch3& other)
+    {
+        Set(other);
+    }
+
+    void PointKdTreeSearch3::Build(const ConstArrayAccessor1<Vector3D>& points)
+    {
+        const size_t NumPoints = points.Size();
+        _SortedIndices.resize(NumPoints);
+        _Points.resize(NumPoints);
+        _Nodes.resize(NumberOfTreeNodes(NumPoints, _MaxLeafSize));
+
+        ParallelFor(kZeroSize, NumPoints, [&](size_t i){
+            _SortedIndices[i] = i;
+        });
+
+        if (NumPoints > 0)
+            BuildNode(points, 0, 0, NumPoints, GetMaxNumberOfThreads());
+
+        ParallelFor(kZeroSize, NumPoints, [&](size_t i){
+            _Points[i] = points[_SortedIndices[i]];
+        });
+    }
+
+    void PointKdTreeSearch3::BuildNode(const ConstArrayAccessor1<Vector3D>& points,
+                size_t nodeIndex, size_t start, size_t end, unsigned int numThreads)
+    {
+        Node& node = _Nodes[nodeIndex];
+        node.Start = start;
+        node.End = end;
+        node.Right = 0;
+        node.Axis = 0;
+        node.Split = 0.0;
+
+        if (end - start <= _MaxLeafSize)
+            return;
+
+        // Split at the median of the axis of largest extent.
+        Vector3D lower = points[_SortedIndices[start]];
+        Vector3D upper = lower;
+        for (size_t i = start + 1; i < end; ++i)
+        {
+            const Vector3D& pt = points[_SortedIndices[i]];
+            lower.x = std::min(lower.x, pt.x);
+            lower.y = std::min(lower.y, pt.y);
+            lower.z = std::min(lower.z, pt.z);
+            upper.x = std::max(upper.x, pt.x);
+            upper.y = std::max(upper.y, pt.y);
+            upper.z = std::max(upper.z, pt.z);
+        }
+
+        const Vector3D extent = upper - lower;
+        size_t axis = (extent.y > extent.x) ? 1 : 0;
+        if (extent.z > extent[axis])
+            axis = 2;
+        const size_t mid = start + (end - start) / 2;
+
+        std::nth_element(_SortedIndices.begin() + start, _SortedIndices.begin() + mid,
+                _SortedIndices.begin() + end,
+                [&](size_t a, size_t b){
+                    return points[a][axis] < points[b][axis];
+                });
+
+        // The points of the left child are not above the split, and the
+        // points of the right child are not below it.
+        const size_t left = nodeIndex + 1;
+        node.Axis = axis;
+        node.Split = points[_SortedIndices[mid]][axis];
+        node.Right = left + NumberOfTreeNodes(mid - start, _MaxLeafSize);
+
+        const size_t right = node.Right;
+        if (numThreads > 1 && end - start >= kMinParallelBuildSize)
+        {
+            // Build the left subtree on the pool while this thread builds
+            // the right one.
+            TaskGroup group;
+            group.Run([&, left, start, mid, numThreads](){
+                BuildNode(points, left, start, mid, numThreads / 2);
+            });
+
+            BuildNode(points, right, mid, end, numThreads - numThreads / 2);
+            group.Wait();
+        }
+        else
+        {
+            BuildNode(points, left, start, mid, 1);
+            BuildNode(points, right, mid, end, 1);
+        }
+    }
+
+    void PointKdTreeSearch3::FindKNearest(const Vector3D& origin, size_t k,
+                std::vector<std::pair<double, size_t>>* nearest) const
+    {
+        nearest->clear();
+        if (k == 0 || _Nodes.empty())
+            return;
+
+        // The nearest points found so far, as a max-heap of (distance
+        // squared, sorted index), so the farthest one is at the front.
+        auto& heap = *nearest;
+
+        // Pending far children with the squared distance to their side of
+        // the split, which bounds the distance to any of their points.
+        std::pair<size_t, double> stack[kMaxDepth];
+        size_t stackSize = 0;
+        stack[stackSize++] = std::make_pair(kZeroSize, 0.0);
+
+        while (stackSize > 0)
+        {
+            const std::pair<size_t, double> pending = stack[--stackSize];
+            if (heap.size() == k && pending.second > heap.front().first)
+                continue;
+
+            const Node* node = &_Nodes[pending.first];
+            while (node->Right != 0)
+            {
+                const double diff = origin[node->Axis] - node->Split;
+                const size_t left = static_cast<size_t>(node - _Nodes.data()) + 1;
+
+                if (diff < 0.0)
+                {
+                    stack[stackSize++] = std::make_pair(node->Right, diff * diff);
+                    node = &_Nodes[left];
+                }
+                else
+                {
+                    stack[stackSize++] = std::make_pair(left, diff * diff);
+                    node = &_Nodes[node->Right];
+                }
+            }
+
+            for (size_t j = node->Start; j < node->End; ++j)
+            {
+                const double DistanceSq = (_Points[j] - origin).LengthSquared();
+                if (heap.size() < k)
+                {
+                    heap.emplace_back(DistanceSq, j);
+                    std::push_heap(heap.begin(), heap.end());
+                }
+                else if (DistanceSq < heap.front().first)
+                {
+                    std::pop_heap(heap.begin(), heap.end());
+                    heap.back() = std::make_pair(DistanceSq, j);
+                    std::push_heap(heap.begin(), heap.end());
+                }
+            }
+        }
+
+        std::sort_heap(heap.begin(), heap.end());
+    }
+
+    void PointKdTreeSearch3::ForEachNearbyPoint(const Vector3D& origin,
+                double radius, const ForEachNearbyPointCallback& callback) const
+    {
+        ForEachNearbyPoint<ForEachNearbyPointCallback>(origin, radius, callback);
+    }
+
+    void PointKdTreeSearch3::GetNearbyPointCandidates(const Vector3D& origin, double radius,
+                NearbyPointCandidates* candidates) const
+    {
+        candidates->Ranges.clear();
+        if (_Nodes.empty())
+            return;
+
+        size_t stack[kMaxDepth];
+        size_t stackSize = 0;
+        stack[stackSize++] = 0;
+
+        while (stackSize > 0)
+        {
+            const Node& node = _Nodes[stack[--stackSize]];
+            if (node.Right == 0)
+            {
+                candidates->Ranges.push_back(NearbyPointRange{_SortedIndices.data() + node.Start,
+                            _Points.data() + node.Start, node.End - node.Start});
+                continue;
+            }
+
+            const double diff = origin[node.Axis] - node.Split;
+            if (diff + radius >= 0.0)
+                stack[stackSize++] = node.Right;
+            if (diff - radius <= 0.0)
+                stack[stackSize++] = static_cast<size_t>(&node - _Nodes.data()) + 1;
+        }
+    }
+
+    bool PointKdTreeSearch3::HasNearbyPoint(const Vector3D& origin, double radius) const
+    {
+        if (_Nodes.empty())
+            return false;
+
+        const double QueryRadiusSq = radius * radius;
+
+        size_t stack[kMaxDepth];
+        size_t stackSize = 0;
+        stack[stackSize++] = 0;
+
+        while (stackSize > 0)
+        {
+            const Node& node = _Nodes[stack[--stackSize]];
+            if (node.Right == 0)
+            {
+                for (size_t j = node.Start; j < node.End; ++j)
+                {
+                    if ((_Points[j] - origin).LengthSquared() <= QueryRadiusSq)
+                        return true;
+                }
+                continue;
+            }
+
+            const double diff = origin[node.Axis] - node.Split;
+            if (diff + radius >= 0.0)
+                stack[stackSize++] = node.Right;
+            if (diff - radius <= 0.0)
+                stack[stackSize++] = static_cast<size_t>(&node - _Nodes.data()) + 1;
+        }
+        return false;
+    }
+
+    size_t PointKdTreeSearch3::NearestPoint(const Vector3D& origin) const
+    {
+        size_t nearest = kMaxSize;
+        ForEachKNearest(origin, 1, [&](size_t i, const Vector3D&){
+            nearest = i;
+        });
+        return nearest;
+    }
+
+    size_t PointKdTreeSearch3::MaxLeafSize() const
+    {
+        return _MaxLeafSize;
+    }
+
+    size_t PointKdTreeSearch3::NumberOfNodes() const
+    {
+        return _Nodes.size();
+    }
+
+    const std::vector<size_t>& PointKdTreeSearch3::SortedIndices() const
+    {
+        return _SortedIndices;
+    }
+
+    PointNeighborSearch3Ptr PointKdTreeSearch3::Clone() const
+    {
+        return CLONE_W_CUSTOM_DELETER(PointKdTreeSearch3);
+    }
+
+    PointKdTreeSearch3& PointKdTreeSearch3::operator=(const PointKdTreeSearch3& other)
+    {
+        Set(other);
+        return *this;
+    }
+
+    void PointKdTreeSearch3::Set(const PointKdTreeSearch3& other)
+    {
+        _MaxLeafSize = other._MaxLeafSize;
+        _Points = other._Points;
+        _SortedIndices = other._SortedIndices;
+        _Nodes = other._Nodes;
+    }
+
+    void PointKdTreeSearch3::Serialize(std::vector<uint8_t>* buffer) const
+    {
+        flatbuffers::FlatBufferBuilder builder(1024);
+
+        // Copy Points
+        std::vector<fbs::Vector3D> points;
+        for (const auto& pt: _Points)
+            points.push_back(JetToFbs(pt));
+
+        auto fbsPoints = builder.CreateVectorOfStructs(points.data(), points.size());
+
+        // The nodes are rebuilt from the points in their original order.
+        std::vector<uint64_t> sortedIndices(_SortedIndices.begin(), _SortedIndices.end());
+        auto fbsSortedIndices = builder.CreateVector(sortedIndices.data(), sortedIndices.size());
+
+        auto fbsSearch = fbs::CreatePointKdTreeSearcher3(
+                            builder,
+                            _MaxLeafSize,
+                            fbsPoints,
+                            fbsSortedIndices);
+
+        builder.Finish(fbsSearch);
+
+        uint8_t * buf = builder.GetBufferPointer();
+        size_t size = builder.GetSize();
+
+        buffer->resize(size);
+        memcpy(buffer->data(), buf, size);
+    }
+
+    void PointKdTreeSearch3::Deserialize(const std::vector<uint8_t>& buffer)
+    {
+        auto fbsSearch = fbs::GetPointKdTreeSearcher3(buffer.data());
+
+        _MaxLeafSize = static_cast<size_t>(fbsSearch->maxLeafSize());
+
+        auto fbsPoints = fbsSearch->points();
+        auto fbsSortedIndices = fbsSearch->sortedIndices();
+
+        // The tree only depends on the points in their original order, so
+        // rebuilding it gives the same nodes.
+        std::vector<Vector3D> points(fbsPoints->size());
+        for (uint32_t i = 0; i < fbsPoints->size(); ++i)
+            points[static_cast<size_t>(fbsSortedIndices->Get(i))] = FbsToJet(*fbsPoints->Get(i));
+
+        Build(ConstArrayAccessor1<Vector3D>(points.size(), points.data()));
+    }
+
+    PointKdTreeSearch3::Builder PointKdTreeSearch3::builder()
+    {
+        return Builder();
+    }
+
+    PointKdTreeSearch3::Builder&
+    PointKdTreeSearch3::Builder::WithMaxLeafSize(size_t maxLeafSize)
+    {
+        _MaxLeafSize = maxLeafSize;
+        return *this;
+    }
+
+    PointKdTreeSearch3 PointKdTreeSearch3::Builder::Build() const
+    {
+        return PointKdTreeSearch3(_MaxLeafSize);
+    }
+
+    PointKdTreeSearch3Ptr PointKdTreeSearch3::Builder::MakeShared() const
+    {
+        return std::shared_ptr<PointKdTreeSearch3>(new PointKdTreeSearch3(_MaxLeafSize),
+                        [](PointKdTreeSearch3* obj){
+                            delete obj;
+                        });
+    }
+
+    PointNeighborSearch3Ptr PointKdTreeSearch3::Builder::BuildPointNeighborSearch() const
+    {
+        return MakeShared();
+    }
+}
@@ -11,6 +11,28 @@
 
 namespace jet
 {
+    namespace
+    {
+        // Sorted point of the hash grid at Position in the sorted points.
+        // The sorted points are ordered by key, then by index, as the stable
+        // sort of Build leaves them.
+        struct HashGridEntry
+        {
+            size_t Key;
+            size_t Index;
+            size_t Position;
+        };
+
+        // Update rebuilds the grid when more than 1/kMaxMovedFraction of the
+        // points changed bucket.
+        const size_t kMaxMovedFraction = 8;
+
+        bool IsLessEntry(const HashGridEntry& a, const HashGridEntry& b)
+        {
+            return a.Key < b.Key || (a.Key == b.Key && a.Index < b.Index);
+        }
+    }
+
     PointParallelHashGridSearch3::PointParallelHashGridSearch3
         (const Size3& resolution, double gridSpacing) :
             PointParallelHashGridSearch3(resolution.x, resolution.y, resolution.z, gridSpacing)
@@ -44,7 +66,6 @@ namespace jet
 
         //Allocating memory chunk
         size_t NumPoints = points.Size();
-        std::vector<size_t> TempKeys(NumPoints);
         _StartIndexTable.resize(_Resolution.x * _Resolution.y * _Resolution.z);
         _EndIndexTable.resize(_Resolution.x * _Resolution.y * _Resolution.z);
         ParallelFill(_StartIndexTable.begin(), _StartIndexTable.end(), kMaxSize);
@@ -54,29 +75,27 @@ namespace jet
         _Points.resize(NumPoints);
 
         if (NumPoints == 0)
+        {
+            UpdateCoordinates();
+            UpdateStatistics();
             return;
+        }
         
         //Initialize indices array and generate hash key for each point.
         ParallelFor(kZeroSize, NumPoints, [&](size_t i){
             _SortedIndices[i] = i;
-            _Points[i] = points[i];
-            TempKeys[i] = GetHashKeyFromPosition(points[i]);
+            _Keys[i] = GetHashKeyFromPosition(points[i]);
         });
 
-        //Sort Indices based on hash key.
-        ParallelSort(
-            _SortedIndices.begin(),
-            _SortedIndices.end(),
-            [&TempKeys](size_t indexA, size_t indexB)
-            {
-                return TempKeys[indexA] < TempKeys[indexB];
-            });
+        //Sort keys and indices together. The keys are bounded by the table size,
+        //so a linear-time radix sort can be used.
+        const size_t MaxKey = static_cast<size_t>(_Resolution.x * _Resolution.y * _Resolution.z) - 1;
+        ParallelRadixSortByKey(_Keys.begin(), _Keys.end(), _SortedIndices.begin(), MaxKey);
 
-        //Reorder point and key arrays.
+        //Reorder point array.
         ParallelFor(kZeroSize, NumPoints,
                 [&](size_t i){
                     _Points[i] = points[_SortedIndices[i]];
-                    _Keys[i] = TempKeys[_SortedIndices[i]];
                 });
 
         // The _Points and _Keys are sorted by points' hash key values.
@@ -102,59 +121,312 @@ namespace jet
                     }
                 });
 
-        size_t SumNumPointsPerBucket = 0;
-        size_t MaxNumPointsPerBucket = 0;
-        size_t NumNonEmptyBucket = 0;
-        for(size_t i = 0; i < _StartIndexTable.size(); ++i)
+        UpdateCoordinates();
+        UpdateStatistics();
+
+        JET_INFO << "Avg. Number of Points per Non-Empty Bucket: "
+                    << _Statistics.AverageNumberOfPointsPerNonEmptyBucket();
+        JET_INFO << "Max Number of Points in a bucket: "
+            << _Statistics.MaxNumberOfPointsInBucket;
+        JET_INFO << "Bucket occupancy: " << _Statistics.Occupancy()
+            << ", colliding buckets: " << _Statistics.NumberOfCollidingBuckets;
+    }
+
+    void PointParallelHashGridSearch3::Update(const ConstArrayAccessor1<Vector3D>& points)
+    {
+        JET_THROW_INVALID_ARG_IF(points.Size() != _Points.size());
+
+        const size_t NumPoints = points.Size();
+        if (NumPoints == 0)
+            return;
+
+        // Refresh the sorted points and collect the ones which changed bucket.
+        // The batches collect them in the order of their sorted position.
+        const size_t NumBatches = std::min<size_t>(GetMaxNumberOfThreads(), NumPoints);
+        std::vector<std::vector<HashGridEntry>> batchMovedEntries(NumBatches);
+        ParallelFor(kZeroSize, NumBatches, [&](size_t b){
+            const size_t batchEnd = (b + 1) * NumPoints / NumBatches;
+            for (size_t i = b * NumPoints / NumBatches; i < batchEnd; ++i)
+            {
+                const size_t index = _SortedIndices[i];
+                _Points[i] = points[index];
+
+                const size_t key = GetHashKeyFromPosition(_Points[i]);
+                if (key != _Keys[i])
+                    batchMovedEntries[b].push_back(HashGridEntry{key, index, i});
+            }
+        });
+
+        std::vector<HashGridEntry> movedEntries;
+        for (const auto& entries : batchMovedEntries)
+            movedEntries.insert(movedEntries.end(), entries.begin(), entries.end());
+
+        const size_t NumMoved = movedEntries.size();
+        if (NumMoved == 0)
+        {
+            UpdateCoordinates();
+            return;
+        }
+
+        // The moved points are sorted by comparison, so when many of them
+        // changed bucket the radix sort of Build is faster.
+        if (NumMoved > NumPoints / kMaxMovedFraction)
         {
-            if (_StartIndexTable[i] != kMaxSize)
+            Build(points);
+            return;
+        }
+
+        std::vector<size_t> movedPositions(NumMoved);
+        ParallelFor(kZeroSize, NumMoved, [&](size_t k){
+            movedPositions[k] = movedEntries[k].Position;
+        });
+        ParallelSort(movedEntries.begin(), movedEntries.end(), IsLessEntry);
+
+        // The points which stayed in their bucket are still sorted. Each one
+        // shifts by the number of moved points taken out before it and the
+        // number of moved points to be inserted before it, so the sorted
+        // order is repaired by a single merging sweep.
+        std::vector<size_t> keys(NumPoints);
+        std::vector<size_t> sortedIndices(NumPoints);
+        std::vector<Vector3D> sortedPoints(NumPoints);
+        ParallelFor(kZeroSize, NumBatches, [&](size_t b){
+            const size_t batchBegin = b * NumPoints / NumBatches;
+            const size_t batchEnd = (b + 1) * NumPoints / NumBatches;
+
+            size_t removed = std::lower_bound(movedPositions.begin(), movedPositions.end(),
+                        batchBegin) - movedPositions.begin();
+            size_t inserted = std::lower_bound(movedEntries.begin(), movedEntries.end(),
+                        HashGridEntry{_Keys[batchBegin], _SortedIndices[batchBegin], batchBegin},
+                        IsLessEntry) - movedEntries.begin();
+
+            for (size_t i = batchBegin; i < batchEnd; ++i)
+            {
+                if (removed < NumMoved && movedPositions[removed] == i)
+                {
+                    ++removed;
+                    continue;
+                }
+
+                const HashGridEntry entry{_Keys[i], _SortedIndices[i], i};
+                while (inserted < NumMoved && IsLessEntry(movedEntries[inserted], entry))
+                    ++inserted;
+
+                const size_t position = i - removed + inserted;
+                keys[position] = entry.Key;
+                sortedIndices[position] = entry.Index;
+                sortedPoints[position] = _Points[i];
+            }
+        });
+
+        // A moved point follows the moved points before it and the points
+        // which stayed before it, found by binary search.
+        auto GetMovedPosition = [&](size_t k){
+            const HashGridEntry& entry = movedEntries[k];
+            size_t low = 0;
+            size_t high = NumPoints;
+            while (low < high)
             {
-                size_t NumPointsInBucket = _EndIndexTable[i] - _StartIndexTable[i];
-                SumNumPointsPerBucket += NumPointsInBucket;
-                MaxNumPointsPerBucket = std::max(MaxNumPointsPerBucket, NumPointsInBucket);
-                ++NumNonEmptyBucket;
+                const size_t mid = low + (high - low) / 2;
+                if (IsLessEntry(HashGridEntry{_Keys[mid], _SortedIndices[mid], mid}, entry))
+                    low = mid + 1;
+                else
+                    high = mid;
             }
+
+            const size_t movedBefore = std::lower_bound(movedPositions.begin(),
+                        movedPositions.end(), low) - movedPositions.begin();
+            return k + low - movedBefore;
+        };
+
+        ParallelFor(kZeroSize, NumMoved, [&](size_t k){
+            const size_t position = GetMovedPosition(k);
+            keys[position] = movedEntries[k].Key;
+            sortedIndices[position] = movedEntries[k].Index;
+            sortedPoints[position] = _Points[movedEntries[k].Position];
+        });
+
+        // Only the sorted points between the first and the last moved one,
+        // before or after the update, have changed.
+        const size_t begin = std::min(movedPositions.front(), GetMovedPosition(0));
+        const size_t end = std::max(movedPositions.back(), GetMovedPosition(NumMoved - 1)) + 1;
+
+        std::vector<size_t> oldKeys = std::move(_Keys);
+        _Keys = std::move(keys);
+        _SortedIndices = std::move(sortedIndices);
+        _Points = std::move(sortedPoints);
+
+        UpdateCoordinates();
+        PatchBuckets(oldKeys, begin, end);
+    }
+
+    void PointParallelHashGridSearch3::Add(const ConstArrayAccessor1<Vector3D>& points)
+    {
+        const size_t OldNumPoints = _Points.size();
+        const size_t NumAdded = points.Size();
+        if (NumAdded == 0)
+            return;
+
+        // The added points are appended to the sorted points, so their
+        // position is past the existing ones.
+        std::vector<HashGridEntry> entries(OldNumPoints);
+        ParallelFor(kZeroSize, OldNumPoints, [&](size_t i){
+            entries[i] = HashGridEntry{_Keys[i], _SortedIndices[i], i};
+        });
+
+        std::vector<HashGridEntry> addedEntries(NumAdded);
+        ParallelFor(kZeroSize, NumAdded, [&](size_t i){
+            addedEntries[i] = HashGridEntry{GetHashKeyFromPosition(points[i]),
+                        OldNumPoints + i, OldNumPoints + i};
+        });
+        ParallelSort(addedEntries.begin(), addedEntries.end(), IsLessEntry);
+
+        std::vector<HashGridEntry> merged(OldNumPoints + NumAdded);
+        ParallelMerge(entries.begin(), entries.end(),
+                addedEntries.begin(), addedEntries.end(), merged.begin(), IsLessEntry);
+
+        // The sorted points before the first added one are unchanged.
+        const size_t begin = std::lower_bound(entries.begin(), entries.end(),
+                    addedEntries.front(), IsLessEntry) - entries.begin();
+
+        std::vector<size_t> oldKeys = std::move(_Keys);
+        std::vector<Vector3D> sortedPoints(merged.size());
+        _Keys.resize(merged.size());
+        _SortedIndices.resize(merged.size());
+        ParallelFor(kZeroSize, merged.size(), [&](size_t i){
+            const size_t position = merged[i].Position;
+            _Keys[i] = merged[i].Key;
+            _SortedIndices[i] = merged[i].Index;
+            sortedPoints[i] = position < OldNumPoints ? _Points[position] : points[position - OldNumPoints];
+        });
+        _Points = std::move(sortedPoints);
+
+        UpdateCoordinates();
+        PatchBuckets(oldKeys, begin, _Keys.size());
+    }
+
+    void PointParallelHashGridSearch3::Remove(const ConstArrayAccessor1<size_t>& indices)
+    {
+        const size_t OldNumPoints = _Points.size();
+
+        std::vector<char> isRemoved(OldNumPoints, 0);
+        for (size_t i = 0; i < indices.Size(); ++i)
+        {
+            JET_THROW_INVALID_ARG_IF(indices[i] >= OldNumPoints);
+            isRemoved[indices[i]] = 1;
         }
 
-        JET_INFO << "Avg. Number of Points per Non-Empty Bucket: "
-                    << static_cast<float>(SumNumPointsPerBucket) / static_cast<float>(NumNonEmptyBucket);
-        JET_INFO << "Max Number of Points in a bucket: "
-            << MaxNumPointsPerBucket;
+        // The new index of a point is the number of kept points before it.
+        std::vector<size_t> newIndices(OldNumPoints);
+        ParallelFor(kZeroSize, OldNumPoints, [&](size_t i){
+            newIndices[i] = isRemoved[i] ? 0 : 1;
+        });
+        const size_t NumPoints = ParallelExclusiveScan(newIndices.begin(), newIndices.end(),
+                newIndices.begin(), kZeroSize);
+        if (NumPoints == OldNumPoints)
+            return;
+
+        // The sorted points before the first removed one are unchanged.
+        const size_t begin = ParallelMin(kZeroSize, OldNumPoints,
+                [&](size_t i){
+                    return isRemoved[_SortedIndices[i]] ? i : OldNumPoints;
+                });
+
+        std::vector<size_t> positions(OldNumPoints);
+        ParallelFor(kZeroSize, OldNumPoints, [&](size_t i){
+            positions[i] = i;
+        });
+
+        std::vector<size_t> kept(NumPoints);
+        ParallelCompact(positions.begin(), positions.end(),
+                [&](size_t i){
+                    return !isRemoved[_SortedIndices[i]];
+                }, kept.begin());
+
+        // The renumbering keeps the order of the indices, so the points stay
+        // sorted.
+        std::vector<size_t> keys(NumPoints);
+        std::vector<size_t> sortedIndices(NumPoints);
+        std::vector<Vector3D> sortedPoints(NumPoints);
+        ParallelFor(kZeroSize, NumPoints, [&](size_t k){
+            keys[k] = _Keys[kept[k]];
+            sortedIndices[k] = newIndices[_SortedIndices[kept[k]]];
+            sortedPoints[k] = _Points[kept[k]];
+        });
+
+        std::vector<size_t> oldKeys = std::move(_Keys);
+        _Keys = std::move(keys);
+        _SortedIndices = std::move(sortedIndices);
+        _Points = std::move(sortedPoints);
+
+        UpdateCoordinates();
+        PatchBuckets(oldKeys, begin, NumPoints);
+    }
+
+    void PointParallelHashGridSearch3::PatchBuckets(const std::vector<size_t>& oldKeys,
+                size_t begin, size_t end)
+    {
+        const size_t OldNumPoints = oldKeys.size();
+        const size_t NumPoints = _Keys.size();
+
+        // When the number of points is the same, the sorted keys from end on
+        // are unchanged too.
+        size_t oldEnd = OldNumPoints;
+        if (OldNumPoints == NumPoints)
+        {
+            if (end < NumPoints)
+                end = _EndIndexTable[_Keys[end]];
+
+            oldEnd = end;
+        }
+
+        // Extend the range to whole buckets, whose entries are the same
+        // before and after the change outside of the range.
+        if (begin > 0)
+            begin = _StartIndexTable[_Keys[begin - 1]];
+
+        ParallelFor(begin, oldEnd, [&](size_t i){
+            if (i == begin || oldKeys[i] != oldKeys[i - 1])
+            {
+                _StartIndexTable[oldKeys[i]] = kMaxSize;
+                _EndIndexTable[oldKeys[i]] = kMaxSize;
+            }
+        });
+
+        ParallelFor(begin, end, [&](size_t i){
+            const size_t key = _Keys[i];
+            if (i == begin || _Keys[i - 1] != key)
+                _StartIndexTable[key] = i;
+            if (i + 1 == end || _Keys[i + 1] != key)
+                _EndIndexTable[key] = i + 1;
+        });
     }
 
     void PointParallelHashGridSearch3::ForEachNearbyPoint(const Vector3D& origin,
                 double radius, const ForEachNearbyPointCallback& callback) const
     {
+        ForEachNearbyPoint<ForEachNearbyPointCallback>(origin, radius, callback);
+    }
+
+    void PointParallelHashGridSearch3::GetNearbyPointCandidates(const Vector3D& origin, double radius,
+                NearbyPointCandidates* candidates) const
+    {
+        UNUSED_VARIABLE(radius);
+
         size_t NearbyKeys[8];
         GetNearbyKeys(origin, NearbyKeys);
 
-        const double QueryRadiusSq = radius* radius;
-
+        candidates->Ranges.clear();
         for (int i = 0; i < 8; ++i)
         {
-            size_t NearbyKey = NearbyKeys[i];
-            size_t start = _StartIndexTable[NearbyKey];
-            size_t end = _EndIndexTable[NearbyKey];
+            size_t start = _StartIndexTable[NearbyKeys[i]];
+            size_t end = _EndIndexTable[NearbyKeys[i]];
 
             if (start == kMaxSize)
                 continue;
 
-            for (size_t j = start; j < end; ++j)
-            {
-                Vector3D Direction = _Points[j] - origin;
-                double DistanceSq = Direction.LengthSquared();
-                if (DistanceSq <= QueryRadiusSq)
-                {
-                    double distance = 0.0;
-                    if (DistanceSq > 0)
-                    {
-                        distance = std::sqrt(DistanceSq);
-                        Direction /= distance;
-                    }
-                    callback(_SortedIndices[j], _Points[j]);
-
-                }
-            }
+            candidates->Ranges.push_back(NearbyPointRange{_SortedIndices.data() + start,
+                        _Points.data() + start, end - start,
+                        _PointsX.data() + start, _PointsY.data() + start, _PointsZ.data() + start});
         }
     }
 
@@ -201,6 +473,44 @@ namespace jet
         return _EndIndexTable;
     }
 
+    Size3 PointParallelHashGridSearch3::Resolution() const
+    {
+        return Size3(static_cast<size_t>(_Resolution.x), static_cast<size_t>(_Resolution.y),
+                    static_cast<size_t>(_Resolution.z));
+    }
+
+    double PointParallelHashGridSearch3::GridSpacing() const
+    {
+        return _GridSpacing;
+    }
+
+    const HashGridStatistics& PointParallelHashGridSearch3::Statistics() const
+    {
+        return _Statistics;
+    }
+
+    void PointParallelHashGridSearch3::UpdateCoordinates()
+    {
+        const size_t NumPoints = _Points.size();
+        _PointsX.resize(NumPoints);
+        _PointsY.resize(NumPoints);
+        _PointsZ.resize(NumPoints);
+        ParallelFor(kZeroSize, NumPoints, [&](size_t i){
+            _PointsX[i] = _Points[i].x;
+            _PointsY[i] = _Points[i].y;
+            _PointsZ[i] = _Points[i].z;
+        });
+    }
+
+    void PointParallelHashGridSearch3::UpdateStatistics()
+    {
+        _Statistics = ComputeHashGridStatistics(_StartIndexTable, _EndIndexTable, _Points.size(),
+                [&](size_t i, size_t j)
+                {
+                    return GetBucketIndex(_Points[i]) == GetBucketIndex(_Points[j]);
+                });
+    }
+
     const std::vector<size_t>& PointParallelHashGridSearch3::SortedIndices() const
     {
         return _SortedIndices;
@@ -313,10 +623,14 @@ namespace jet
         _GridSpacing = other._GridSpacing;
         _Resolution = other._Resolution;
         _Points = other._Points;
+        _PointsX = other._PointsX;
+        _PointsY = other._PointsY;
+        _PointsZ = other._PointsZ;
         _Keys = other._Keys;
         _StartIndexTable = other._StartIndexTable;
         _EndIndexTable = other._EndIndexTable;
         _SortedIndices = other._SortedIndices;
+        _Statistics = other._Statistics;
     }
 
     void PointParallelHashGridSearch3::Serialize(std::vector<uint8_t>* buffer) const
@@ -401,6 +715,9 @@ namespace jet
         _SortedIndices.resize(fbsSortedIndices->size());
         for (uint32_t i =0; i < fbsSortedIndices->size(); ++i)
             _SortedIndices[i] = static_cast<size_t>(fbsSortedIndices->Get(i));
+
+        UpdateCoordinates();
+        UpdateStatistics();
     }
 
     PointParallelHashGridSearch3::Builder
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <constants.h>
+#include <NeighborhoodSearch/hash_grid_utils.h>
 #include <NeighborhoodSearch/point3_neighbor_search.h>
 #include <Points/point3.h>
 #include <Size/size3.h>
+#include <simd.h>
 #include <vector>
 
 namespace jet
@@ -12,6 +15,9 @@ namespace jet
     //! This class implements parallel version of 3D point search by using hash
     //! grid for its internal acceleration data structure. Each point is recorded to
     //! its corresponding bucket where the hashing function is 3D grid mapping.
+    //! The sorted points are also kept as separate coordinate arrays, so that
+    //! the templated ForEachNearbyPoint tests the distances of several points
+    //! of a bucket per SIMD instruction.
     class PointParallelHashGridSearch3 final : public PointNeighborSearch3
     {
     public:
@@ -49,6 +55,39 @@ namespace jet
         //!
         //! \param[in] points The points to be added.
         void Build(const ConstArrayAccessor1<Vector3D>& points) override;
+        //! \brief Updates the hash grid for the moved points.
+        //!
+        //! \p points must hold as many points as the hash grid, with the same
+        //! indices. The hash keys are recomputed, and since few points change
+        //! bucket between two time steps, only those are sorted and merged back
+        //! into the sorted points, which is linear on nearly sorted points.
+        //! Only the start and end index table entries of the buckets in the
+        //! changed range are written. When more than an eighth of the points
+        //! changed bucket, the hash grid is built again instead. The result is
+        //! the same as Build.
+        //!
+        //! \param[in] points The moved points.
+        void Update(const ConstArrayAccessor1<Vector3D>& points);
+
+        //! \brief Adds a batch of points.
+        //!
+        //! The new points get the indices following the existing ones. They are
+        //! sorted and merged into the sorted points, so the existing points are
+        //! not sorted again.
+        //!
+        //! \param[in] points The points to be added.
+        void Add(const ConstArrayAccessor1<Vector3D>& points);
+
+        //! \brief Removes a batch of points.
+        //!
+        //! The remaining points keep their order and are renumbered
+        //! contiguously, i.e. the index of a point is decreased by the number
+        //! of removed points before it, as when the particle arrays are
+        //! compacted.
+        //!
+        //! \param[in] indices The indices of the points to be removed.
+        void Remove(const ConstArrayAccessor1<size_t>& indices);
+
 
 
         //! Invokes the callback function for each nearby point around the origin
@@ -60,6 +99,29 @@ namespace jet
         void ForEachNearbyPoint(const Vector3D& origin, double radius, 
                     const ForEachNearbyPointCallback& callback) const override;
 
+        //! \brief Invokes the callback function for each nearby point around the
+        //! origin within given radius.
+        //!
+        //! Same as the virtual ForEachNearbyPoint, but \p callback is called
+        //! directly instead of through a std::function, so it can be inlined.
+        //!
+        //! \param[in] origin The origin position.
+        //! \param[in] radius The search radius.
+        //! \param[in] callback The callback function, called as callback(index, position).
+        //!
+        //! \tparam Callback Callback function type.
+        template<typename Callback>
+        void ForEachNearbyPoint(const Vector3D& origin, double radius,
+                    const Callback& callback) const;
+
+        //! \brief Returns the candidates for the nearby points around the origin
+        //! within given radius.
+        //!
+        //! The candidates are the buckets around the origin, which are
+        //! contiguous ranges of the sorted points, so nothing is copied.
+        void GetNearbyPointCandidates(const Vector3D& origin, double radius,
+                    NearbyPointCandidates* candidates) const override;
+
 
         //! Returns true if there are any nearby points for given origin within radius
         //!
@@ -111,6 +173,21 @@ namespace jet
         //! \return The sorted indices of the points.
         const std::vector<size_t>& SortedIndices() const;
 
+        //! \brief Returns the statistics of the buckets.
+        //!
+        //! The statistics are computed by Build and can be used to check that
+        //! the resolution suits the points, e.g. that few buckets collide.
+        //! Update, Add and Remove do not recompute them.
+        //!
+        //! \return The statistics of the last build.
+        const HashGridStatistics& Statistics() const;
+
+        //! Returns the resolution of the hash grid.
+        Size3 Resolution() const;
+
+        //! Returns the grid spacing.
+        double GridSpacing() const;
+
         //! Returns the hash value of given 2D bucket index.
         //!
         //! \param[in] BucketIndex The bucket index.
@@ -155,12 +232,19 @@ namespace jet
         double _GridSpacing = 1.0;
         Point3I _Resolution = Point3I(1, 1, 1);
         std::vector<Vector3D> _Points;
+        std::vector<double> _PointsX;
+        std::vector<double> _PointsY;
+        std::vector<double> _PointsZ;
         std::vector<size_t> _Keys;
         std::vector<size_t> _StartIndexTable;
         std::vector<size_t> _EndIndexTable;
         std::vector<size_t> _SortedIndices;
+        HashGridStatistics _Statistics;
 
         size_t GetHashKeyFromPosition(const Vector3D& position) const;
+        void UpdateStatistics();
+        void UpdateCoordinates();
+        void PatchBuckets(const std::vector<size_t>& oldKeys, size_t begin, size_t end);
         void GetNearbyKeys(const Vector3D& position, size_t* BucketIndices) const;
     };
 
@@ -191,4 +275,30 @@ namespace jet
         Size3 _Resolution{64,64,64};
         double _GridSpacing = 1.0;
     };
-}
\ No newline at end of file
+
+    template<typename Callback>
+    void PointParallelHashGridSearch3::ForEachNearbyPoint(const Vector3D& origin, double radius,
+                    const Callback& callback) const
+    {
+        size_t NearbyKeys[8];
+        GetNearbyKeys(origin, NearbyKeys);
+
+        const double QueryRadiusSq = radius* radius;
+
+        for (int i = 0; i < 8; ++i)
+        {
+            size_t NearbyKey = NearbyKeys[i];
+            size_t start = _StartIndexTable[NearbyKey];
+            size_t end = _EndIndexTable[NearbyKey];
+
+            if (start == kMaxSize)
+                continue;
+
+            ForEachPointInRadius(_PointsX.data(), _PointsY.data(), _PointsZ.data(), start, end,
+                        origin.x, origin.y, origin.z, QueryRadiusSq,
+                        [&](size_t j){
+                            callback(_SortedIndices[j], _Points[j]);
+                        });
+        }
+    }
+}
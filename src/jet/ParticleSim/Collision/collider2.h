@@ -56,6 +56,8 @@ namespace jet
         //!
         //! The callback function takes current simulation time in seconds unit. Use
         //! this callback to track any motion or state changes related to this collider.
+        //! ParticleSystemSolver2 may call it on a thread of the pool, but always
+        //! before updating the emitter and advancing the particles.
         //!
         //! \param[in] callback The callback function.
         void SetOnBeginUpdateCallback(const OnBeginUpdateCallback& callback);
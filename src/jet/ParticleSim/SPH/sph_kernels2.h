@@ -3,228 +3,286 @@
 #include <constants.h>
 #include <Vector/vector2.h>
 
+#include <type_traits>
+
 namespace jet
 {
+    //! \brief Standard SPH kernel function object.
+    //!
+    //! \tparam T Scalar type.
+    //! \tparam N Dimension.
+    template<typename T, size_t N>
+    struct SPHStdKernel;
+
+    //! \brief Spiky SPH kernel function object.
+    //!
+    //! \tparam T Scalar type.
+    //! \tparam N Dimension.
+    template<typename T, size_t N>
+    struct SPHSpikyKernel;
+
     //! \brief Standar 2D SPH kernel function object
-    struct SPHStdKernel2
+    //!
+    //! The kernel is templated on the scalar type, so that particles stored
+    //! in single precision are evaluated without conversion to double.
+    //!
+    //! \tparam T Scalar type, float or double.
+    template<typename T>
+    struct SPHStdKernel<T, 2>
     {
+        static_assert(std::is_floating_point<T>::value,
+            "SPHStdKernel only can be instantiated with floating point types");
+
         //! Kernel Radius
-        double h;
+        T h;
 
         //! Square of the kernel radius
-        double h2;
+        T h2;
 
         //! Cube of the kernel radius
-        double h3;
+        T h3;
 
         //! Fourth-power of the kernel radius
-        double h4;
+        T h4;
 
         //! Constructs a Kernel object with zero radius.
-        SPHStdKernel2();
+        SPHStdKernel();
 
         //! Constructs a Kernel object with given radius
-        explicit SPHStdKernel2(double radius);
+        explicit SPHStdKernel(T radius);
 
         //! Copy Constructor
-        SPHStdKernel2(const SPHStdKernel2& other);
+        SPHStdKernel(const SPHStdKernel& other);
 
         //! Returns kernel function value at given distance.
-        double operator()(double distance) const;
+        T operator()(T distance) const;
 
         //! Returns the first derivative at given distance.
-        double FirstDerivative(double distance) const;
+        T FirstDerivative(T distance) const;
 
         //! Returns the gradient at a point.
-        Vector2D Gradient(const Vector2D& point) const;
+        Vector2<T> Gradient(const Vector2<T>& point) const;
 
         //! Returns the graident at a point defined by distance and direction.
-        Vector2D Gradient(double distance, const Vector2D& direction) const;
+        Vector2<T> Gradient(T distance, const Vector2<T>& direction) const;
 
         //! Returns the second derivative at a given distance.
-        double SecondDerivative(double distance) const;
+        T SecondDerivative(T distance) const;
     };
 
     //! Spiky 2D SPH kernel function object.
-
-    struct SPHSpikyKernel2
+    //!
+    //! \tparam T Scalar type, float or double.
+    template<typename T>
+    struct SPHSpikyKernel<T, 2>
     {
+        static_assert(std::is_floating_point<T>::value,
+            "SPHSpikyKernel only can be instantiated with floating point types");
+
         //! Kernel Radius
-        double h;
+        T h;
 
         //! Square of the kernel radius
-        double h2;
+        T h2;
 
         //! Cube of the kernel radius
-        double h3;
+        T h3;
 
         //! Fourth-power of the kernel radius
-        double h4;
+        T h4;
 
         //! Fifth-power of the kernel radius
-        double h5;
+        T h5;
 
         //! Constructs a Kernel object with zero radius.
-        SPHSpikyKernel2();
+        SPHSpikyKernel();
 
         //! Constructs a Kernel object with given radius
-        explicit SPHSpikyKernel2(double radius);
+        explicit SPHSpikyKernel(T radius);
 
         //! Copy Constructor
-        SPHSpikyKernel2(const SPHSpikyKernel2& other);
+        SPHSpikyKernel(const SPHSpikyKernel& other);
 
         //! Returns kernel function value at given distance.
-        double operator()(double distance) const;
+        T operator()(T distance) const;
 
         //! Returns the first derivative at given distance.
-        double FirstDerivative(double distance) const;
+        T FirstDerivative(T distance) const;
 
         //! Returns the gradient at a point.
-        Vector2D Gradient(const Vector2D& point) const;
+        Vector2<T> Gradient(const Vector2<T>& point) const;
 
         //! Returns the graident at a point defined by distance and direction.
-        Vector2D Gradient(double distance, const Vector2D& direction) const;
+        Vector2<T> Gradient(T distance, const Vector2<T>& direction) const;
 
         //! Returns the second derivative at a given distance.
-        double SecondDerivative(double distance) const;
+        T SecondDerivative(T distance) const;
     };
 
+    //! Double precision standard 2D SPH kernel.
+    typedef SPHStdKernel<double, 2> SPHStdKernel2;
+
+    //! Single precision standard 2D SPH kernel.
+    typedef SPHStdKernel<float, 2> SPHStdKernel2F;
+
+    //! Double precision spiky 2D SPH kernel.
+    typedef SPHSpikyKernel<double, 2> SPHSpikyKernel2;
+
+    //! Single precision spiky 2D SPH kernel.
+    typedef SPHSpikyKernel<float, 2> SPHSpikyKernel2F;
+
 
-    inline SPHStdKernel2::SPHStdKernel2()
+    template<typename T>
+    inline SPHStdKernel<T, 2>::SPHStdKernel()
         : h(0), h2(0), h3(0), h4(0)
     {}
 
-    inline SPHStdKernel2::SPHStdKernel2(double h_)
+    template<typename T>
+    inline SPHStdKernel<T, 2>::SPHStdKernel(T h_)
         : h(h_), h2(h*h), h3(h2 * h), h4(h2 * h2)
     {}
 
-    inline SPHStdKernel2::SPHStdKernel2(const SPHStdKernel2& other)
+    template<typename T>
+    inline SPHStdKernel<T, 2>::SPHStdKernel(const SPHStdKernel& other)
         :h(other.h), h2(other.h2), h3(other.h3), h4(other.h4)
     {}
 
-    inline double SPHStdKernel2::operator()(double distance) const
+    template<typename T>
+    inline T SPHStdKernel<T, 2>::operator()(T distance) const
     {
-        double distanceSq = distance * distance;
+        T distanceSq = distance * distance;
 
         if (distanceSq >= h2)
         {
-            return 0.0;
+            return 0;
         }
         else
         {
-            double x = 1.0 - distanceSq / h2;
-            return 4.0 / (kPiD * h2) * x * x * x;
+            T x = 1 - distanceSq / h2;
+            return 4 / (Pi<T>() * h2) * x * x * x;
         }
     }
 
-    inline double SPHStdKernel2::FirstDerivative(double distance) const
+    template<typename T>
+    inline T SPHStdKernel<T, 2>::FirstDerivative(T distance) const
     {
         if (distance >= h)
         {
-            return 0.0;
+            return 0;
         }
         else
         {
-            double x = 1.0- distance * distance / h2;
-            return -24.0 * distance / (kPiD * h4) * x * x;
+            T x = 1 - distance * distance / h2;
+            return -24 * distance / (Pi<T>() * h4) * x * x;
         }
     }
 
-    inline Vector2D SPHStdKernel2::Gradient(const Vector2D& point) const
+    template<typename T>
+    inline Vector2<T> SPHStdKernel<T, 2>::Gradient(const Vector2<T>& point) const
     {
-        double dist = point.Length();
-        if (dist > 0.0)
+        T dist = point.Length();
+        if (dist > 0)
         {
             return Gradient(dist, point/dist);
         }
         else
         {
-            return Vector2D(0,0);
+            return Vector2<T>(0,0);
         }
     }
 
-    inline Vector2D SPHStdKernel2::Gradient(double distance, const Vector2D& directionToCenter) const
+    template<typename T>
+    inline Vector2<T> SPHStdKernel<T, 2>::Gradient(T distance, const Vector2<T>& directionToCenter) const
     {
         return -FirstDerivative(distance) * directionToCenter;
     }
 
-    inline double SPHStdKernel2::SecondDerivative(double distance) const
+    template<typename T>
+    inline T SPHStdKernel<T, 2>::SecondDerivative(T distance) const
     {
-        double distanceSq = distance * distance;
+        T distanceSq = distance * distance;
 
         if (distanceSq >= h2)
         {
-            return 0.0;
+            return 0;
         }
         else
         {
-            double x = distanceSq / h2;
-            return 24.0 / (kPiD * h4) * (1 - x) * (5 * x - 1);
+            T x = distanceSq / h2;
+            return 24 / (Pi<T>() * h4) * (1 - x) * (5 * x - 1);
         }
     }
 
-    inline SPHSpikyKernel2::SPHSpikyKernel2()
+    template<typename T>
+    inline SPHSpikyKernel<T, 2>::SPHSpikyKernel()
         : h(0), h2(0), h3(0), h4(0), h5(0)
     {}
 
-    inline SPHSpikyKernel2::SPHSpikyKernel2(double h_)
+    template<typename T>
+    inline SPHSpikyKernel<T, 2>::SPHSpikyKernel(T h_)
         : h(h_), h2(h * h), h3(h2 * h), h4(h2 * h2), h5(h3 * h2)
     {}
 
-    inline SPHSpikyKernel2::SPHSpikyKernel2(const SPHSpikyKernel2& other)
+    template<typename T>
+    inline SPHSpikyKernel<T, 2>::SPHSpikyKernel(const SPHSpikyKernel& other)
         : h(other.h), h2(other.h2), h3(other.h3), h4(other.h4), h5(other.h5)
     {}
 
-    inline double SPHSpikyKernel2::operator()(double distance) const
+    template<typename T>
+    inline T SPHSpikyKernel<T, 2>::operator()(T distance) const
     {
         if (distance >= h)
         {
-            return 0.0;
+            return 0;
         }
         else
         {
-            double x = 1.0 - distance / h;
-            return 10.0 / (kPiD * h2) * x * x * x;
+            T x = 1 - distance / h;
+            return 10 / (Pi<T>() * h2) * x * x * x;
         }
     }
 
-    inline double SPHSpikyKernel2::FirstDerivative(double distance) const
+    template<typename T>
+    inline T SPHSpikyKernel<T, 2>::FirstDerivative(T distance) const
     {
         if (distance >= h)
         {
-            return 0.0;
+            return 0;
         }
         else
         {
-            double x = 1.0 - distance / h;
-            return -30.0 / (kPiD * h3) * x * x;
+            T x = 1 - distance / h;
+            return -30 / (Pi<T>() * h3) * x * x;
         }
     }
 
-    inline Vector2D SPHSpikyKernel2::Gradient(const Vector2D& point) const
+    template<typename T>
+    inline Vector2<T> SPHSpikyKernel<T, 2>::Gradient(const Vector2<T>& point) const
     {
-        double dist = point.Length();
-        if (dist > 0.0)
+        T dist = point.Length();
+        if (dist > 0)
         {
             return Gradient(dist, point/dist);
         }
         else
-            return Vector2D(0,0);
+            return Vector2<T>(0,0);
     }
 
-    inline Vector2D SPHSpikyKernel2::Gradient(double distance, const Vector2D& directionToCenter) const
+    template<typename T>
+    inline Vector2<T> SPHSpikyKernel<T, 2>::Gradient(T distance, const Vector2<T>& directionToCenter) const
     {
         return -FirstDerivative(distance) * directionToCenter;
     }
 
-    inline double SPHSpikyKernel2::SecondDerivative(double distance) const
+    template<typename T>
+    inline T SPHSpikyKernel<T, 2>::SecondDerivative(T distance) const
     {
         if (distance >= h)
-            return 0.0;
+            return 0;
         else
         {
-            double x = 1.0 - distance / h;
-            return 60.0 / (kPiD * h4) * x;
+            T x = 1 - distance / h;
+            return 60 / (Pi<T>() * h4) * x;
         }
     }
-}
\ No newline at end of file
+}
@@ -14,6 +14,23 @@ namespace jet
     static double kTimeStepLimitBySpeedFactor = 0.4;
     static double kTimeStepLimitByForceFactor = 0.25;
 
+    namespace
+    {
+        // Kernel weighted velocity sum for the pseudo-viscosity.
+        struct WeightedVelocity
+        {
+            double Weight = 0.0;
+            Vector2D Velocity;
+
+            WeightedVelocity& operator+=(const WeightedVelocity& other)
+            {
+                Weight += other.Weight;
+                Velocity += other.Velocity;
+                return *this;
+            }
+        };
+    }
+
     SPHSolver2::SPHSolver2()
     {
         SetParticleSystemData(std::make_shared<SPHSystemData2>());
@@ -94,6 +111,16 @@ namespace jet
         _TimeStepLimitScale = std::max(newScale, 0.0);
     }
 
+    bool SPHSolver2::IsUsingHalfNeighborLists() const
+    {
+        return _IsUsingHalfNeighborLists;
+    }
+
+    void SPHSolver2::SetIsUsingHalfNeighborLists(bool isUsing)
+    {
+        _IsUsingHalfNeighborLists = isUsing;
+    }
+
     SPHSystemData2Ptr SPHSolver2::SPHSystemData() const
     {
         return std::dynamic_pointer_cast<SPHSystemData2>(ParticleSystemData());
@@ -108,12 +135,12 @@ namespace jet
         const double kernelRadius = particles->KernelRadius();
         const double mass = particles->Mass();
 
-        double MaxForceMagnitude = 0.0;
-
-        for(size_t i = 0; i < numParticles; ++i)
-        {
-            MaxForceMagnitude = std::max(MaxForceMagnitude, f[i].Length());
-        }
+        double MaxForceMagnitude = std::max(0.0,
+                    ParallelMax(kZeroSize, numParticles,
+                        [&](size_t i)
+                        {
+                            return f[i].Length();
+                        }, GetExecutionPolicy()));
 
         double TimeStepLimitBySpeed = kTimeStepLimitBySpeedFactor * kernelRadius / _SpeedOfSound;
 
@@ -139,11 +166,15 @@ namespace jet
         Timer timer;
         particles->BuildNeighborSearch();
         particles->BuildNeighborLists();
-        particles->UpdateDensities();
+        if (_IsUsingHalfNeighborLists)
+            particles->BuildHalfNeighborLists();
+        particles->UpdateDensities(GetExecutionPolicy());
 
         JET_INFO << "Building neighbor lists and updating densities took "
                 << timer.DurationInSeconds()
-                << " seconds";
+                << " seconds (neighbor lists built "
+                << particles->NumberOfNeighborListBuilds() << " times, reused "
+                << particles->NumberOfNeighborListReuses() << " times)";
     }
 
     void SPHSolver2::OnEndAdvanceTimeStep(double TimeStepInSeconds)
@@ -154,11 +185,12 @@ namespace jet
         size_t numParticles = particles->NumberOfParticles();
         auto densities = particles->Densities();
 
-        double maxDensity = 0.0;
-        for (size_t i = 0; i < numParticles; ++i)
-        {
-            maxDensity = std::max(maxDensity, densities[i]);
-        }
+        double maxDensity = std::max(0.0,
+                    ParallelMax(kZeroSize, numParticles,
+                        [&](size_t i)
+                        {
+                            return densities[i];
+                        }, GetExecutionPolicy()));
 
         JET_INFO << "Max Density: " << maxDensity << " "
                 << "Max Density / target density ratio: "
@@ -201,7 +233,7 @@ namespace jet
                     {
                         p[i] = ComputePressureFromEOS(d[i], targetDensity,
                                         EOSScale, EOSExponent(), NegativePressureScale());
-        });
+        }, GetExecutionPolicy());
     }
 
     void SPHSolver2::AccumulatePressureForce(const ConstArrayAccessor1<Vector2D>& positions,
@@ -215,11 +247,32 @@ namespace jet
         const double massSq = Square(particles->Mass());
         const SPHSpikyKernel2 kernel(particles->KernelRadius());
 
+        if (_IsUsingHalfNeighborLists)
+        {
+            particles->HalfNeighborLists().AccumulatePairs(pressureForces,
+                        [&](size_t i, size_t j, Vector2D& fi, Vector2D& fj)
+                        {
+                            double dist = positions[i].DistanceTo(positions[j]);
+
+                            if (dist > 0.0)
+                            {
+                                Vector2D dir = (positions[j] - positions[i]) / dist;
+                                Vector2D force = massSq * (pressures[i] / (densities[i] * densities[i])
+                                                        + pressures[j] / (densities[j] * densities[j]))
+                                                        * kernel.Gradient(dist, dir);
+                                fi -= force;
+                                fj += force;
+                            }
+                        }, GetExecutionPolicy());
+            return;
+        }
+
+        const auto& neighborLists = particles->NeighborLists();
+
         ParallelFor(kZeroSize, numParticles,
                         [&](size_t i)
                         {
-                            const auto& neighbors = particles->NeighborLists()[i];
-                            for (size_t j : neighbors)
+                            for (size_t j : neighborLists[i])
                             {
                                 double dist = positions[i].DistanceTo(positions[j]);
 
@@ -231,7 +284,7 @@ namespace jet
                                                                     * kernel.Gradient(dist, dir);
                                 }
                             }
-        });
+        }, GetExecutionPolicy());
     }
 
     void SPHSolver2::AccumulateViscosityForce()
@@ -246,10 +299,26 @@ namespace jet
         const double massSq = Square(particles->Mass());
         const SPHSpikyKernel2 kernel(particles->KernelRadius());
 
+        if (_IsUsingHalfNeighborLists)
+        {
+            particles->HalfNeighborLists().AccumulatePairs(f,
+                        [&](size_t i, size_t j, Vector2D& fi, Vector2D& fj)
+                        {
+                            double dist = x[i].DistanceTo(x[j]);
+                            Vector2D force = ViscosityCoefficient() * massSq
+                                        * (v[j] - v[i])
+                                        * kernel.SecondDerivative(dist);
+                            fi += force / d[j];
+                            fj -= force / d[i];
+                        }, GetExecutionPolicy());
+            return;
+        }
+
+        const auto& neighborLists = particles->NeighborLists();
+
         ParallelFor(kZeroSize, numParticles,
                     [&](size_t i){
-                        const auto& neighbors = particles->NeighborLists()[i];
-                        for (size_t j : neighbors)
+                        for (size_t j : neighborLists[i])
                         {
                             double dist = x[i].DistanceTo(x[j]);
 
@@ -257,7 +326,7 @@ namespace jet
                                     * (v[j] - v[i]) / d[j]
                                     * kernel.SecondDerivative(dist);
                         }
-        });
+        }, GetExecutionPolicy());
     }
 
     void SPHSolver2::ComputePseudoViscosity(double TimeStepInSeconds)
@@ -273,29 +342,60 @@ namespace jet
 
         Array1<Vector2D> SmoothedVelocities(numParticles);
 
-        ParallelFor(kZeroSize, numParticles,
-            [&](size_t i){
-                double weightSum = 0.0;
-                Vector2D smoothedVelocity;
-
-                const auto& neighbors = particles->NeighborLists()[i];
-                for (size_t j : neighbors)
+        if (_IsUsingHalfNeighborLists)
+        {
+            Array1<WeightedVelocity> sums(numParticles);
+            particles->HalfNeighborLists().AccumulatePairs(sums.Accessor(),
+                [&](size_t i, size_t j, WeightedVelocity& si, WeightedVelocity& sj)
                 {
-                    double dist = x[i].DistanceTo(x[j]);
-                    double wj = mass / d[j] * kernel(dist);
-                    weightSum += wj;
-                    smoothedVelocity += wj * v[j];
-                }
-
-                double wi = mass / d[i];
-                weightSum += wi;
-                smoothedVelocity += wi * v[i];
-
-                if (weightSum > 0.0)
-                    smoothedVelocity /= weightSum;
+                    double w = kernel(x[i].DistanceTo(x[j]));
+                    double wj = mass / d[j] * w;
+                    double wi = mass / d[i] * w;
+                    si.Weight += wj;
+                    si.Velocity += wj * v[j];
+                    sj.Weight += wi;
+                    sj.Velocity += wi * v[i];
+                }, GetExecutionPolicy());
+
+            ParallelFor(kZeroSize, numParticles,
+                [&](size_t i){
+                    double wi = mass / d[i];
+                    double weightSum = sums[i].Weight + wi;
+                    Vector2D smoothedVelocity = sums[i].Velocity + wi * v[i];
+
+                    if (weightSum > 0.0)
+                        smoothedVelocity /= weightSum;
+
+                    SmoothedVelocities[i] = smoothedVelocity;
+            }, GetExecutionPolicy());
+        }
+        else
+        {
+            const auto& neighborLists = particles->NeighborLists();
+
+            ParallelFor(kZeroSize, numParticles,
+                [&](size_t i){
+                    double weightSum = 0.0;
+                    Vector2D smoothedVelocity;
+
+                    for (size_t j : neighborLists[i])
+                    {
+                        double dist = x[i].DistanceTo(x[j]);
+                        double wj = mass / d[j] * kernel(dist);
+                        weightSum += wj;
+                        smoothedVelocity += wj * v[j];
+                    }
+
+                    double wi = mass / d[i];
+                    weightSum += wi;
+                    smoothedVelocity += wi * v[i];
+
+                    if (weightSum > 0.0)
+                        smoothedVelocity /= weightSum;
                 
-                SmoothedVelocities[i] = smoothedVelocity;
-        });
+                    SmoothedVelocities[i] = smoothedVelocity;
+            }, GetExecutionPolicy());
+        }
 
         double factor = TimeStepInSeconds * _PseudoViscosityCoefficient;
 
@@ -304,7 +404,7 @@ namespace jet
         ParallelFor(kZeroSize, numParticles,
                 [&](size_t i){
                     v[i] = Lerp(v[i], SmoothedVelocities[i], factor);
-        });
+        }, GetExecutionPolicy());
 
     }
 
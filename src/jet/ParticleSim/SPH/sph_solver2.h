@@ -81,6 +81,21 @@ namespace jet
         //! and max acceleration.
         void SetTimeStepLimitScale(double newScale);
 
+        //! Returns true if the pairwise forces use the half neighbor lists.
+        bool IsUsingHalfNeighborLists() const;
+
+        //! \brief Enables or disables the half neighbor lists for pairwise forces.
+        //!
+        //! When enabled, the pressure, viscosity and pseudo-viscosity loops
+        //! visit each unique neighbor pair once and apply the interaction to
+        //! both particles (Newton's third law), which halves the kernel
+        //! evaluations. When disabled, each particle sums over its full
+        //! neighbor list. Both give the same result up to rounding. The half
+        //! lists are built on top of the full lists and each pass accumulates
+        //! into per-thread buffers, so the gain depends on the number of
+        //! threads and on the particle order. Default is false.
+        void SetIsUsingHalfNeighborLists(bool isUsing);
+
         //! Returns the SPH system data.
         SPHSystemData2Ptr SPHSystemData() const;
 
@@ -142,6 +157,9 @@ namespace jet
 
         //! Sclaes the max allowed time-step
         double _TimeStepLimitScale = 1.0;
+
+        //! Uses the half neighbor lists for the pairwise forces.
+        bool _IsUsingHalfNeighborLists = false;
     };
 
     typedef std::shared_ptr<SPHSolver2> SPHSolver2Ptr;
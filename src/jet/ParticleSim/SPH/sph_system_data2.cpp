@@ -68,18 +68,27 @@ namespace jet
         return ScalarDataAt(_PressureIdx);
     }
 
-    void SPHSystemData2::UpdateDensities()
+    void SPHSystemData2::UpdateDensities(ExecutionPolicy policy)
     {
         auto p = Positions();
         auto d = Densities();
         const double m = Mass();
 
+        if (_NeighborListSkinRadius > 0.0)
+        {
+            // The neighbor search is only up to date right after a rebuild of
+            // the Verlet lists, which hold every particle within the kernel radius.
+            ComputeSPHDensities(ConstArrayAccessor1<Vector2D>(p), NeighborLists(),
+                        _KernelRadius, m, d, policy);
+            return;
+        }
+
         ParallelFor(kZeroSize, NumberOfParticles(),
                         [&](size_t i)
                         {
                             double sum = SumOfKernelsNearby(p[i]);
                             d[i] = m * sum;
-        });
+        }, policy);
     }
 
     void SPHSystemData2::SetTargetDensity(double targetDensity)
@@ -126,11 +135,21 @@ namespace jet
         return _KernelRadius;
     }
 
+    double SPHSystemData2::NeighborListSkinRadius() const
+    {
+        return _NeighborListSkinRadius;
+    }
+
+    void SPHSystemData2::SetNeighborListSkinRadius(double newSkinRadius)
+    {
+        _NeighborListSkinRadius = std::max(newSkinRadius, 0.0);
+    }
+
     double SPHSystemData2::SumOfKernelsNearby(const Vector2D& origin) const
     {
         double sum = 0.0;
         SPHStdKernel2 kernel(_KernelRadius);
-        NeighborSearch()->ForEachNearbyPoint(origin, _KernelRadius,
+        NeighborSearch()->VisitNearbyPoints(origin, _KernelRadius,
                         [&](size_t, const Vector2D& neighborPos)
                         {
                             double dist = origin.DistanceTo(neighborPos);
@@ -146,7 +165,7 @@ namespace jet
         SPHStdKernel2 kernel(_KernelRadius);
         const double m = Mass();
 
-        NeighborSearch()->ForEachNearbyPoint(origin, _KernelRadius,
+        NeighborSearch()->VisitNearbyPoints(origin, _KernelRadius,
                                 [&](size_t i, const Vector2D& neighborPos)
                                 {
                                     double dist = origin.DistanceTo(neighborPos);
@@ -163,7 +182,7 @@ namespace jet
         SPHStdKernel2 kernel(_KernelRadius);
         const double m = Mass();
 
-        NeighborSearch()->ForEachNearbyPoint(origin, _KernelRadius,
+        NeighborSearch()->VisitNearbyPoints(origin, _KernelRadius,
                         [&](size_t i, const Vector2D& neighborPos)
                         {
                             double dist = origin.DistanceTo(neighborPos);
@@ -178,7 +197,7 @@ namespace jet
         Vector2D sum;
         auto p = Positions();
         auto d = Densities();
-        const auto& neighbors = NeighborLists()[i];
+        const auto neighbors = NeighborLists()[i];
 
         Vector2D origin = p[i];
         SPHSpikyKernel2 kernel(_KernelRadius);
@@ -204,7 +223,7 @@ namespace jet
         double sum = 0.0;
         auto p = Positions();
         auto d = Densities();
-        const auto& neighbors = NeighborLists()[i];
+        const auto neighbors = NeighborLists()[i];
         Vector2D origin = p[i];
         SPHSpikyKernel2 kernel(_KernelRadius);
         const double m = Mass();
@@ -224,7 +243,7 @@ namespace jet
         Vector2D sum;
         auto p = Positions();
         auto d = Densities();
-        const auto& neighbors = NeighborLists()[i];
+        const auto neighbors = NeighborLists()[i];
         Vector2D origin = p[i];
         SPHSpikyKernel2 kernel(_KernelRadius);
         const double m = Mass();
@@ -240,12 +259,15 @@ namespace jet
 
     void SPHSystemData2::BuildNeighborSearch()
     {
-        ParticleSystemData2::BuildNeighborSearch(_KernelRadius);
+        // The search covers the radius of the Verlet lists as well, so that
+        // BuildNeighborLists finds it up to date instead of rebuilding it with
+        // another grid spacing. Queries with the kernel radius stay exact.
+        ParticleSystemData2::BuildNeighborSearch(_KernelRadius + _NeighborListSkinRadius);
     }
 
     void SPHSystemData2::BuildNeighborLists()
     {
-        ParticleSystemData2::BuildNeighborLists(_KernelRadius);
+        ParticleSystemData2::BuildNeighborLists(_KernelRadius, _NeighborListSkinRadius);
     }
 
     void SPHSystemData2::ComputeMass()
@@ -328,6 +350,7 @@ void SPHSystemData2::Set(const SPHSystemData2& other) {
     _TargetSpacing = other._TargetSpacing;
     _RelativeRadius = other._RelativeRadius;
     _KernelRadius = other._KernelRadius;
+    _NeighborListSkinRadius = other._NeighborListSkinRadius;
     _DensityIdx = other._DensityIdx;
     _PressureIdx = other._PressureIdx;
 }
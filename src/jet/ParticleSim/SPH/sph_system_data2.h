@@ -1,7 +1,9 @@
 #pragma once
 
 #include <constants.h>
+#include <parallel.h>
 #include <ParticleSim/particle_system_data2.h>
+#include <ParticleSim/SPH/sph_kernels2.h>
 #include <vector>
 
 namespace jet
@@ -56,7 +58,9 @@ namespace jet
         //!
         //! \warning The neighbour search must be update (by calling SPHSystemData2::BuildNeighborSearch)
         //! before calling this function.
-        void UpdateDensities();
+        //!
+        //! \param[in] policy The execution policy.
+        void UpdateDensities(ExecutionPolicy policy = ExecutionPolicy::kParallel);
 
         //! Sets the target density of the particle system.
         void SetTargetDensity(double TargetDensity);
@@ -83,6 +87,21 @@ namespace jet
         //! Returns the kernel raidus in metres.
         double KernelRadius() const;
 
+        //! Returns the skin radius of the neighbor lists in metres.
+        double NeighborListSkinRadius() const;
+
+        //! \brief Sets the skin radius of the neighbor lists in metres.
+        //!
+        //! With a positive skin radius, BuildNeighborLists keeps Verlet lists
+        //! for the kernel radius plus the skin radius, and rebuilds them along
+        //! with the neighbor search only when a particle has moved more than
+        //! half the skin radius. BuildNeighborSearch still updates the
+        //! neighbor search on every call, for the kernel radius plus the skin
+        //! radius, so that SumOfKernelsNearby, Interpolate and GradientAt see
+        //! the current positions. Default is 0, which rebuilds both on every
+        //! call.
+        void SetNeighborListSkinRadius(double newSkinRadius);
+
         //! Returns the sum of kernel function evaluation for each nearby particle.
         double SumOfKernelsNearby(const Vector2D& position) const;
 
@@ -122,10 +141,11 @@ namespace jet
         //! SPHSystemData2::BuildNeighborSearch before calling this function.
         Vector2D LaplacianAt(size_t i, const ConstArrayAccessor1<Vector2D>& values) const;
 
-        //! Builds neighbor search instance with kernel radius
+        //! Builds neighbor search instance with kernel radius, plus the skin
+        //! radius of the neighbor lists.
         void BuildNeighborSearch();
 
-        //! Builds Neighbor Lists with kernel radius.
+        //! Builds Neighbor Lists with kernel radius and the skin radius.
         void BuildNeighborLists();
 
         //! Serializes this SPH system data to the  buffer.
@@ -153,6 +173,9 @@ namespace jet
         //! SPH kernel radius in meters.
         double _KernelRadius;
 
+        //! Skin radius of the Verlet neighbor lists in meters.
+        double _NeighborListSkinRadius = 0.0;
+
         size_t _PressureIdx;
         size_t _DensityIdx;
 
@@ -161,4 +184,42 @@ namespace jet
     };
 
     typedef std::shared_ptr<SPHSystemData2> SPHSystemData2Ptr;
-}
\ No newline at end of file
+
+    //! \brief Computes the SPH densities of particles from their neighbor lists.
+    //!
+    //! The positions and the kernel are evaluated with the scalar type T. The
+    //! particle system data stores double, so the float instantiation is for
+    //! callers which keep their own float positions. The kernel sum of each
+    //! particle is accumulated in double. The lists may hold particles beyond the kernel radius, which
+    //! do not contribute.
+    //!
+    //! \param[in] positions The positions of the particles.
+    //! \param[in] neighborLists The neighbor lists of the particles.
+    //! \param[in] kernelRadius The kernel radius.
+    //! \param[in] mass The mass of a particle.
+    //! \param[out] densities The densities of the particles.
+    //! \param[in] policy The execution policy.
+    //!
+    //! \tparam T Scalar type, float or double.
+    template<typename T>
+    void ComputeSPHDensities(const ConstArrayAccessor1<Vector2<T>>& positions,
+                const ParticleNeighborLists& neighborLists, T kernelRadius, T mass,
+                ArrayAccessor1<T> densities, ExecutionPolicy policy = ExecutionPolicy::kParallel);
+
+    template<typename T>
+    void ComputeSPHDensities(const ConstArrayAccessor1<Vector2<T>>& positions,
+                const ParticleNeighborLists& neighborLists, T kernelRadius, T mass,
+                ArrayAccessor1<T> densities, ExecutionPolicy policy)
+    {
+        const SPHStdKernel<T, 2> kernel(kernelRadius);
+
+        ParallelFor(kZeroSize, positions.Size(),
+                        [&](size_t i)
+                        {
+                            double sum = kernel(0);
+                            for (size_t j : neighborLists[i])
+                                sum += kernel(positions[i].DistanceTo(positions[j]));
+                            densities[i] = static_cast<T>(mass * sum);
+        }, policy);
+    }
+}
@@ -0,0 +1,31 @@
+#include <jet.h>
+#include "particle_neighbor_lists.h"
+
+namespace jet
+{
+    size_t ParticleNeighborLists::Size() const
+    {
+        return _Offsets.empty() ? 0 : _Offsets.size() - 1;
+    }
+
+    size_t ParticleNeighborLists::NumberOfNeighbors() const
+    {
+        return _Indices.size();
+    }
+
+    const std::vector<uint32_t>& ParticleNeighborLists::Indices() const
+    {
+        return _Indices;
+    }
+
+    const std::vector<size_t>& ParticleNeighborLists::Offsets() const
+    {
+        return _Offsets;
+    }
+
+    void ParticleNeighborLists::Clear()
+    {
+        _Indices.clear();
+        _Offsets.clear();
+    }
+}
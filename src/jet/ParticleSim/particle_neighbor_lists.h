@@ -0,0 +1,338 @@
+#pragma once
+
+#include <Arrays/array1_accessor.h>
+#include <macros.h>
+#include <parallel.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace jet
+{
+    //! \brief Read-only view of the neighbors of a single particle.
+    //!
+    //! The view points into the storage of ParticleNeighborLists and is
+    //! invalidated when the lists are rebuilt.
+    class ParticleNeighborList final
+    {
+    public:
+        //! Iterator over the neighbor indices.
+        typedef const uint32_t* ConstIterator;
+
+        //! Constructs an empty list.
+        ParticleNeighborList() = default;
+
+        //! Constructs a view of [begin, end).
+        ParticleNeighborList(ConstIterator begin, ConstIterator end);
+
+        //! Returns the number of neighbors.
+        size_t Size() const;
+
+        //! Returns true if there is no neighbor.
+        bool IsEmpty() const;
+
+        //! Returns the index of the \p i-th neighbor.
+        uint32_t operator[](size_t i) const;
+
+        //! Returns the begin iterator.
+        ConstIterator begin() const;
+
+        //! Returns the end iterator.
+        ConstIterator end() const;
+
+    private:
+        ConstIterator _Begin = nullptr;
+        ConstIterator _End = nullptr;
+    };
+
+    //! \brief Neighbor lists of a particle system in compressed sparse row layout.
+    //!
+    //! The indices of the neighbors of all the particles are stored back to
+    //! back in a single array, and the neighbors of particle i are found in
+    //! [Offsets()[i], Offsets()[i + 1]). Compared to one vector per particle,
+    //! rebuilding the lists does not allocate per particle, and iterating over
+    //! the neighbors reads contiguous memory.
+    class ParticleNeighborLists final
+    {
+    public:
+        //! Constructs empty lists.
+        ParticleNeighborLists() = default;
+
+        //! Returns the number of lists, i.e. the number of particles.
+        size_t Size() const;
+
+        //! Returns the total number of neighbors over all the lists.
+        size_t NumberOfNeighbors() const;
+
+        //! Returns the neighbor list of the particle \p i.
+        ParticleNeighborList operator[](size_t i) const;
+
+        //! Returns the neighbor indices of all the particles.
+        const std::vector<uint32_t>& Indices() const;
+
+        //! Returns the offsets of each list in Indices(), with Size() + 1 entries.
+        const std::vector<size_t>& Offsets() const;
+
+        //! Removes all the lists.
+        void Clear();
+
+        //! \brief Builds the lists with a two-pass count/scan/fill.
+        //!
+        //! The first pass counts the neighbors of each particle, the offsets
+        //! are then computed with an exclusive scan of the counts, and the
+        //! second pass writes the indices to their final location. Both passes
+        //! run in parallel over the particles, so \p forEachNeighbor has to be
+        //! thread-safe and has to visit the same neighbors in both passes.
+        //!
+        //! \param[in] numberOfParticles The number of particles.
+        //! \param[in] forEachNeighbor   Function called as
+        //!                              forEachNeighbor(i, visitor) which calls
+        //!                              visitor(j) for every neighbor j of i.
+        //! \param[in] policy            The execution policy.
+        //!
+        //! \tparam ForEachNeighborFunc Function type.
+        template<typename ForEachNeighborFunc>
+        void Build(size_t numberOfParticles, const ForEachNeighborFunc& forEachNeighbor,
+                    ExecutionPolicy policy = ExecutionPolicy::kParallel);
+
+        //! \brief Accumulates contributions over the pairs stored in the lists.
+        //!
+        //! Calls func(i, j, resultI, resultJ) once for each neighbor j in the
+        //! list of particle i, where the contributions of the pair to particle
+        //! i and j are added to resultI and resultJ. On half lists each unique
+        //! pair is visited once, so a symmetric interaction is computed once
+        //! and applied to both particles. The particles are split in one batch
+        //! per thread and each batch accumulates into its own buffer, so \p func
+        //! never writes to the same element from two threads. The buffers are
+        //! then added to \p result. A buffer only spans the indices of the
+        //! particles of its batch and of their neighbors, which stays short
+        //! when nearby particles are stored close to each other (see
+        //! ParticleSystemData2::ReorderBySpatialKey), and the buffers are kept
+        //! by the calling thread for the next calls.
+        //!
+        //! \param[in,out] result The values to accumulate to, one per particle.
+        //! \param[in]     func   The pair function.
+        //! \param[in]     policy The execution policy.
+        //!
+        //! \tparam T            Value type. T() must be zero and T must support +=.
+        //! \tparam PairFunction Function type.
+        template<typename T, typename PairFunction>
+        void AccumulatePairs(ArrayAccessor1<T> result, const PairFunction& func,
+                    ExecutionPolicy policy = ExecutionPolicy::kParallel) const;
+
+    private:
+        std::vector<uint32_t> _Indices;
+        std::vector<size_t> _Offsets;
+    };
+
+    namespace internal
+    {
+        // Largest buffer of AccumulatePairs kept by a thread between two calls.
+        constexpr size_t kMaxRetainedPairBufferBytes = size_t(1) << 24;
+
+        // Lends the per-batch buffers of AccumulatePairs for the lifetime of
+        // the object. The buffers are kept per thread and value type, so
+        // repeated passes do not allocate. A re-entrant call on the same
+        // thread, which can happen when this thread helps the pool while
+        // waiting, gets local buffers.
+        template<typename T>
+        class ScopedPairBuffers final
+        {
+        public:
+            explicit ScopedPairBuffers(size_t numberOfBatches)
+            {
+                if (!IsCachedInUse())
+                {
+                    if (Cached().size() < numberOfBatches)
+                        Cached().resize(numberOfBatches);
+                    IsCachedInUse() = true;
+                    _Buffers = &Cached();
+                }
+                else
+                {
+                    _Local.resize(numberOfBatches);
+                    _Buffers = &_Local;
+                }
+            }
+
+            ~ScopedPairBuffers()
+            {
+                if (_Buffers != &Cached())
+                    return;
+
+                for (std::vector<T>& buffer : *_Buffers)
+                {
+                    if (buffer.capacity() * sizeof(T) > kMaxRetainedPairBufferBytes)
+                        std::vector<T>().swap(buffer);
+                }
+                IsCachedInUse() = false;
+            }
+
+            ScopedPairBuffers(const ScopedPairBuffers&) = delete;
+            ScopedPairBuffers& operator=(const ScopedPairBuffers&) = delete;
+
+            std::vector<T>& operator[](size_t batch)
+            {
+                return (*_Buffers)[batch];
+            }
+
+        private:
+            std::vector<std::vector<T>> _Local;
+            std::vector<std::vector<T>>* _Buffers = nullptr;
+
+            static std::vector<std::vector<T>>& Cached()
+            {
+                static thread_local std::vector<std::vector<T>> buffers;
+                return buffers;
+            }
+
+            static bool& IsCachedInUse()
+            {
+                static thread_local bool isInUse = false;
+                return isInUse;
+            }
+        };
+    }
+
+    inline ParticleNeighborList::ParticleNeighborList(ConstIterator begin, ConstIterator end)
+        : _Begin(begin), _End(end)
+    {}
+
+    inline size_t ParticleNeighborList::Size() const
+    {
+        return static_cast<size_t>(_End - _Begin);
+    }
+
+    inline bool ParticleNeighborList::IsEmpty() const
+    {
+        return _Begin == _End;
+    }
+
+    inline uint32_t ParticleNeighborList::operator[](size_t i) const
+    {
+        return _Begin[i];
+    }
+
+    inline ParticleNeighborList::ConstIterator ParticleNeighborList::begin() const
+    {
+        return _Begin;
+    }
+
+    inline ParticleNeighborList::ConstIterator ParticleNeighborList::end() const
+    {
+        return _End;
+    }
+
+    inline ParticleNeighborList ParticleNeighborLists::operator[](size_t i) const
+    {
+        const uint32_t* indices = _Indices.data();
+        return ParticleNeighborList(indices + _Offsets[i], indices + _Offsets[i + 1]);
+    }
+
+    template<typename ForEachNeighborFunc>
+    void ParticleNeighborLists::Build(size_t numberOfParticles,
+                    const ForEachNeighborFunc& forEachNeighbor, ExecutionPolicy policy)
+    {
+        JET_THROW_INVALID_ARG_IF(numberOfParticles > std::numeric_limits<uint32_t>::max());
+
+        // Pass 1: count the neighbors of each particle.
+        _Offsets.resize(numberOfParticles + 1);
+        ParallelFor(kZeroSize, numberOfParticles,
+                    [&](size_t i)
+                    {
+                        size_t count = 0;
+                        forEachNeighbor(i, [&count](size_t) { ++count; });
+                        _Offsets[i] = count;
+                    }, policy);
+
+        // Turn the counts into offsets in place.
+        if (internal::IsSerial(policy, numberOfParticles))
+        {
+            size_t sum = 0;
+            for (size_t i = 0; i < numberOfParticles; ++i)
+            {
+                const size_t count = _Offsets[i];
+                _Offsets[i] = sum;
+                sum += count;
+            }
+            _Offsets[numberOfParticles] = sum;
+        }
+        else
+        {
+            _Offsets[numberOfParticles] = ParallelExclusiveScan(_Offsets.begin(),
+                    _Offsets.end() - 1, _Offsets.begin(), kZeroSize);
+        }
+
+        // Pass 2: write the indices to their final location.
+        _Indices.resize(_Offsets[numberOfParticles]);
+        ParallelFor(kZeroSize, numberOfParticles,
+                    [&](size_t i)
+                    {
+                        uint32_t* out = _Indices.data() + _Offsets[i];
+                        forEachNeighbor(i, [&out](size_t j) { *out++ = static_cast<uint32_t>(j); });
+                    }, policy);
+    }
+
+    template<typename T, typename PairFunction>
+    void ParticleNeighborLists::AccumulatePairs(ArrayAccessor1<T> result,
+                    const PairFunction& func, ExecutionPolicy policy) const
+    {
+        const size_t numberOfParticles = Size();
+        JET_THROW_INVALID_ARG_IF(result.Size() < numberOfParticles);
+
+        if (internal::IsSerial(policy, numberOfParticles))
+        {
+            for (size_t i = 0; i < numberOfParticles; ++i)
+            {
+                for (size_t j : (*this)[i])
+                    func(i, j, result[i], result[j]);
+            }
+            return;
+        }
+
+        const size_t numberOfBatches = std::min<size_t>(GetMaxNumberOfThreads(), numberOfParticles);
+        internal::ScopedPairBuffers<T> buffers(numberOfBatches);
+        std::vector<size_t> spanBegins(numberOfBatches);
+        std::vector<size_t> spanEnds(numberOfBatches);
+
+        // One task per batch, hence the explicit kParallel for this short range.
+        ParallelFor(kZeroSize, numberOfBatches,
+                    [&](size_t batch)
+                    {
+                        const size_t begin = batch * numberOfParticles / numberOfBatches;
+                        const size_t end = (batch + 1) * numberOfParticles / numberOfBatches;
+
+                        // The buffer covers [spanBegin, spanEnd), the indices
+                        // the batch writes to.
+                        size_t spanBegin = begin;
+                        size_t spanEnd = end;
+                        for (size_t k = _Offsets[begin]; k < _Offsets[end]; ++k)
+                        {
+                            spanBegin = std::min<size_t>(spanBegin, _Indices[k]);
+                            spanEnd = std::max<size_t>(spanEnd, _Indices[k] + 1);
+                        }
+                        spanBegins[batch] = spanBegin;
+                        spanEnds[batch] = spanEnd;
+
+                        std::vector<T>& buffer = buffers[batch];
+                        buffer.assign(spanEnd - spanBegin, T());
+                        for (size_t i = begin; i < end; ++i)
+                        {
+                            for (size_t j : (*this)[i])
+                                func(i, j, buffer[i - spanBegin], buffer[j - spanBegin]);
+                        }
+                    }, ExecutionPolicy::kParallel);
+
+        ParallelFor(kZeroSize, numberOfParticles,
+                    [&](size_t i)
+                    {
+                        for (size_t batch = 0; batch < numberOfBatches; ++batch)
+                        {
+                            if (i >= spanBegins[batch] && i < spanEnds[batch])
+                                result[i] += buffers[batch][i - spanBegins[batch]];
+                        }
+                    }, policy);
+    }
+}
@@ -7,6 +7,7 @@
 #include <parallel.h>
 #include "particle_system_data2.h"
 #include <NeighborhoodSearch/point2_parallel_hash_grid_search.h>
+#include <math-utils.h>
 #include <timer.h>
 
 #include <algorithm>
@@ -16,6 +17,10 @@ namespace jet
 {
     static const size_t kDefaultHashGridResolution = 64;
 
+    // Number of bits per axis of the quantized positions used by
+    // ReorderBySpatialKey, so that the Morton codes fit in 32 bits.
+    static const unsigned int kSpatialKeyBits = 16;
+
     ParticleSystemData2::ParticleSystemData2()
             : ParticleSystemData2(0)
     {}
@@ -53,6 +58,37 @@ namespace jet
             attr.Resize(NewNumberOfPoints, Vector2D());
     }
 
+    void ParticleSystemData2::Reserve(size_t NumberOfParticles)
+    {
+        for (auto& attr : _ScalarDataList)
+            attr.Reserve(NumberOfParticles);
+
+        for (auto& attr : _VectorDataList)
+            attr.Reserve(NumberOfParticles);
+    }
+
+    size_t ParticleSystemData2::Capacity() const
+    {
+        size_t capacity = kMaxSize;
+        for (const auto& attr : _ScalarDataList)
+            capacity = std::min(capacity, attr.Capacity());
+
+        for (const auto& attr : _VectorDataList)
+            capacity = std::min(capacity, attr.Capacity());
+
+        return capacity;
+    }
+
+    void ParticleSystemData2::Grow(size_t NewNumberOfParticles)
+    {
+        // Doubling the capacity of every layer at once keeps appending
+        // particles amortized constant time, even though each layer is a
+        // separate allocation.
+        const size_t capacity = Capacity();
+        if (NewNumberOfParticles > capacity)
+            Reserve(std::max(NewNumberOfParticles, 2 * capacity));
+    }
+
     size_t ParticleSystemData2::NumberOfParticles() const
     {
         return _NumberOfParticles;
@@ -112,6 +148,37 @@ namespace jet
         return VectorDataAt(_VelocityIdx);
     }
 
+    ArrayAccessor1<Vector2D> ParticleSystemData2::NewPositions()
+    {
+        ResizeBackBuffer(_VectorDataList[_PositionIdx], &_NewPositions);
+        return _NewPositions.Accessor();
+    }
+
+    ArrayAccessor1<Vector2D> ParticleSystemData2::NewVelocities()
+    {
+        ResizeBackBuffer(_VectorDataList[_VelocityIdx], &_NewVelocities);
+        return _NewVelocities.Accessor();
+    }
+
+    void ParticleSystemData2::SwapNewPositionsAndVelocities()
+    {
+        JET_THROW_INVALID_ARG_IF(_NewPositions.Size() != NumberOfParticles()
+                                || _NewVelocities.Size() != NumberOfParticles());
+
+        _VectorDataList[_PositionIdx].Swap(_NewPositions);
+        _VectorDataList[_VelocityIdx].Swap(_NewVelocities);
+    }
+
+    void ParticleSystemData2::ResizeBackBuffer(const VectorData& front, VectorData* back)
+    {
+        // The buffers take turns as the front layer, so the back buffer keeps
+        // the capacity of the front one for Grow.
+        if (back->Capacity() < front.Capacity())
+            back->Reserve(front.Capacity());
+
+        back->Resize(NumberOfParticles());
+    }
+
     ConstArrayAccessor1<Vector2D> ParticleSystemData2::Forces() const
     {
         return VectorDataAt(_ForceIdx);
@@ -145,11 +212,24 @@ namespace jet
     void ParticleSystemData2::AddParticle(const Vector2D& NewPosition,
                     const Vector2D& NewVelocity, const Vector2D& NewForce)
     {
-        Array1<Vector2D> NewPositions = {NewPosition};
-        Array1<Vector2D> NewVelocities = {NewVelocity};
-        Array1<Vector2D> NewForces = {NewForce};
+        // Appends to each layer in place, without temporary arrays.
+        Grow(NumberOfParticles() + 1);
+        ++_NumberOfParticles;
+
+        for (auto& attr : _ScalarDataList)
+            attr.Append(0.0);
 
-        AddParticles(NewPositions.ConstAccessor(), NewVelocities.ConstAccessor(), NewForces.ConstAccessor());
+        for (size_t idx = 0; idx < _VectorDataList.size(); ++idx)
+        {
+            if (idx == _PositionIdx)
+                _VectorDataList[idx].Append(NewPosition);
+            else if (idx == _VelocityIdx)
+                _VectorDataList[idx].Append(NewVelocity);
+            else if (idx == _ForceIdx)
+                _VectorDataList[idx].Append(NewForce);
+            else
+                _VectorDataList[idx].Append(Vector2D());
+        }
     }
 
     void ParticleSystemData2::AddParticles(const ConstArrayAccessor1<Vector2D>& NewPositions,
@@ -159,36 +239,206 @@ namespace jet
         JET_THROW_INVALID_ARG_IF(NewVelocities.Size() > 0 && NewVelocities.Size()!= NewPositions.Size());
         JET_THROW_INVALID_ARG_IF(NewForces.Size() > 0 && NewForces.Size()!= NewPositions.Size());
 
-        size_t OldNumberOfParticles = NumberOfParticles();
-        size_t NewNumberOfParticles = OldNumberOfParticles + NewPositions.Size();
+        size_t NewNumberOfParticles = NumberOfParticles() + NewPositions.Size();
+
+        Grow(NewNumberOfParticles);
+        _NumberOfParticles = NewNumberOfParticles;
 
-        Resize(NewNumberOfParticles);
+        for (auto& attr : _ScalarDataList)
+            attr.Resize(NewNumberOfParticles, 0.0);
 
-        auto Pos = Positions();
-        auto Vel = Velocities();
-        auto Force = Forces();
+        // The given layers are appended, so their new slots are not
+        // zero-filled before being overwritten.
+        for (size_t idx = 0; idx < _VectorDataList.size(); ++idx)
+        {
+            auto& attr = _VectorDataList[idx];
+            if (idx == _PositionIdx)
+                attr.Append(NewPositions);
+            else if (idx == _VelocityIdx && NewVelocities.Size() > 0)
+                attr.Append(NewVelocities);
+            else if (idx == _ForceIdx && NewForces.Size() > 0)
+                attr.Append(NewForces);
+            else
+                attr.Resize(NewNumberOfParticles, Vector2D());
+        }
+    }
+
+    std::vector<size_t> ParticleSystemData2::RemoveParticles(const std::function<bool(size_t)>& predicate)
+    {
+        const size_t n = NumberOfParticles();
+
+        // The new index of a kept particle is the number of kept particles
+        // before it.
+        std::vector<char> isRemoved(n);
+        std::vector<size_t> newIndices(n);
+        ParallelFor(kZeroSize, n, [&](size_t i) {
+            isRemoved[i] = predicate(i) ? 1 : 0;
+            newIndices[i] = isRemoved[i] ? 0 : 1;
+        });
+        const size_t NewNumberOfParticles = ParallelExclusiveScan(newIndices.begin(),
+                newIndices.end(), newIndices.begin(), kZeroSize);
+        if (NewNumberOfParticles == n)
+            return newIndices;
+
+        Timer timer;
 
-        ParallelFor(kZeroSize, NewPositions.Size(),
-                [&](size_t i){
-                     Pos[i + OldNumberOfParticles] = NewPositions[i];
-                });
+        // Scatter each layer into a buffer and swap, as in ReorderBySpatialKey.
+        ScalarData scalarBuffer(NewNumberOfParticles);
+        for (auto& attr : _ScalarDataList)
+        {
+            scalarBuffer.Resize(NewNumberOfParticles);
+            ParallelFor(kZeroSize, n, [&](size_t i) {
+                if (!isRemoved[i])
+                    scalarBuffer[newIndices[i]] = attr[i];
+            });
+            attr.Swap(scalarBuffer);
+        }
 
-        if (NewVelocities.Size() > 0)
+        VectorData vectorBuffer(NewNumberOfParticles);
+        for (auto& attr : _VectorDataList)
         {
-            ParallelFor(kZeroSize, NewPositions.Size(),
-                [&](size_t i){
-                     Vel[i + OldNumberOfParticles] = NewVelocities[i];
-                });    
+            vectorBuffer.Resize(NewNumberOfParticles);
+            ParallelFor(kZeroSize, n, [&](size_t i) {
+                if (!isRemoved[i])
+                    vectorBuffer[newIndices[i]] = attr[i];
+            });
+            attr.Swap(vectorBuffer);
         }
 
-        if (NewForces.Size() > 0)
+        _NumberOfParticles = NewNumberOfParticles;
+
+        // A hash grid of the old particles only has to drop the removed
+        // points, the kept ones have not moved.
+        auto hashGrid = std::dynamic_pointer_cast<PointParallelHashGridSearch2>(_NeighborSearch);
+        if (hashGrid != nullptr && hashGrid->SortedIndices().size() == n)
         {
-            ParallelFor(kZeroSize, NewPositions.Size(),
-                [&](size_t i){
-                     Force[i + OldNumberOfParticles] = NewForces[i];
-                });    
+            std::vector<size_t> indices(n);
+            ParallelFor(kZeroSize, n, [&](size_t i) { indices[i] = i; });
+
+            std::vector<size_t> removed(n - NewNumberOfParticles);
+            ParallelCompact(indices.begin(), indices.end(),
+                    [&](size_t i) { return isRemoved[i] != 0; }, removed.begin());
+            hashGrid->Remove(ConstArrayAccessor1<size_t>(removed.size(), removed.data()));
         }
-        
+
+        _NeighborLists.Clear();
+        _HalfNeighborLists.Clear();
+        InvalidateNeighborLists();
+
+        ParallelFor(kZeroSize, n, [&](size_t i) {
+            if (isRemoved[i])
+                newIndices[i] = kMaxSize;
+        });
+
+        JET_INFO << "Removing " << n - NewNumberOfParticles << " particles took: "
+                << timer.DurationInSeconds()
+                << " seconds";
+
+        return newIndices;
+    }
+
+    std::vector<size_t> ParticleSystemData2::RemoveParticles(const ConstArrayAccessor1<size_t>& indices)
+    {
+        const size_t n = NumberOfParticles();
+
+        std::vector<char> isRemoved(n, 0);
+        for (size_t i = 0; i < indices.Size(); ++i)
+        {
+            JET_THROW_INVALID_ARG_IF(indices[i] >= n);
+            isRemoved[indices[i]] = 1;
+        }
+
+        return RemoveParticles([&](size_t i) { return isRemoved[i] != 0; });
+    }
+
+    BoundingBox2D ParticleSystemData2::ComputeBoundingBox() const
+    {
+        auto positions = Positions();
+        return ParallelReduce(kZeroSize, NumberOfParticles(), BoundingBox2D(),
+                    [&](size_t i)
+                    {
+                        return BoundingBox2D(positions[i], positions[i]);
+                    },
+                    [](BoundingBox2D a, const BoundingBox2D& b)
+                    {
+                        a.Merge(b);
+                        return a;
+                    });
+    }
+
+    void ParticleSystemData2::ReorderBySpatialKey()
+    {
+        const size_t n = NumberOfParticles();
+        if (n == 0)
+            return;
+
+        Timer timer;
+
+        // Quantize the positions in the bounding box of the particles.
+        auto positions = Positions();
+        const BoundingBox2D bounds = ComputeBoundingBox();
+        const Vector2D& lower = bounds.LowerCorner;
+        const Vector2D& upper = bounds.UpperCorner;
+
+        const uint64_t kMaxCoordinate = (uint64_t(1) << kSpatialKeyBits) - 1;
+        const Vector2D extent = upper - lower;
+        auto quantize = [&](double x, size_t axis)
+        {
+            if (extent[axis] <= 0.0)
+                return uint64_t(0);
+
+            const double t = (x - lower[axis]) / extent[axis];
+            return std::min(static_cast<uint64_t>(t * kMaxCoordinate), kMaxCoordinate);
+        };
+
+        std::vector<uint64_t> keys(n);
+        std::vector<size_t> order(n);
+        ParallelFor(kZeroSize, n,
+                    [&](size_t i)
+                    {
+                        keys[i] = internal::MortonCode2(quantize(positions[i].x, 0),
+                                                        quantize(positions[i].y, 1));
+                        order[i] = i;
+                    });
+
+        ParallelRadixSortByKey(keys.begin(), keys.end(), order.begin(),
+                    internal::MortonCode2(kMaxCoordinate, kMaxCoordinate));
+
+        // Gather each layer into a buffer and swap, so the buffer holds the
+        // old layer afterwards and can be reused for the next one.
+        ScalarData scalarBuffer(n);
+        for (auto& attr : _ScalarDataList)
+        {
+            ParallelFor(kZeroSize, n, [&](size_t i) { scalarBuffer[i] = attr[order[i]]; });
+            attr.Swap(scalarBuffer);
+        }
+
+        VectorData vectorBuffer(n);
+        for (auto& attr : _VectorDataList)
+        {
+            ParallelFor(kZeroSize, n, [&](size_t i) { vectorBuffer[i] = attr[order[i]]; });
+            attr.Swap(vectorBuffer);
+        }
+
+        _NeighborLists.Clear();
+        _HalfNeighborLists.Clear();
+        InvalidateNeighborLists();
+
+        if (_ReorderCallback)
+        {
+            std::vector<size_t> newIndices(n);
+            ParallelFor(kZeroSize, n, [&](size_t i) { newIndices[order[i]] = i; });
+            _ReorderCallback(ConstArrayAccessor1<size_t>(n, newIndices.data()));
+        }
+
+        JET_INFO << "Reordering particles took: "
+                << timer.DurationInSeconds()
+                << " seconds";
+    }
+
+    void ParticleSystemData2::SetReorderCallback(const ReorderCallback& callback)
+    {
+        _ReorderCallback = callback;
     }
 
     const PointNeighborSearch2Ptr& ParticleSystemData2::NeighborSearch() const
@@ -201,49 +451,150 @@ namespace jet
         _NeighborSearch = NewNeighborSearch;
     }
 
-    const std::vector<std::vector<size_t>>& ParticleSystemData2::NeighborLists() const
+    const ParticleNeighborLists& ParticleSystemData2::NeighborLists() const
     {
         return _NeighborLists;
     }
 
+    const ParticleNeighborLists& ParticleSystemData2::HalfNeighborLists() const
+    {
+        return _HalfNeighborLists;
+    }
+
     void ParticleSystemData2::BuildNeighborSearch(double MaxSearchRadius)
     {
         Timer timer;
 
         //Using PointParallelHashGridSearch2 by default.
-        _NeighborSearch = std::make_shared<PointParallelHashGridSearch2>(
-                    kDefaultHashGridResolution, kDefaultHashGridResolution,
-                    2.0 * MaxSearchRadius);
-        _NeighborSearch->Build(Positions());
+        // The resolution covers the particles without wrapping, unless the
+        // particles are too sparse for the load factor.
+        const double GridSpacing = 2.0 * MaxSearchRadius;
+        const Size2 Resolution = SuggestHashGridResolution(ComputeBoundingBox(),
+                    NumberOfParticles(), GridSpacing);
+        // Few particles change bucket between two builds, so a hash grid of
+        // the same size and number of points is updated instead.
+        auto hashGrid = std::dynamic_pointer_cast<PointParallelHashGridSearch2>(_NeighborSearch);
+        if (hashGrid != nullptr && hashGrid->GridSpacing() == GridSpacing
+            && hashGrid->Resolution() == Resolution
+            && hashGrid->SortedIndices().size() == NumberOfParticles())
+        {
+            hashGrid->Update(Positions());
+        }
+        else
+        {
+            _NeighborSearch = std::make_shared<PointParallelHashGridSearch2>(Resolution, GridSpacing);
+            _NeighborSearch->Build(Positions());
+        }
 
         JET_INFO << "Building Neighbor Search took: "
                 << timer.DurationInSeconds()
                 << " seconds";
     }
 
-    void ParticleSystemData2::BuildNeighborLists(double MaxSearchRadius)
+    void ParticleSystemData2::BuildNeighborLists(double MaxSearchRadius, double SkinRadius)
     {
+        if (SkinRadius > 0.0 && !IsNeighborListsRebuildNeeded(MaxSearchRadius, SkinRadius))
+        {
+            ++_NumberOfNeighborListReuses;
+            return;
+        }
+
+        if (SkinRadius > 0.0)
+            BuildNeighborSearch(MaxSearchRadius + SkinRadius);
+
         Timer timer;
 
-        _NeighborLists.resize(NumberOfParticles());
+        const double QueryRadius = MaxSearchRadius + SkinRadius;
         auto points = Positions();
-        for (size_t i = 0; i < NumberOfParticles(); ++i)
+        _NeighborLists.Build(NumberOfParticles(),
+                        [&](size_t i, const auto& visit)
+                        {
+                            _NeighborSearch->VisitNearbyPoints(points[i], QueryRadius,
+                                            [&](size_t j, const Vector2D&){
+                                                if (i != j)
+                                                    visit(j);
+                                            });
+                        });
+        _HalfNeighborLists.Clear();
+
+        if (SkinRadius > 0.0)
+        {
+            _NeighborListsPositions.Resize(NumberOfParticles());
+            ParallelFor(kZeroSize, NumberOfParticles(),
+                    [&](size_t i)
+                    {
+                        _NeighborListsPositions[i] = points[i];
+                    });
+        }
+        else
         {
-            Vector2D origin = points[i];
-            _NeighborLists[i].clear();
-
-            _NeighborSearch->ForEachNearbyPoint(origin, MaxSearchRadius,
-                            [&](size_t j, const Vector2D&){
-                                if (i != j)
-                                    _NeighborLists[i].push_back(j);
-                            });
+            _NeighborListsPositions.Clear();
         }
 
+        _NeighborListsSearchRadius = MaxSearchRadius;
+        _NeighborListsSkinRadius = SkinRadius;
+        ++_NumberOfNeighborListBuilds;
+
         JET_INFO << "Building Neighbor List took: "
                 << timer.DurationInSeconds()
                 << " seconds";
     }
 
+    void ParticleSystemData2::InvalidateNeighborLists()
+    {
+        _NeighborListsPositions.Clear();
+        _NeighborListsSkinRadius = 0.0;
+    }
+
+    size_t ParticleSystemData2::NumberOfNeighborListBuilds() const
+    {
+        return _NumberOfNeighborListBuilds;
+    }
+
+    size_t ParticleSystemData2::NumberOfNeighborListReuses() const
+    {
+        return _NumberOfNeighborListReuses;
+    }
+
+    bool ParticleSystemData2::IsNeighborListsRebuildNeeded(double MaxSearchRadius, double SkinRadius) const
+    {
+        const size_t NumParticles = NumberOfParticles();
+        if (_NeighborListsSkinRadius != SkinRadius
+            || _NeighborListsSearchRadius != MaxSearchRadius
+            || _NeighborListsPositions.Size() != NumParticles
+            || _NeighborLists.Size() != NumParticles)
+        {
+            return true;
+        }
+
+        // The lists hold every pair closer than MaxSearchRadius as long as no
+        // particle has moved more than half the skin radius.
+        auto points = Positions();
+        double MaxDisplacementSq = ParallelMax(kZeroSize, NumParticles,
+                    [&](size_t i)
+                    {
+                        return points[i].DistanceSquaredTo(_NeighborListsPositions[i]);
+                    });
+
+        return NumParticles > 0 && MaxDisplacementSq > Square(0.5 * SkinRadius);
+    }
+
+    void ParticleSystemData2::BuildHalfNeighborLists()
+    {
+        if (_HalfNeighborLists.Size() == _NeighborLists.Size())
+            return;
+
+        _HalfNeighborLists.Build(_NeighborLists.Size(),
+                        [&](size_t i, const auto& visit)
+                        {
+                            for (size_t j : _NeighborLists[i])
+                            {
+                                if (j > i)
+                                    visit(j);
+                            }
+                        });
+    }
+
     void ParticleSystemData2::Serialize(std::vector<uint8_t>* buffer) const
     {
         flatbuffers::FlatBufferBuilder builder(1024);
@@ -282,6 +633,10 @@ namespace jet
 
         _NeighborSearch = other._NeighborSearch->Clone();
         _NeighborLists = other._NeighborLists;
+        _HalfNeighborLists = other._HalfNeighborLists;
+        _NeighborListsPositions.Set(other._NeighborListsPositions);
+        _NeighborListsSearchRadius = other._NeighborListsSearchRadius;
+        _NeighborListsSkinRadius = other._NeighborListsSkinRadius;
     }
 
     ParticleSystemData2& ParticleSystemData2::operator=(const ParticleSystemData2& other)
@@ -330,8 +685,9 @@ namespace jet
 
         //Copy Neighbor Lists.
         std::vector<flatbuffers::Offset<fbs::ParticleNeighborList2>> NeighborLists;
-        for (const auto& neighbors: _NeighborLists)
+        for (size_t i = 0; i < _NeighborLists.Size(); ++i)
         {
+            const auto neighbors = _NeighborLists[i];
             std::vector<uint64_t> Neighbors64(neighbors.begin(), neighbors.end());
             flatbuffers::Offset<fbs::ParticleNeighborList2> fbsNeighborList
                 = fbs::CreateParticleNeighborList2(*builder, 
@@ -397,19 +753,14 @@ namespace jet
 
         //Copy Neighbor List
         auto fbsNeighborLists = fbsParticleSystemData->neighborLists();
-        _NeighborLists.resize(fbsNeighborLists->size());
-        for (uint32_t i = 0; i < fbsNeighborLists->size(); ++i)
-        {
-            auto fbsNeighborList = fbsNeighborLists->Get(i);
-            _NeighborLists[i].resize(fbsNeighborList->data()->size());
-            std::transform(fbsNeighborList->data()->begin(),
-            fbsNeighborList->data()->end(),
-            _NeighborLists[i].begin(),
-            [](uint64_t val)
-            {
-                return static_cast<size_t>(val);
-            });
-        }
+        _NeighborLists.Build(fbsNeighborLists->size(),
+                        [&](size_t i, const auto& visit)
+                        {
+                            for (uint64_t j : *fbsNeighborLists->Get(static_cast<uint32_t>(i))->data())
+                                visit(static_cast<size_t>(j));
+                        }, ExecutionPolicy::kSerial);
+        _HalfNeighborLists.Clear();
+        InvalidateNeighborLists();
 
     }
 
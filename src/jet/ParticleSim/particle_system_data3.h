@@ -1,9 +1,12 @@
 #pragma once
 
 #include <Arrays/array1.h>
+#include <Geometry/BoundingBox/bounding_box3.h>
 #include <IO/Serialization/serialization.h>
+#include <ParticleSim/particle_neighbor_lists.h>
 #include "NeighborhoodSearch/point3_neighbor_search.h"
 
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -37,6 +40,12 @@ namespace jet
         //! Vector Data Chunk
         typedef Array1<Vector3D> VectorData;
 
+        //! \brief Callback type of ReorderBySpatialKey.
+        //!
+        //! The argument maps the old index of each particle to its new index,
+        //! i.e. the particle previously at index i is now at NewIndices[i].
+        typedef std::function<void(ConstArrayAccessor1<size_t> NewIndices)> ReorderCallback;
+
         //! Default Constructor
         ParticleSystemData3();
 
@@ -62,6 +71,18 @@ namespace jet
         //! Returns the number of particles.
         size_t NumberOfParticles() const;
 
+        //! \brief Reserves memory for given number of particles in every data layer.
+        //!
+        //! AddParticle and AddParticles grow the capacity geometrically, so
+        //! continuous emission only reallocates the layers occasionally.
+        //! Reserving up front avoids these reallocations too.
+        //!
+        //! \param[in] NumberOfParticles The number of particles to reserve for.
+        void Reserve(size_t NumberOfParticles);
+
+        //! Returns the number of particles every data layer can hold without reallocation.
+        size_t Capacity() const;
+
         //! \brief Adds a scalar data layer and returns its index.
         //!
         //! This function adds a new scalar data layer to the particle system. It can be used
@@ -150,6 +171,54 @@ namespace jet
 
         
 
+        //! \brief Removes the particles for which the predicate returns true.
+        //!
+        //! The remaining particles keep their order, and every scalar and
+        //! vector data layer is compacted in parallel with a stable scan of the
+        //! kept particles. The neighbor lists refer to the old indices, so they
+        //! are cleared. A PointParallelHashGridSearch3 neighbor search built
+        //! for the old particles is remapped with
+        //! PointParallelHashGridSearch3::Remove; any other neighbor search
+        //! must be refreshed with BuildNeighborSearch.
+        //!
+        //! \param[in] predicate The predicate, called in parallel with the
+        //!                      index of each particle.
+        //! \return The map from the old index of each particle to its new
+        //!         index, or kMaxSize for the removed particles.
+        std::vector<size_t> RemoveParticles(const std::function<bool(size_t)>& predicate);
+
+        //! \brief Removes the particles at given indices.
+        //!
+        //! Same as the predicate version. Duplicated indices are allowed.
+        //!
+        //! \param[in] indices The indices of the particles to be removed.
+        //! \return The map from the old index of each particle to its new
+        //!         index, or kMaxSize for the removed particles.
+        std::vector<size_t> RemoveParticles(const ConstArrayAccessor1<size_t>& indices);
+
+        //! Returns the bounding box of the particle positions, computed in parallel.
+        BoundingBox3D ComputeBoundingBox() const;
+
+        //! \brief Reorders the particles along a Z-order curve.
+        //!
+        //! Particles are added in emission order, so once the fluid mixes,
+        //! particles that are close in space are far apart in memory and the
+        //! neighbor loops read memory randomly. This function sorts the particles
+        //! by the Morton code of their position quantized in the bounding box of
+        //! the particles, and permutes every scalar and vector data layer
+        //! accordingly, so that nearby particles are stored close to each other.
+        //!
+        //! The neighbor search and neighbor lists refer to the old indices, so
+        //! the neighbor lists are cleared and users must call BuildNeighborSearch
+        //! and BuildNeighborLists to refresh them. The callback set with
+        //! SetReorderCallback is called with the permutation so that indices held
+        //! outside of this class can be remapped.
+        void ReorderBySpatialKey();
+
+        //! Sets the callback called by ReorderBySpatialKey. The callback is not
+        //! copied by Set.
+        void SetReorderCallback(const ReorderCallback& callback);
+
         //! \brief Returns Neighbor Search Instance.
         //!
         //! This function returns the currently set neighbor search object. By
@@ -165,17 +234,65 @@ namespace jet
         //! \brief Returns Neighbor lists.
         //!
         //! This function returns neighbor lists which is available after calling
-        //! ParticleSystemData2::BuildNeighborLists. Each lists stores
-        //! indices of the neighbors.
+        //! ParticleSystemData3::BuildNeighborLists. Each lists stores
+        //! indices of the neighbors. The lists are packed in a single array, so
+        //! NeighborLists()[i] is a lightweight view of contiguous memory.
         //!
         //! \return Neighbor Lists.
-        const std::vector<std::vector<size_t>>& NeighborLists() const;
+        const ParticleNeighborLists& NeighborLists() const;
+
+        //! \brief Returns half neighbor lists.
+        //!
+        //! Same as NeighborLists, except that the list of particle i only
+        //! stores the neighbors j > i, so each unique pair appears once. Use
+        //! ParticleNeighborLists::AccumulatePairs to apply symmetric pairwise
+        //! interactions with half of the work. The lists are only available
+        //! after calling ParticleSystemData3::BuildHalfNeighborLists, and are
+        //! cleared when the neighbor lists are rebuilt.
+        //!
+        //! \return Half Neighbor Lists.
+        const ParticleNeighborLists& HalfNeighborLists() const;
 
-        //! Builds Neighbor Search Instance with given search radius.
+        //! \brief Builds the half neighbor lists from the neighbor lists.
+        //!
+        //! Does nothing if the half lists of the current neighbor lists are
+        //! already built, e.g. when BuildNeighborLists reused Verlet lists.
+        void BuildHalfNeighborLists();
+
+        //! \brief Builds Neighbor Search Instance with given search radius.
+        //!
+        //! A PointParallelHashGridSearch3 is used, with a resolution derived
+        //! from the bounding box and the number of the particles by
+        //! SuggestHashGridResolution.
+        //! When the current search is such a hash grid with the same resolution,
+        //! grid spacing and number of points, it is updated in place with
+        //! PointParallelHashGridSearch3::Update instead of being rebuilt.
         void BuildNeighborSearch(double MaxSearchRadius);
 
-        //! Builds NeighborLists with given search radius.
-        void BuildNeighborLists(double MaxSearchRadius);
+        //! \brief Builds NeighborLists with given search radius.
+        //!
+        //! With a positive \p SkinRadius the lists are Verlet lists. They store
+        //! the neighbors within MaxSearchRadius + SkinRadius, and the neighbor
+        //! search is rebuilt with them for that radius, so BuildNeighborSearch
+        //! does not have to be called beforehand. The next calls with the same
+        //! radii reuse the lists until a particle has moved more than half the
+        //! skin radius since the last build, or the number of particles has
+        //! changed. The lists can then contain particles further than
+        //! MaxSearchRadius, which have to be filtered by distance.
+        //!
+        //! \param[in] MaxSearchRadius The search radius.
+        //! \param[in] SkinRadius      The extra radius of the Verlet lists, or 0
+        //!                            to rebuild the lists on every call.
+        void BuildNeighborLists(double MaxSearchRadius, double SkinRadius = 0.0);
+
+        //! Forces the next BuildNeighborLists call to rebuild the lists.
+        void InvalidateNeighborLists();
+
+        //! Returns the number of times the neighbor lists have been built.
+        size_t NumberOfNeighborListBuilds() const;
+
+        //! Returns the number of BuildNeighborLists calls which reused the lists.
+        size_t NumberOfNeighborListReuses() const;
 
         //! Serializes the particle system data to the buffer.
         void Serialize(std::vector<uint8_t>* buffer) const override;
@@ -206,7 +323,21 @@ namespace jet
         std::vector<VectorData> _VectorDataList;
 
         PointNeighborSearch3Ptr _NeighborSearch;
-        std::vector<std::vector<size_t>> _NeighborLists;
+        ParticleNeighborLists _NeighborLists;
+        ParticleNeighborLists _HalfNeighborLists;
+
+        // Verlet list state: the positions and radii of the last build.
+        Array1<Vector3D> _NeighborListsPositions;
+        double _NeighborListsSearchRadius = 0.0;
+        double _NeighborListsSkinRadius = 0.0;
+        size_t _NumberOfNeighborListBuilds = 0;
+        size_t _NumberOfNeighborListReuses = 0;
+
+        ReorderCallback _ReorderCallback;
+
+        bool IsNeighborListsRebuildNeeded(double MaxSearchRadius, double SkinRadius) const;
+
+        void Grow(size_t NewNumberOfParticles);
     };
 
     typedef std::shared_ptr<ParticleSystemData3> ParticleSystemData3Ptr;
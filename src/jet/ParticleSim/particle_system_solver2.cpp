@@ -4,6 +4,7 @@
 #include <Field/VectorField/constant_vector_field2.h>
 #include <parallel.h>
 #include "particle_system_solver2.h"
+#include <task_graph.h>
 #include <timer.h>
 
 #include <algorithm>
@@ -109,24 +110,58 @@ namespace jet
 
     void ParticleSystemSolver2::OnAdvanceSubTimeStep(double timeStepInSeconds)
     {
-        BeginAdvanceTimeStep(timeStepInSeconds);
-
-        Timer timer;
-        AccumulateForces(timeStepInSeconds);
-        JET_INFO << "Accumulating Forces took "
-                << timer.DurationInSeconds() << " seconds";
-        
-        timer.Reset();
-        TimeIntegration(timeStepInSeconds);
-        JET_INFO << "Time Integration took "
-                <<timer.DurationInSeconds() << " seconds";
+        // The stages of a sub time-step run as a task graph so that the
+        // independent ones overlap. The collider is updated first, as its
+        // callback may share state with the emitter. The emitter changes the
+        // number of particles and the reordering moves them, so both have to
+        // finish before the per-particle buffers are touched. The forces are
+        // cleared before OnBeginAdvanceTimeStep, which subclasses may use to
+        // write forces; allocating the back buffers overlaps with both.
+        TaskGraph graph;
+
+        auto updateCollider = graph.AddNode("Update Collider",
+                                [&](){ UpdateCollider(timeStepInSeconds); });
+        auto updateEmitter = graph.AddNode("Update Emitter",
+                                [&](){ UpdateEmitter(timeStepInSeconds); });
+        auto reorderParticles = graph.AddNode("Reorder Particles",
+                                [&](){ ReorderParticles(); });
+        auto clearForces = graph.AddNode("Clear Forces",
+                                [&](){ ClearForces(); });
+        auto allocateBuffers = graph.AddNode("Allocate Buffers",
+                                [&](){ AllocateBuffers(); });
+        auto beginAdvance = graph.AddNode("Begin Advance Time Step",
+                                [&](){ OnBeginAdvanceTimeStep(timeStepInSeconds); });
+        auto accumulateForces = graph.AddNode("Accumulate Forces",
+                                [&](){ AccumulateForces(timeStepInSeconds); });
+        auto timeIntegration = graph.AddNode("Time Integration",
+                                [&](){ TimeIntegration(timeStepInSeconds); });
+        auto resolveCollision = graph.AddNode("Resolve Collision",
+                                [&](){ ResolveCollision(); });
+        auto endAdvance = graph.AddNode("End Advance Time Step",
+                                [&](){ EndAdvanceTimeStep(timeStepInSeconds); });
+
+        graph.AddDependency(updateCollider, updateEmitter);
+        graph.AddDependency(updateEmitter, reorderParticles);
+        graph.AddDependency(reorderParticles, clearForces);
+        graph.AddDependency(reorderParticles, allocateBuffers);
+        graph.AddDependency(clearForces, beginAdvance);
+        graph.AddDependency(beginAdvance, accumulateForces);
+        graph.AddDependency(accumulateForces, timeIntegration);
+        graph.AddDependency(allocateBuffers, timeIntegration);
+        graph.AddDependency(timeIntegration, resolveCollision);
+        graph.AddDependency(resolveCollision, endAdvance);
+
+        graph.Run(_ExecutionPolicy, _ParticleSystemData->NumberOfParticles());
+
+        for (TaskGraph::NodeId node = 0; node < graph.NumberOfNodes(); ++node)
+        {
+            JET_INFO << graph.NodeName(node) << " took "
+                    << graph.NodeDurationInSeconds(node) << " seconds";
+        }
 
-        timer.Reset();
-        ResolveCollision();
-        JET_INFO << "Resolving Collision took "
-                << timer.DurationInSeconds() << " seconds";
-        
-        EndAdvanceTimeStep(timeStepInSeconds);
+        JET_INFO << "Sub time-step took " << graph.LastRunTimeInSeconds()
+                << " seconds (critical path: " << graph.CriticalPathTimeInSeconds()
+                << " seconds)";
     }
 
     void ParticleSystemSolver2::AccumulateForces(double timeStepInSeconds)
@@ -137,42 +172,23 @@ namespace jet
         AccumulateExternalForces();
     }
 
-    void ParticleSystemSolver2::BeginAdvanceTimeStep(double timeStepInSeconds)
+    void ParticleSystemSolver2::ClearForces()
     {
-        // Clear Forces
         auto forces = _ParticleSystemData->Forces();
-        SetRange1(forces.Size(), Vector2D(), &forces);
-
-        // Update Collider and Emitter
-        Timer timer;
-        UpdateCollider(timeStepInSeconds);
-        JET_INFO << "Update Collider took "
-                << timer.DurationInSeconds() << " seconds";
-        
-        timer.Reset();
-        UpdateEmitter(timeStepInSeconds);
-        JET_INFO << "Update Emitter took "
-                << timer.DurationInSeconds() << " seconds";
-        
-        // Allocate Buffers
-        size_t n = _ParticleSystemData->NumberOfParticles();
-        _NewPositions.Resize(n);
-        _NewVelocities.Resize(n);
+        SetRange1(forces.Size(), Vector2D(), &forces, _ExecutionPolicy);
+    }
 
-        OnBeginAdvanceTimeStep(timeStepInSeconds);
+    void ParticleSystemSolver2::AllocateBuffers()
+    {
+        _NewPositions = _ParticleSystemData->NewPositions();
+        _NewVelocities = _ParticleSystemData->NewVelocities();
     }
 
     void ParticleSystemSolver2::EndAdvanceTimeStep(double timeStepInSeconds)
     {
-        // Update Data
-        size_t n = _ParticleSystemData->NumberOfParticles();
-        auto positions = _ParticleSystemData->Positions();
-        auto velocities = _ParticleSystemData->Velocities();
-        ParallelFor(kZeroSize, n, [&](size_t i)
-                    {
-                        positions[i] = _NewPositions[i];
-                        velocities[i] = _NewVelocities[i];
-        });
+        // The new state becomes current by swapping the buffers, instead of
+        // copying it back into the particle arrays.
+        _ParticleSystemData->SwapNewPositionsAndVelocities();
 
         OnEndAdvanceTimeStep(timeStepInSeconds);
     }
@@ -189,7 +205,7 @@ namespace jet
 
     void ParticleSystemSolver2::ResolveCollision()
     {
-        ResolveCollision(_NewPositions.Accessor(), _NewVelocities.Accessor());
+        ResolveCollision(_NewPositions, _NewVelocities);
     }
 
     void ParticleSystemSolver2::ResolveCollision(ArrayAccessor1<Vector2D> newPositions,
@@ -205,10 +221,31 @@ namespace jet
                         {
                             _Collider->ResolveCollision(radius, _RestitutionCoefficient,
                                                 &newPositions[i], &newVelocities[i]);
-            });
+            }, _ExecutionPolicy);
         }
     }
 
+    ExecutionPolicy ParticleSystemSolver2::GetExecutionPolicy() const
+    {
+        return _ExecutionPolicy;
+    }
+
+    void ParticleSystemSolver2::SetExecutionPolicy(ExecutionPolicy policy)
+    {
+        _ExecutionPolicy = policy;
+    }
+
+    unsigned int ParticleSystemSolver2::SpatialReorderingInterval() const
+    {
+        return _SpatialReorderingInterval;
+    }
+
+    void ParticleSystemSolver2::SetSpatialReorderingInterval(unsigned int interval)
+    {
+        _SpatialReorderingInterval = interval;
+        _NumberOfSubTimeStepsSinceReordering = 0;
+    }
+
     void ParticleSystemSolver2::SetParticleSystemData(const ParticleSystemData2Ptr& newParticleData)
     {
         _ParticleSystemData = newParticleData;
@@ -232,7 +269,7 @@ namespace jet
                 force += - _DragCoefficient * relVel;
 
                 forces[i] += force;
-        });
+        }, _ExecutionPolicy);
     }
 
     void ParticleSystemSolver2::TimeIntegration(double timeStepInSeconds)
@@ -243,16 +280,24 @@ namespace jet
         auto positions = _ParticleSystemData->Positions();
         const double mass = _ParticleSystemData->Mass();
 
-        ParallelFor(kZeroSize, n, [&](size_t i)
+        const Vector2D* const f = forces.Data();
+        const Vector2D* const v = velocities.Data();
+        const Vector2D* const x = positions.Data();
+        Vector2D* const newVelocities = _NewVelocities.Data();
+        Vector2D* const newPositions = _NewPositions.Data();
+        const double timeStepOverMass = timeStepInSeconds / mass;
+
+        ParallelRangeFor(kZeroSize, n, [&](size_t begin, size_t end)
                 {
-                    // Integrate velocity first
-                    Vector2D& newVelocity = _NewVelocities[i];
-                    newVelocity = velocities[i] + timeStepInSeconds * forces[i] / mass;
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        // Integrate velocity first
+                        newVelocities[i] = v[i] + timeStepOverMass * f[i];
 
-                    // Integrate position
-                    Vector2D& newPosition = _NewPositions[i];
-                    newPosition = positions[i] + timeStepInSeconds * newVelocity;
-        });
+                        // Integrate position
+                        newPositions[i] = x[i] + timeStepInSeconds * newVelocities[i];
+                    }
+        }, _ExecutionPolicy);
     }
 
     void ParticleSystemSolver2::UpdateCollider(double timeStepInSeconds)
@@ -271,6 +316,18 @@ namespace jet
         }
     }
 
+    void ParticleSystemSolver2::ReorderParticles()
+    {
+        if (_SpatialReorderingInterval == 0)
+            return;
+
+        if (++_NumberOfSubTimeStepsSinceReordering >= _SpatialReorderingInterval)
+        {
+            _ParticleSystemData->ReorderBySpatialKey();
+            _NumberOfSubTimeStepsSinceReordering = 0;
+        }
+    }
+
     ParticleSystemSolver2::Builder ParticleSystemSolver2::builder()
     {
         return Builder();
@@ -6,6 +6,7 @@
 #include <ParticleSim/ParticleEmitter/particle_emitter2.h>
 #include <ParticleSim/particle_system_data2.h>
 #include <Animation/physics_animation.h>
+#include <parallel.h>
 
 namespace jet
 {
@@ -84,6 +85,28 @@ namespace jet
         //! \param[in] NewWind The Wind Vector
         void SetWind(const VectorField2Ptr& NewWind);
 
+        //! Returns the execution policy of the per-particle loops.
+        jet::ExecutionPolicy GetExecutionPolicy() const;
+
+        //! \brief Sets the execution policy of the per-particle loops.
+        //!
+        //! The default policy is ExecutionPolicy::kAuto, which runs small
+        //! particle systems on the calling thread. ExecutionPolicy::kSerial can
+        //! be used to get rid of the threading overhead entirely, for example
+        //! when many small simulations run side by side.
+        void SetExecutionPolicy(jet::ExecutionPolicy policy);
+
+        //! Returns the number of sub time-steps between two spatial reorderings.
+        unsigned int SpatialReorderingInterval() const;
+
+        //! \brief Sets the number of sub time-steps between two spatial reorderings.
+        //!
+        //! Every \p interval sub time-steps, the particles are reordered with
+        //! ParticleSystemData2::ReorderBySpatialKey before the neighbor search
+        //! is built, which keeps the neighbor loops cache friendly as the
+        //! particles mix. The default is 0, which disables the reordering.
+        void SetSpatialReorderingInterval(unsigned int interval);
+
         //! Returns builder for ParticleSystemSolver2
         static Builder builder();
     
@@ -91,13 +114,19 @@ namespace jet
         //! Initializes the Simulator.
         void OnInitialize() override;
 
-        //! Called to advance a single time-step.
+        //! \brief Called to advance a single time-step.
+        //!
+        //! The stages of the time-step run as a TaskGraph, so the independent
+        //! ones (e.g. the collider update and the neighbor search) overlap.
         void OnAdvanceSubTimeStep(double TimeStepInSeconds) override;
 
         //! Accumulates forces applied to the particles.
         virtual void AccumulateForces(double TimeStepInSeconds);
 
-        //! Called when a time-step is about to begin.
+        //! \brief Called when a time-step is about to begin.
+        //!
+        //! It is called after the collider and emitter updates and after the
+        //! forces are cleared, possibly on a thread of the pool.
         virtual void OnBeginAdvanceTimeStep(double TimeStepInSeconds);
 
         //! Called after a time-step is completed.
@@ -119,13 +148,20 @@ namespace jet
         Vector2D _Gravity = Vector2D(0.0, kGravity);
 
         ParticleSystemData2Ptr _ParticleSystemData;
-        ParticleSystemData2::VectorData _NewPositions;
-        ParticleSystemData2::VectorData _NewVelocities;
+        // Back buffers of the particle system data for the current sub
+        // time-step, set by AllocateBuffers.
+        ArrayAccessor1<Vector2D> _NewPositions;
+        ArrayAccessor1<Vector2D> _NewVelocities;
         Collider2Ptr _Collider;
         ParticleEmitter2Ptr _Emitter;
         VectorField2Ptr _Wind;
+        jet::ExecutionPolicy _ExecutionPolicy = jet::ExecutionPolicy::kAuto;
+        unsigned int _SpatialReorderingInterval = 0;
+        unsigned int _NumberOfSubTimeStepsSinceReordering = 0;
+
+        void ClearForces();
 
-        void BeginAdvanceTimeStep(double TimeStepInSeconds);
+        void AllocateBuffers();
 
         void EndAdvanceTimeStep(double TimeStepInSeconds);
 
@@ -134,6 +170,7 @@ namespace jet
         void TimeIntegration(double TimeStepInSeconds);
         void UpdateCollider(double TimeStepInSeconds);
         void UpdateEmitter(double TimeStepInSeconds);
+        void ReorderParticles();
     };
 
     typedef std::shared_ptr<ParticleSystemSolver2> ParticleSystemSolver2Ptr;
@@ -23,4 +23,17 @@
 #ifdef JET_WINDOWS
     #include <BaseTsd.h>
     typedef SSIZE_T ssize_t;
-#endif
\ No newline at end of file
+#endif
+
+
+// The widest SIMD instruction set enabled by the compiler is used, unless
+// JET_NO_SIMD is defined to select the scalar code.
+#if !defined(JET_NO_SIMD)
+#   if defined(__AVX512F__)
+#       define JET_USE_AVX512
+#   elif defined(__AVX__)
+#       define JET_USE_AVX
+#   elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#       define JET_USE_SSE2
+#   endif
+#endif
@@ -0,0 +1,25 @@
+#include <jet.h>
+#include "parallel.h"
+
+namespace jet
+{
+    void SetMaxNumberOfThreads(unsigned int numThreads)
+    {
+        ThreadPool::GetInstance().Resize(numThreads);
+    }
+
+    unsigned int GetMaxNumberOfThreads()
+    {
+        return ThreadPool::GetInstance().NumberOfThreads();
+    }
+
+    void SetIsPinningThreadsToCores(bool isPinning)
+    {
+        ThreadPool::GetInstance().SetIsPinningWorkers(isPinning);
+    }
+
+    bool IsPinningThreadsToCores()
+    {
+        return ThreadPool::GetInstance().IsPinningWorkers();
+    }
+}
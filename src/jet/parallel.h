@@ -2,14 +2,67 @@
 
 #include <constants.h>
 #include <macros.h>
+#include <thread_pool.h>
 
 #include<algorithm>
+#include<cstdint>
 #include<functional>
+#include<iterator>
+#include<limits>
 #include<thread>
+#include<type_traits>
 #include<vector>
 
 namespace jet
 {
+    //! \brief Execution policy of the parallel functions.
+    //!
+    //! The parallel functions take the policy as their last argument, which
+    //! defaults to kParallel. Callers such as the solvers can then switch a
+    //! whole code path between serial and parallel execution at run time.
+    enum class ExecutionPolicy
+    {
+        //! Runs on the calling thread only, without touching the thread pool.
+        kSerial,
+
+        //! Runs on the thread pool.
+        kParallel,
+
+        //! Runs serially for ranges smaller than kAutoParallelThreshold and on
+        //! the thread pool otherwise.
+        kAuto
+    };
+
+    //! Minimum number of elements for which ExecutionPolicy::kAuto runs in parallel.
+    constexpr size_t kAutoParallelThreshold = 1024;
+
+    //! \brief Sets the maximum number of threads used by the parallel functions.
+    //!
+    //! The thread pool behind the parallel functions is restarted with
+    //! \p numThreads threads, including the calling thread. Passing 0 restores
+    //! the default, which is the JET_NUM_THREADS environment variable if set,
+    //! the hardware concurrency otherwise. This function must not be called
+    //! while parallel work is running, and throws std::invalid_argument if
+    //! tasks of the pool are queued or running.
+    //!
+    //! \param[in] numThreads The maximum number of threads, or 0 for the default.
+    void SetMaxNumberOfThreads(unsigned int numThreads);
+
+    //! Returns the maximum number of threads used by the parallel functions.
+    unsigned int GetMaxNumberOfThreads();
+
+    //! \brief Enables or disables pinning the worker threads to CPU cores.
+    //!
+    //! Pinning keeps each worker on its own core, which avoids migrations
+    //! when several simulations share a machine. It is only supported on
+    //! Linux and is ignored on other platforms.
+    //!
+    //! \param[in] isPinning True to pin the workers to cores.
+    void SetIsPinningThreadsToCores(bool isPinning);
+
+    //! Returns true if the worker threads are pinned to CPU cores.
+    bool IsPinningThreadsToCores();
+
     //!
     //! \brief Fills from \p begin to \p end with \p value in parallel.
     //!
@@ -20,6 +73,7 @@ namespace jet
     //! \param[in] begin The begin iterator of a container.
     //! \param[in] end The end iterator of a container.
     //! \param[in] value The value to fill a container with
+    //! \param[in] policy The execution policy.
     //!
     //! \tparam RandomIterator RandomIteratorType
     //! \tparam T Value type of the container
@@ -27,7 +81,8 @@ namespace jet
     void ParallelFill(
         const RandomIterator& begin,
         const RandomIterator& end,
-        const T& value);
+        const T& value,
+        ExecutionPolicy policy = ExecutionPolicy::kParallel);
     
 
     //! \brief Makes a for-loop from \p beginIndex to \p endIndex in parallel.
@@ -39,11 +94,206 @@ namespace jet
     //! \param[in] beginIndex The begin index.
     //! \param[in] endIndex The end index.
     //! \param[in] function The function to call for each index.
+    //! \param[in] policy The execution policy.
     //!
     //! \tparam IndexType Index Type
     //! \tparam Function function type
     template<typename IndexType, typename Function>
-    void ParallelFor(IndexType beginIndex, IndexType endIndex, const Function& function);
+    void ParallelFor(IndexType beginIndex, IndexType endIndex, const Function& function,
+                        ExecutionPolicy policy = ExecutionPolicy::kParallel);
+
+    //! \brief Makes a range-loop from \p beginIndex to \p endIndex in parallel.
+    //!
+    //! This function splits the range specified by begin and end indices into
+    //! one chunk per thread and calls \p function once for each chunk with the
+    //! chunk's begin and end index. The callback can then run a tight for-loop
+    //! over the chunk which the compiler can vectorize. The order of the visit is
+    //! not guaranteed due to the nature of parallel execution.
+    //!
+    //! \code{.cpp}
+    //! ParallelRangeFor(kZeroSize, n, [&](size_t begin, size_t end) {
+    //!     for (size_t i = begin; i < end; ++i)
+    //!         c[i] = a[i] + b[i];
+    //! });
+    //! \endcode
+    //!
+    //! \param[in] beginIndex The begin index.
+    //! \param[in] endIndex The end index.
+    //! \param[in] function The function to call for each chunk [begin, end).
+    //! \param[in] policy The execution policy. The serial policy calls
+    //!     \p function once with the whole range.
+    //!
+    //! \tparam IndexType Index Type
+    //! \tparam Function function type
+    template<typename IndexType, typename Function>
+    void ParallelRangeFor(IndexType beginIndex, IndexType endIndex, const Function& function,
+                        ExecutionPolicy policy = ExecutionPolicy::kParallel);
+
+    //! \brief Makes a range-loop from \p beginIndex to \p endIndex in parallel
+    //!     with a given grain size.
+    //!
+    //! This function splits the range specified by begin and end indices into
+    //! chunks of \p grainSize indices (the last one may be smaller) and calls
+    //! \p function once for each chunk with the chunk's begin and end index.
+    //! Smaller grains balance irregular work better while larger grains reduce
+    //! the scheduling overhead.
+    //!
+    //! \param[in] beginIndex The begin index.
+    //! \param[in] endIndex The end index.
+    //! \param[in] grainSize The number of indices per chunk.
+    //! \param[in] function The function to call for each chunk [begin, end).
+    //! \param[in] policy The execution policy. The serial policy calls
+    //!     \p function once with the whole range.
+    //!
+    //! \tparam IndexType Index Type
+    //! \tparam Function function type
+    template<typename IndexType, typename Function>
+    void ParallelRangeFor(IndexType beginIndex, IndexType endIndex, IndexType grainSize,
+                            const Function& function,
+                            ExecutionPolicy policy = ExecutionPolicy::kParallel);
+
+    //! \brief Reduces the values mapped from \p beginIndex to \p endIndex in parallel.
+    //!
+    //! This function maps each index in the range with \p map and combines the
+    //! mapped values with \p reduce. Each chunk of the range is reduced into its
+    //! own partial value on the thread processing it, and the partial values are
+    //! combined on the calling thread afterwards, so no atomics are involved.
+    //! The \p reduce function must be associative, and \p identity must be its
+    //! identity element since the chunking is not deterministic.
+    //!
+    //! \code{.cpp}
+    //! double sumSq = ParallelReduce(kZeroSize, n, 0.0,
+    //!     [&](size_t i) { return a[i] * a[i]; },
+    //!     [](double x, double y) { return x + y; });
+    //! \endcode
+    //!
+    //! \param[in] beginIndex The begin index.
+    //! \param[in] endIndex The end index.
+    //! \param[in] identity The identity value of the reduction.
+    //! \param[in] map The function which maps an index to a value.
+    //! \param[in] reduce The function which combines two values.
+    //! \param[in] policy The execution policy.
+    //!
+    //! \return The reduced value, or \p identity for an empty range.
+    //!
+    //! \tparam IndexType Index Type
+    //! \tparam Value Value type of the reduction.
+    //! \tparam MapFunction Map function type.
+    //! \tparam ReduceFunction Reduce function type.
+    template<typename IndexType, typename Value, typename MapFunction, typename ReduceFunction>
+    Value ParallelReduce(IndexType beginIndex, IndexType endIndex, const Value& identity,
+                            const MapFunction& map, const ReduceFunction& reduce,
+                            ExecutionPolicy policy = ExecutionPolicy::kParallel);
+
+    //! \brief Returns the minimum of the values mapped from \p beginIndex to \p endIndex.
+    //!
+    //! Returns std::numeric_limits<Value>::max() for an empty range.
+    //!
+    //! \param[in] beginIndex The begin index.
+    //! \param[in] endIndex The end index.
+    //! \param[in] map The function which maps an index to a value.
+    //! \param[in] policy The execution policy.
+    template<typename IndexType, typename MapFunction>
+    auto ParallelMin(IndexType beginIndex, IndexType endIndex, const MapFunction& map,
+                        ExecutionPolicy policy = ExecutionPolicy::kParallel)
+        -> typename std::decay<decltype(map(beginIndex))>::type;
+
+    //! \brief Returns the maximum of the values mapped from \p beginIndex to \p endIndex.
+    //!
+    //! Returns std::numeric_limits<Value>::lowest() for an empty range.
+    //!
+    //! \param[in] beginIndex The begin index.
+    //! \param[in] endIndex The end index.
+    //! \param[in] map The function which maps an index to a value.
+    //! \param[in] policy The execution policy.
+    template<typename IndexType, typename MapFunction>
+    auto ParallelMax(IndexType beginIndex, IndexType endIndex, const MapFunction& map,
+                        ExecutionPolicy policy = ExecutionPolicy::kParallel)
+        -> typename std::decay<decltype(map(beginIndex))>::type;
+
+    //! \brief Returns the sum of the values mapped from \p beginIndex to \p endIndex.
+    //!
+    //! The value type must be default constructible to zero (e.g. double or Vector2D).
+    //!
+    //! \param[in] beginIndex The begin index.
+    //! \param[in] endIndex The end index.
+    //! \param[in] map The function which maps an index to a value.
+    //! \param[in] policy The execution policy.
+    template<typename IndexType, typename MapFunction>
+    auto ParallelSum(IndexType beginIndex, IndexType endIndex, const MapFunction& map,
+                        ExecutionPolicy policy = ExecutionPolicy::kParallel)
+        -> typename std::decay<decltype(map(beginIndex))>::type;
+
+    //! \brief Computes the exclusive prefix scan of a range in parallel.
+    //!
+    //! This function writes init, init + x0, init + x0 + x1, ... to \p out
+    //! where + is \p op. The range is split into one block per thread. The
+    //! first pass reduces each block, the block sums are scanned on the
+    //! calling thread, and the second pass scans each block from its offset.
+    //! \p out may be the same as \p begin. \p op must be associative.
+    //!
+    //! \param[in]  begin The begin random access iterator of the input.
+    //! \param[in]  end   The end random access iterator of the input.
+    //! \param[out] out   The begin random access iterator of the output.
+    //! \param[in]  init  The initial value of the scan.
+    //! \param[in]  op    The binary operation.
+    //!
+    //! \return The reduction of init and all the input values.
+    //!
+    //! \tparam InputIterator  Input iterator type.
+    //! \tparam OutputIterator Output iterator type.
+    //! \tparam T              Value type.
+    //! \tparam BinaryOperation Binary operation type.
+    template<typename InputIterator, typename OutputIterator, typename T, typename BinaryOperation>
+    T ParallelExclusiveScan(InputIterator begin, InputIterator end, OutputIterator out,
+                            const T& init, const BinaryOperation& op);
+
+    //! \brief Computes the exclusive prefix sum of a range in parallel.
+    //!
+    //! \see ParallelExclusiveScan
+    //! \return The sum of init and all the input values.
+    template<typename InputIterator, typename OutputIterator, typename T>
+    T ParallelExclusiveScan(InputIterator begin, InputIterator end, OutputIterator out,
+                            const T& init);
+
+    //! \brief Computes the inclusive prefix scan of a range in parallel.
+    //!
+    //! This function writes x0, x0 + x1, x0 + x1 + x2, ... to \p out where +
+    //! is \p op, using the same blocked two-pass scheme as
+    //! ParallelExclusiveScan. \p out may be the same as \p begin.
+    //!
+    //! \param[in]  begin The begin random access iterator of the input.
+    //! \param[in]  end   The end random access iterator of the input.
+    //! \param[out] out   The begin random access iterator of the output.
+    //! \param[in]  op    The binary operation.
+    template<typename InputIterator, typename OutputIterator, typename BinaryOperation>
+    void ParallelInclusiveScan(InputIterator begin, InputIterator end, OutputIterator out,
+                            const BinaryOperation& op);
+
+    //! \brief Computes the inclusive prefix sum of a range in parallel.
+    //!
+    //! \see ParallelInclusiveScan
+    template<typename InputIterator, typename OutputIterator>
+    void ParallelInclusiveScan(InputIterator begin, InputIterator end, OutputIterator out);
+
+    //! \brief Copies the elements satisfying \p predicate to \p out in parallel.
+    //!
+    //! This function is the parallel counterpart of std::copy_if. The predicate
+    //! is evaluated once per element in parallel, the number of survivors of
+    //! each block is scanned, and each block then writes its survivors from its
+    //! own offset. The relative order of the elements is preserved. The output
+    //! must not overlap the input and must be large enough to hold all the
+    //! survivors.
+    //!
+    //! \param[in]  begin     The begin random access iterator of the input.
+    //! \param[in]  end       The end random access iterator of the input.
+    //! \param[in]  predicate Returns true for the elements to keep.
+    //! \param[out] out       The begin random access iterator of the output.
+    //!
+    //! \return The number of elements written to \p out.
+    template<typename InputIterator, typename OutputIterator, typename Predicate>
+    size_t ParallelCompact(InputIterator begin, InputIterator end, const Predicate& predicate,
+                            OutputIterator out);
 
     //! \brief      Makes a 2D nested for-loop in parallel.
     //!
@@ -57,6 +307,7 @@ namespace jet
     //! \param[in]  beginIndexY The begin index in Y dimension.
     //! \param[in]  endIndexY   The end index in Y dimension.
     //! \param[in]  function    The function to call for each index (i, j).
+    //! \param[in]  policy      The execution policy.
     //!
     //! \tparam     IndexType  Index type.
     //! \tparam     Function   Function type.
@@ -67,7 +318,8 @@ namespace jet
         IndexType endIndexX,
         IndexType beginIndexY,
         IndexType endIndexY,
-        const Function& function);
+        const Function& function,
+        ExecutionPolicy policy = ExecutionPolicy::kParallel);
 
     //!
     //! \brief      Makes a 3D nested for-loop in parallel.
@@ -84,12 +336,124 @@ namespace jet
     //! \param[in]  beginIndexZ The begin index in Z dimension.
     //! \param[in]  endIndexZ   The end index in Z dimension.
     //! \param[in]  function    The function to call for each index (i, j, k).
+    //! \param[in]  policy      The execution policy.
     //!
     //! \tparam     IndexType   Index type.
     //! \tparam     Function    Function type.
     //!
     template <typename IndexType, typename Function>
     void ParallelFor(
+        IndexType beginIndexX,
+        IndexType endIndexX,
+        IndexType beginIndexY,
+        IndexType endIndexY,
+        IndexType beginIndexZ,
+        IndexType endIndexZ,
+        const Function& function,
+        ExecutionPolicy policy = ExecutionPolicy::kParallel);
+
+    //! Order in which the tiles of ParallelTiledFor are handed to the threads.
+    enum class TileOrder
+    {
+        //! Tiles are ordered along X first, then Y (then Z).
+        kRowMajor,
+
+        //! Tiles are ordered along a Z-order (Morton) curve, so each thread
+        //! receives a spatially compact group of neighboring tiles.
+        kMorton
+    };
+
+    //! \brief      Makes a 2D nested for-loop in parallel over cache-sized tiles.
+    //!
+    //! This function splits the 2D iteration space into tiles of
+    //! \p tileSizeX by \p tileSizeY indices and schedules the tiles on the
+    //! thread pool. Unlike the 2D ParallelFor, which hands whole rows to the
+    //! threads, the working set of a tile fits in the cache, which helps
+    //! stencils over wide grids. X is the inner-most loop within a tile.
+    //!
+    //! \param[in]  beginIndexX The begin index in X dimension.
+    //! \param[in]  endIndexX   The end index in X dimension.
+    //! \param[in]  beginIndexY The begin index in Y dimension.
+    //! \param[in]  endIndexY   The end index in Y dimension.
+    //! \param[in]  tileSizeX   The tile size in X dimension.
+    //! \param[in]  tileSizeY   The tile size in Y dimension.
+    //! \param[in]  order       The order in which the tiles are scheduled.
+    //! \param[in]  function    The function to call for each index (i, j).
+    //!
+    //! \tparam     IndexType  Index type.
+    //! \tparam     Function   Function type.
+    //!
+    template <typename IndexType, typename Function>
+    void ParallelTiledFor(
+        IndexType beginIndexX,
+        IndexType endIndexX,
+        IndexType beginIndexY,
+        IndexType endIndexY,
+        IndexType tileSizeX,
+        IndexType tileSizeY,
+        TileOrder order,
+        const Function& function);
+
+    //! \brief      Makes a 2D nested for-loop in parallel over cache-sized tiles.
+    //!
+    //! This function uses a default tile size of 64 x 32 indices, which is
+    //! shrunk along Y for small ranges so that every thread receives a tile.
+    //!
+    //! \see ParallelTiledFor
+    template <typename IndexType, typename Function>
+    void ParallelTiledFor(
+        IndexType beginIndexX,
+        IndexType endIndexX,
+        IndexType beginIndexY,
+        IndexType endIndexY,
+        const Function& function);
+
+    //! \brief      Makes a 3D nested for-loop in parallel over cache-sized tiles.
+    //!
+    //! This function splits the 3D iteration space into tiles of
+    //! \p tileSizeX by \p tileSizeY by \p tileSizeZ indices and schedules the
+    //! tiles on the thread pool. Unlike the 3D ParallelFor, which hands whole
+    //! slabs to the threads, this also parallelizes grids with a small Z
+    //! extent. X is the inner-most loop within a tile.
+    //!
+    //! \param[in]  beginIndexX The begin index in X dimension.
+    //! \param[in]  endIndexX   The end index in X dimension.
+    //! \param[in]  beginIndexY The begin index in Y dimension.
+    //! \param[in]  endIndexY   The end index in Y dimension.
+    //! \param[in]  beginIndexZ The begin index in Z dimension.
+    //! \param[in]  endIndexZ   The end index in Z dimension.
+    //! \param[in]  tileSizeX   The tile size in X dimension.
+    //! \param[in]  tileSizeY   The tile size in Y dimension.
+    //! \param[in]  tileSizeZ   The tile size in Z dimension.
+    //! \param[in]  order       The order in which the tiles are scheduled.
+    //! \param[in]  function    The function to call for each index (i, j, k).
+    //!
+    //! \tparam     IndexType   Index type.
+    //! \tparam     Function    Function type.
+    //!
+    template <typename IndexType, typename Function>
+    void ParallelTiledFor(
+        IndexType beginIndexX,
+        IndexType endIndexX,
+        IndexType beginIndexY,
+        IndexType endIndexY,
+        IndexType beginIndexZ,
+        IndexType endIndexZ,
+        IndexType tileSizeX,
+        IndexType tileSizeY,
+        IndexType tileSizeZ,
+        TileOrder order,
+        const Function& function);
+
+    //! \brief      Makes a 3D nested for-loop in parallel over cache-sized tiles.
+    //!
+    //! This function uses a default tile size of 32 x 8 x 8 indices, which is
+    //! shrunk along Z and then Y for small ranges so that every thread
+    //! receives a tile.
+    //!
+    //! \see ParallelTiledFor
+    template <typename IndexType, typename Function>
+    void ParallelTiledFor(
         IndexType beginIndexX,
         IndexType endIndexX,
         IndexType beginIndexY,
@@ -104,11 +468,13 @@ namespace jet
     //!
     //! \param[in]  begin          The begin random access iterator.
     //! \param[in]  end            The end random access iterator.
+    //! \param[in]  policy         The execution policy.
     //!
     //! \tparam     RandomIterator Iterator type.
     //!
     template<typename RandomIterator>
-    void ParallelSort(RandomIterator begin, RandomIterator end);
+    void ParallelSort(RandomIterator begin, RandomIterator end,
+                        ExecutionPolicy policy = ExecutionPolicy::kParallel);
 
     //! \brief      Sorts a container in parallel.
     //!
@@ -132,6 +498,7 @@ namespace jet
     //! \param[in]  begin           The begin random access iterator.
     //! \param[in]  end             The end random access iterator.
     //! \param[in]  compare         The compare function.
+    //! \param[in]  policy          The execution policy.
     //!
     //! \tparam     RandomIterator  Iterator type.
     //! \tparam     CompareFunction Compare function type.
@@ -140,16 +507,173 @@ namespace jet
     void ParallelSort(
         RandomIterator begin,
         RandomIterator end,
-        CompareFunction compare);
+        CompareFunction compare,
+        ExecutionPolicy policy = ExecutionPolicy::kParallel);
+
+    //! \brief Merges two sorted ranges in parallel.
+    //!
+    //! This function merges the sorted ranges [begin1, end1) and [begin2, end2)
+    //! into \p out, which must not overlap the inputs. The output is split into
+    //! one segment per thread at the merge path of each segment boundary, so
+    //! the work is balanced whatever the sizes of the ranges. The merge is
+    //! stable, i.e. equivalent elements of the first range come first.
+    //!
+    //! \param[in]  begin1   The begin random access iterator of the first range.
+    //! \param[in]  end1     The end random access iterator of the first range.
+    //! \param[in]  begin2   The begin random access iterator of the second range.
+    //! \param[in]  end2     The end random access iterator of the second range.
+    //! \param[out] out      The begin random access iterator of the output.
+    //! \param[in]  compare  The compare function.
+    //! \param[in]  policy   The execution policy.
+    //!
+    //! \tparam RandomIterator  Iterator type of the inputs.
+    //! \tparam OutputIterator  Iterator type of the output.
+    //! \tparam CompareFunction Compare function type.
+    //!
+    template<typename RandomIterator, typename OutputIterator, typename CompareFunction>
+    void ParallelMerge(
+        RandomIterator begin1,
+        RandomIterator end1,
+        RandomIterator begin2,
+        RandomIterator end2,
+        OutputIterator out,
+        CompareFunction compare,
+        ExecutionPolicy policy = ExecutionPolicy::kParallel);
+
+    //! \brief Sorts (key, value) pairs by unsigned integer keys in parallel.
+    //!
+    //! This function sorts the keys specified by begin and end iterators with a
+    //! parallel LSD radix sort and applies the same permutation to the values
+    //! starting at \p valuesBegin. The sort is stable, i.e. values of equal keys
+    //! keep their relative order. The run time is linear in the number of keys
+    //! and the number of passes depends on the bit width of \p maxKey, so it is
+    //! well suited for bounded integer keys such as hash grid bucket indices.
+    //!
+    //! \param[in] keysBegin   The begin random access iterator of the keys.
+    //! \param[in] keysEnd     The end random access iterator of the keys.
+    //! \param[in] valuesBegin The begin random access iterator of the values.
+    //! \param[in] maxKey      The upper bound (inclusive) of the keys.
+    //!
+    //! \tparam KeyIterator   Iterator type of the keys.
+    //! \tparam ValueIterator Iterator type of the values.
+    //!
+    template<typename KeyIterator, typename ValueIterator>
+    void ParallelRadixSortByKey(
+        KeyIterator keysBegin,
+        KeyIterator keysEnd,
+        ValueIterator valuesBegin,
+        typename std::iterator_traits<KeyIterator>::value_type maxKey);
 
     namespace internal {
 
+        // Returns true if a range of \p size elements should run on the
+        // calling thread under the given \p policy.
+        inline bool IsSerial(ExecutionPolicy policy, size_t size) {
+            return policy == ExecutionPolicy::kSerial
+                || (policy == ExecutionPolicy::kAuto && size < kAutoParallelThreshold);
+        }
+
+        // Largest scratch buffer of ParallelSort kept by a thread between two
+        // sorts.
+        constexpr size_t kMaxRetainedSortScratchBytes = size_t(1) << 24;
+
+        // Lends the scratch buffer of ParallelSort for the lifetime of the
+        // object. The buffer is kept per thread and value type, so repeated
+        // sorts (e.g. of the entries moved by a hash grid update) do not
+        // allocate. A re-entrant sort on the same thread, which can happen
+        // when this thread helps the pool while waiting, gets a local buffer.
+        // Buffers larger than kMaxRetainedSortScratchBytes are released
+        // afterwards, so that one large sort does not pin memory on every
+        // thread which ever sorted.
+        template <typename T>
+        class ScopedSortScratch final {
+        public:
+            explicit ScopedSortScratch(size_t size) {
+                // The buffer is only marked as used once resized, so that a
+                // failed allocation does not leave it unavailable.
+                if (!IsCachedInUse()) {
+                    if (Cached().size() < size) {
+                        Cached().resize(size);
+                    }
+                    IsCachedInUse() = true;
+                    _Buffer = &Cached();
+                } else {
+                    _Local.resize(size);
+                    _Buffer = &_Local;
+                }
+            }
+
+            ~ScopedSortScratch() {
+                if (_Buffer != &Cached()) {
+                    return;
+                }
+
+                if (_Buffer->capacity() * sizeof(T) > kMaxRetainedSortScratchBytes) {
+                    std::vector<T>().swap(*_Buffer);
+                }
+                IsCachedInUse() = false;
+            }
+
+            ScopedSortScratch(const ScopedSortScratch&) = delete;
+            ScopedSortScratch& operator=(const ScopedSortScratch&) = delete;
+
+            typename std::vector<T>::iterator begin() {
+                return _Buffer->begin();
+            }
+
+        private:
+            std::vector<T> _Local;
+            std::vector<T>* _Buffer = nullptr;
+
+            static std::vector<T>& Cached() {
+                static thread_local std::vector<T> buffer;
+                return buffer;
+            }
+
+            static bool& IsCachedInUse() {
+                static thread_local bool isInUse = false;
+                return isInUse;
+            }
+        };
+
+        // Returns the number of elements taken from the first sorted run \p a
+        // (of size \p sizeA) among the first \p diagonal elements of the merged
+        // output of \p a and \p b. Ties are resolved in favor of \p a.
+        //
         // Adopted from:
-        // Radenski, A.
-        // Shared Memory, Message Passing, and Hybrid Merge Sorts for Standalone and
-        // Clustered SMPs. Proc PDPTA'11, the  2011 International Conference on Parallel
-        // and Distributed Processing Techniques and Applications, CSREA Press
-        // (H. Arabnia, Ed.), 2011, pp. 367 - 373.
+        // Siebert, C., Traff, J. L.
+        // Perfectly Load-Balanced, Optimal, Stable, Parallel Merge.
+        // arXiv:1303.4312, 2013.
+        template <typename RandomIterator, typename CompareFunction>
+        size_t MergeCoRank(
+            size_t diagonal,
+            RandomIterator a,
+            size_t sizeA,
+            RandomIterator b,
+            size_t sizeB,
+            CompareFunction compareFunction) {
+            size_t lo = (diagonal > sizeB) ? diagonal - sizeB : 0;
+            size_t hi = std::min(diagonal, sizeA);
+
+            while (lo < hi) {
+                size_t i = lo + (hi - lo) / 2;
+                size_t j = diagonal - i;
+
+                // a[i] precedes b[j - 1] in the output, so more elements of a
+                // belong to the first diagonal elements.
+                if (!compareFunction(b[j - 1], a[i])) {
+                    lo = i + 1;
+                } else {
+                    hi = i;
+                }
+            }
+
+            return lo;
+        }
+
+        // Merges the two sorted halves of \p a through \p temp. The output is
+        // split into equally sized segments with the merge path (co-rank) of
+        // each segment boundary, so all threads take part in every merge.
         template <
             typename RandomIterator,
             typename RandomIterator2,
@@ -159,32 +683,46 @@ namespace jet
             size_t size,
             RandomIterator2 temp,
             CompareFunction compareFunction) {
-            size_t i1 = 0;
-            size_t i2 = size / 2;
-            size_t tempi = 0;
+            const size_t sizeA = size / 2;
+            const size_t sizeB = size - sizeA;
+            RandomIterator b = a + sizeA;
+
+            const size_t numSegments = std::min(
+                static_cast<size_t>(ThreadPool::GetInstance().NumberOfThreads()), size);
+
+            ParallelFor(kZeroSize, numSegments, [&](size_t s) {
+                const size_t d1 = s * size / numSegments;
+                const size_t d2 = (s + 1) * size / numSegments;
+
+                size_t i1 = MergeCoRank(d1, a, sizeA, b, sizeB, compareFunction);
+                size_t i2 = MergeCoRank(d2, a, sizeA, b, sizeB, compareFunction);
+                size_t j1 = d1 - i1;
+                size_t j2 = d2 - i2;
+
+                size_t tempi = d1;
+                while (i1 < i2 && j1 < j2) {
+                    if (compareFunction(b[j1], a[i1])) {
+                        temp[tempi] = b[j1];
+                        j1++;
+                    } else {
+                        temp[tempi] = a[i1];
+                        i1++;
+                    }
+                    tempi++;
+                }
 
-            while (i1 < size / 2 && i2 < size) {
-                if (compareFunction(a[i1], a[i2])) {
+                while (i1 < i2) {
                     temp[tempi] = a[i1];
                     i1++;
-                } else {
-                    temp[tempi] = a[i2];
-                    i2++;
+                    tempi++;
                 }
-                tempi++;
-            }
 
-            while (i1 < size / 2) {
-                temp[tempi] = a[i1];
-                i1++;
-                tempi++;
-            }
-
-            while (i2 < size) {
-                temp[tempi] = a[i2];
-                i2++;
-                tempi++;
-            }
+                while (j1 < j2) {
+                    temp[tempi] = b[j1];
+                    j1++;
+                    tempi++;
+                }
+            });
 
             // Copy sorted temp array into main array, a
             ParallelFor(kZeroSize, size, [&](size_t i) {
@@ -192,6 +730,12 @@ namespace jet
             });
         }
 
+        // Adopted from:
+        // Radenski, A.
+        // Shared Memory, Message Passing, and Hybrid Merge Sorts for Standalone and
+        // Clustered SMPs. Proc PDPTA'11, the  2011 International Conference on Parallel
+        // and Distributed Processing Techniques and Applications, CSREA Press
+        // (H. Arabnia, Ed.), 2011, pp. 367 - 373.
         template <
             typename RandomIterator,
             typename RandomIterator2,
@@ -205,41 +749,90 @@ namespace jet
             if (numThreads == 1) {
                 std::sort(a, a + size, compareFunction);
             } else if (numThreads > 1) {
-                std::vector<std::thread> pool;
-                pool.reserve(2);
-
-                auto launchRange = [compareFunction] (
-                    RandomIterator begin,
-                    size_t k2,
-                    RandomIterator2 temp,
-                    unsigned int numThreads) {
-                    ParallelMergeSort(begin, k2, temp, numThreads, compareFunction);
-                };
-
-                pool.emplace_back(launchRange, a, size / 2, temp, numThreads / 2);
-                pool.emplace_back(
-                    launchRange,
+                // Sort the first half on the pool while this thread sorts the
+                // second half.
+                TaskGroup group;
+                group.Run([=]() {
+                    ParallelMergeSort(a, size / 2, temp, numThreads / 2, compareFunction);
+                });
+
+                ParallelMergeSort(
                     a + size / 2,
                     size - size / 2,
                     temp + size / 2,
-                    numThreads - numThreads / 2);
+                    numThreads - numThreads / 2,
+                    compareFunction);
 
                 // Wait for jobs to finish
-                for (std::thread &t : pool) {
-                    if (t.joinable()) {
-                        t.join();
-                    }
-                }
+                group.Wait();
 
                 Merge(a, size, temp, compareFunction);
             }
         }
 
+
+        // Interleaves the bits of the 2D tile coordinate (x, y).
+        inline uint64_t MortonCode2(uint64_t x, uint64_t y) {
+            uint64_t code = 0;
+            for (unsigned int b = 0; b < 32; ++b) {
+                code |= ((x >> b) & 1ull) << (2 * b);
+                code |= ((y >> b) & 1ull) << (2 * b + 1);
+            }
+            return code;
+        }
+
+        // Interleaves the bits of the 3D tile coordinate (x, y, z).
+        inline uint64_t MortonCode3(uint64_t x, uint64_t y, uint64_t z) {
+            uint64_t code = 0;
+            for (unsigned int b = 0; b < 21; ++b) {
+                code |= ((x >> b) & 1ull) << (3 * b);
+                code |= ((y >> b) & 1ull) << (3 * b + 1);
+                code |= ((z >> b) & 1ull) << (3 * b + 2);
+            }
+            return code;
+        }
+
+        // Calls \p function with the linear row-major index of each of the
+        // \p numTiles tiles in parallel, scheduled in the given \p order.
+        // \p mortonCode maps a linear tile index to its Morton code.
+        template <typename MortonFunction, typename Function>
+        void ForEachTile(
+            size_t numTiles,
+            TileOrder order,
+            const MortonFunction& mortonCode,
+            const Function& function) {
+            // A few tiles per thread balance uneven tiles while consecutive
+            // tiles of a chunk stay close to each other.
+            const size_t NumThreads = ThreadPool::GetInstance().NumberOfThreads();
+            const size_t grainSize = std::max(kOneSize, numTiles / (4 * NumThreads));
+
+            if (order == TileOrder::kRowMajor) {
+                ParallelRangeFor(kZeroSize, numTiles, grainSize, [&](size_t t1, size_t t2) {
+                    for (size_t t = t1; t < t2; ++t)
+                        function(t);
+                });
+                return;
+            }
+
+            std::vector<size_t> tiles(numTiles);
+            for (size_t t = 0; t < numTiles; ++t)
+                tiles[t] = t;
+            std::sort(tiles.begin(), tiles.end(), [&](size_t a, size_t b) {
+                return mortonCode(a) < mortonCode(b);
+            });
+
+            ParallelRangeFor(kZeroSize, numTiles, grainSize, [&](size_t t1, size_t t2) {
+                for (size_t t = t1; t < t2; ++t)
+                    function(tiles[t]);
+            });
+        }
+
     }  // namespace internal
     
 
     template<typename RandomIterator, typename T>
-    void ParallelFill(const RandomIterator& begin, const RandomIterator& end, const T& value)
+    void ParallelFill(const RandomIterator& begin, const RandomIterator& end, const T& value,
+                        ExecutionPolicy policy)
     {
         auto diff = end-begin;
         if (diff <= 0)
@@ -248,67 +841,317 @@ namespace jet
         size_t size = static_cast<size_t>(diff);
         ParallelFor(kZeroSize, size, [begin, value](size_t i){
             begin[i] = value;
-        });
+        }, policy);
     }
 
     template<typename IndexType, typename Function>
-    void ParallelFor
-        (IndexType start, IndexType end,
-            const Function& func)
+    void ParallelFor(IndexType start, IndexType end, const Function& func,
+                        ExecutionPolicy policy)
+    {
+        ParallelRangeFor(start, end, [&func](IndexType k1, IndexType k2){
+            for (IndexType k = k1; k < k2; ++k)
+                func(k);
+        }, policy);
+    }
+
+    template<typename IndexType, typename Function>
+    void ParallelRangeFor(IndexType start, IndexType end, const Function& func,
+                        ExecutionPolicy policy)
+    {
+        if (start > end)
+            return;
+
+        if (internal::IsSerial(policy, static_cast<size_t>(end - start)))
         {
-            if (start > end)
-                return;
-            
-            //Estimate the number of threads in the pool
-            static const unsigned int NumThreadsHint = std::thread::hardware_concurrency();
-            static const unsigned int NumThreads = (NumThreadsHint == 0u ? 8u : NumThreadsHint);
-
-            //Size of a slice for the range functions
-            IndexType n = end - start + 1;
-            IndexType slice = (IndexType) std::round(n / static_cast<double>(NumThreads));
-            slice = std::max(slice, IndexType(1));
-
-            //Inner Loop
-            auto launchRange = [&func] (IndexType k1, IndexType k2){
-                for (IndexType k = k1; k< k2; k++)
-                    func(k);
-            };
-
-            //Create pool and launch jobs
-            std::vector<std::thread> pool;
-            pool.reserve(NumThreads);
-            IndexType i1 = start;
-            IndexType i2 = std::min(start+slice, end);
-            for (unsigned int i = 0; i < NumThreads - 1 && i1 < end; ++i)
+            func(start, end);
+            return;
+        }
+
+        //Number of threads executing the tasks of the pool
+        const unsigned int NumThreads = ThreadPool::GetInstance().NumberOfThreads();
+
+        //One slice per thread
+        IndexType n = end - start;
+        IndexType slice = (n + NumThreads - 1) / NumThreads;
+
+        ParallelRangeFor(start, end, slice, func);
+    }
+
+    template<typename IndexType, typename Function>
+    void ParallelRangeFor(IndexType start, IndexType end, IndexType grainSize,
+                            const Function& func, ExecutionPolicy policy)
+    {
+        if (start > end)
+            return;
+
+        if (internal::IsSerial(policy, static_cast<size_t>(end - start)))
+        {
+            func(start, end);
+            return;
+        }
+
+        grainSize = std::max(grainSize, IndexType(1));
+
+        //Submit all slices but the last one to the pool
+        TaskGroup group;
+        IndexType i1 = start;
+        while (end - i1 > grainSize)
+        {
+            IndexType i2 = i1 + grainSize;
+            group.Run([&func, i1, i2](){ func(i1, i2); });
+            i1 = i2;
+        }
+
+        //The calling thread processes the last slice
+        if (i1 < end)
+            func(i1, end);
+
+        //Wait for jobs to finish
+        group.Wait();
+    }
+
+    template<typename IndexType, typename Value, typename MapFunction, typename ReduceFunction>
+    Value ParallelReduce(IndexType start, IndexType end, const Value& identity,
+                            const MapFunction& map, const ReduceFunction& reduce,
+                            ExecutionPolicy policy)
+    {
+        if (start >= end)
+            return identity;
+
+        if (internal::IsSerial(policy, static_cast<size_t>(end - start)))
+        {
+            Value result = identity;
+            for (IndexType k = start; k < end; ++k)
+                result = reduce(result, map(k));
+            return result;
+        }
+
+        //One partial value per slice
+        const unsigned int NumThreads = ThreadPool::GetInstance().NumberOfThreads();
+        IndexType n = end - start;
+        IndexType slice = (n + NumThreads - 1) / NumThreads;
+        size_t NumSlices = static_cast<size_t>((n + slice - 1) / slice);
+
+        std::vector<Value> partials(NumSlices, identity);
+
+        ParallelRangeFor(start, end, slice, [&](IndexType k1, IndexType k2){
+            Value partial = identity;
+            for (IndexType k = k1; k < k2; ++k)
+                partial = reduce(partial, map(k));
+
+            partials[static_cast<size_t>((k1 - start) / slice)] = partial;
+        });
+
+        Value result = identity;
+        for (const Value& partial : partials)
+            result = reduce(result, partial);
+
+        return result;
+    }
+
+    template<typename IndexType, typename MapFunction>
+    auto ParallelMin(IndexType start, IndexType end, const MapFunction& map,
+                        ExecutionPolicy policy)
+        -> typename std::decay<decltype(map(start))>::type
+    {
+        typedef typename std::decay<decltype(map(start))>::type Value;
+        return ParallelReduce(start, end, std::numeric_limits<Value>::max(), map,
+                        [](const Value& a, const Value& b){
+                            return std::min(a, b);
+                        }, policy);
+    }
+
+    template<typename IndexType, typename MapFunction>
+    auto ParallelMax(IndexType start, IndexType end, const MapFunction& map,
+                        ExecutionPolicy policy)
+        -> typename std::decay<decltype(map(start))>::type
+    {
+        typedef typename std::decay<decltype(map(start))>::type Value;
+        return ParallelReduce(start, end, std::numeric_limits<Value>::lowest(), map,
+                        [](const Value& a, const Value& b){
+                            return std::max(a, b);
+                        }, policy);
+    }
+
+    template<typename IndexType, typename MapFunction>
+    auto ParallelSum(IndexType start, IndexType end, const MapFunction& map,
+                        ExecutionPolicy policy)
+        -> typename std::decay<decltype(map(start))>::type
+    {
+        typedef typename std::decay<decltype(map(start))>::type Value;
+        return ParallelReduce(start, end, Value(), map,
+                        [](const Value& a, const Value& b){
+                            return a + b;
+                        }, policy);
+    }
+
+    template<typename InputIterator, typename OutputIterator, typename T, typename BinaryOperation>
+    T ParallelExclusiveScan(InputIterator begin, InputIterator end, OutputIterator out,
+                            const T& init, const BinaryOperation& op)
+    {
+        if (end - begin <= 0)
+            return init;
+
+        const size_t size = static_cast<size_t>(end - begin);
+        const unsigned int NumThreads = ThreadPool::GetInstance().NumberOfThreads();
+        const size_t blockSize = (size - 1) / NumThreads + 1;
+        const size_t NumBlocks = (size - 1) / blockSize + 1;
+
+        //First pass: reduce each block
+        std::vector<T> offsets(NumBlocks + 1, init);
+        ParallelFor(kZeroSize, NumBlocks, [&](size_t b){
+            const size_t blockEnd = std::min(size, (b + 1) * blockSize);
+            T sum = begin[b * blockSize];
+            for (size_t i = b * blockSize + 1; i < blockEnd; ++i)
+                sum = op(sum, begin[i]);
+            offsets[b + 1] = sum;
+        });
+
+        //Scan the block sums. offsets[b] becomes the offset of block b.
+        for (size_t b = 0; b < NumBlocks; ++b)
+            offsets[b + 1] = op(offsets[b], offsets[b + 1]);
+
+        //Second pass: scan each block from its offset
+        ParallelFor(kZeroSize, NumBlocks, [&](size_t b){
+            const size_t blockEnd = std::min(size, (b + 1) * blockSize);
+            T running = offsets[b];
+            for (size_t i = b * blockSize; i < blockEnd; ++i)
             {
-                pool.emplace_back(launchRange, i1, i2);
-                i1 = i2;
-                i2 = std::min(i2 + slice, end);
+                T value = begin[i];
+                out[i] = running;
+                running = op(running, value);
             }
+        });
+
+        return offsets[NumBlocks];
+    }
+
+    template<typename InputIterator, typename OutputIterator, typename T>
+    T ParallelExclusiveScan(InputIterator begin, InputIterator end, OutputIterator out,
+                            const T& init)
+    {
+        return ParallelExclusiveScan(begin, end, out, init, std::plus<T>());
+    }
+
+    template<typename InputIterator, typename OutputIterator, typename BinaryOperation>
+    void ParallelInclusiveScan(InputIterator begin, InputIterator end, OutputIterator out,
+                            const BinaryOperation& op)
+    {
+        typedef typename std::iterator_traits<InputIterator>::value_type T;
+
+        if (end - begin <= 0)
+            return;
 
-            if(i1<end)
-                pool.emplace_back(launchRange, i1, end);
-            
-            //Wait for jobs to finish
-            for (std::thread &t : pool)
+        const size_t size = static_cast<size_t>(end - begin);
+        const unsigned int NumThreads = ThreadPool::GetInstance().NumberOfThreads();
+        const size_t blockSize = (size - 1) / NumThreads + 1;
+        const size_t NumBlocks = (size - 1) / blockSize + 1;
+
+        //First pass: reduce each block
+        std::vector<T> offsets(NumBlocks);
+        ParallelFor(kZeroSize, NumBlocks, [&](size_t b){
+            const size_t blockEnd = std::min(size, (b + 1) * blockSize);
+            T sum = begin[b * blockSize];
+            for (size_t i = b * blockSize + 1; i < blockEnd; ++i)
+                sum = op(sum, begin[i]);
+            offsets[b] = sum;
+        });
+
+        //Scan the block sums. offsets[b] becomes the sum of the blocks up to b.
+        for (size_t b = 1; b < NumBlocks; ++b)
+            offsets[b] = op(offsets[b - 1], offsets[b]);
+
+        //Second pass: scan each block continuing from the previous blocks
+        ParallelFor(kZeroSize, NumBlocks, [&](size_t b){
+            const size_t blockBegin = b * blockSize;
+            const size_t blockEnd = std::min(size, (b + 1) * blockSize);
+
+            T running = (b == 0) ? begin[0] : op(offsets[b - 1], begin[blockBegin]);
+            out[blockBegin] = running;
+            for (size_t i = blockBegin + 1; i < blockEnd; ++i)
             {
-                if (t.joinable())
-                    t.join();
+                running = op(running, begin[i]);
+                out[i] = running;
             }
-        }
-    
+        });
+    }
+
+    template<typename InputIterator, typename OutputIterator>
+    void ParallelInclusiveScan(InputIterator begin, InputIterator end, OutputIterator out)
+    {
+        typedef typename std::iterator_traits<InputIterator>::value_type T;
+        ParallelInclusiveScan(begin, end, out, std::plus<T>());
+    }
+
+    template<typename InputIterator, typename OutputIterator, typename Predicate>
+    size_t ParallelCompact(InputIterator begin, InputIterator end, const Predicate& predicate,
+                            OutputIterator out)
+    {
+        if (end - begin <= 0)
+            return 0;
+
+        const size_t size = static_cast<size_t>(end - begin);
+        const unsigned int NumThreads = ThreadPool::GetInstance().NumberOfThreads();
+        const size_t blockSize = (size - 1) / NumThreads + 1;
+        const size_t NumBlocks = (size - 1) / blockSize + 1;
+
+        //First pass: evaluate the predicate once per element and count the
+        //survivors of each block
+        std::vector<char> keep(size);
+        std::vector<size_t> offsets(NumBlocks + 1, 0);
+        ParallelFor(kZeroSize, NumBlocks, [&](size_t b){
+            const size_t blockEnd = std::min(size, (b + 1) * blockSize);
+            size_t count = 0;
+            for (size_t i = b * blockSize; i < blockEnd; ++i)
+            {
+                keep[i] = predicate(begin[i]) ? 1 : 0;
+                count += keep[i];
+            }
+            offsets[b + 1] = count;
+        });
+
+        //Scan the counts
+        for (size_t b = 0; b < NumBlocks; ++b)
+            offsets[b + 1] += offsets[b];
+
+        //Second pass: write the survivors of each block from its offset
+        ParallelFor(kZeroSize, NumBlocks, [&](size_t b){
+            const size_t blockEnd = std::min(size, (b + 1) * blockSize);
+            size_t dst = offsets[b];
+            for (size_t i = b * blockSize; i < blockEnd; ++i)
+            {
+                if (keep[i])
+                    out[dst++] = begin[i];
+            }
+        });
+
+        return offsets[NumBlocks];
+    }
+
     template <typename IndexType, typename Function>
     void ParallelFor(
         IndexType beginIndexX,
         IndexType endIndexX,
         IndexType beginIndexY,
         IndexType endIndexY,
-        const Function& function)
+        const Function& function,
+        ExecutionPolicy policy)
     {
+        if (beginIndexX >= endIndexX || beginIndexY >= endIndexY)
+            return;
+
+        if (policy == ExecutionPolicy::kAuto)
+        {
+            const size_t size = static_cast<size_t>(endIndexX - beginIndexX)
+                            * static_cast<size_t>(endIndexY - beginIndexY);
+            policy = internal::IsSerial(policy, size) ? ExecutionPolicy::kSerial
+                                                      : ExecutionPolicy::kParallel;
+        }
+
         ParallelFor( beginIndexY, endIndexY, [&](size_t j){
             for (IndexType i = beginIndexX; i<endIndexX; ++i)
                 function(i,j);
-        });
+        }, policy);
     }
 
 
@@ -320,49 +1163,343 @@ namespace jet
         IndexType endIndexY,
         IndexType beginIndexZ,
         IndexType endIndexZ,
-        const Function& function)
+        const Function& function,
+        ExecutionPolicy policy)
     {
+        if (beginIndexX >= endIndexX || beginIndexY >= endIndexY || beginIndexZ >= endIndexZ)
+            return;
+
+        if (policy == ExecutionPolicy::kAuto)
+        {
+            const size_t size = static_cast<size_t>(endIndexX - beginIndexX)
+                            * static_cast<size_t>(endIndexY - beginIndexY)
+                            * static_cast<size_t>(endIndexZ - beginIndexZ);
+            policy = internal::IsSerial(policy, size) ? ExecutionPolicy::kSerial
+                                                      : ExecutionPolicy::kParallel;
+        }
+
         ParallelFor( beginIndexZ, endIndexZ, [&](size_t k){
             for (IndexType j = beginIndexY; j < endIndexY; ++j){
                 for (IndexType i = beginIndexX; i < endIndexX; ++i){
                     function(i,j,k);
                 }
             }
-        });
+        }, policy);
     }
 
 
+    template <typename IndexType, typename Function>
+    void ParallelTiledFor(
+        IndexType beginIndexX,
+        IndexType endIndexX,
+        IndexType beginIndexY,
+        IndexType endIndexY,
+        IndexType tileSizeX,
+        IndexType tileSizeY,
+        TileOrder order,
+        const Function& function)
+    {
+        if (beginIndexX >= endIndexX || beginIndexY >= endIndexY)
+            return;
+
+        tileSizeX = std::max(tileSizeX, IndexType(1));
+        tileSizeY = std::max(tileSizeY, IndexType(1));
+
+        const size_t NumTilesX = (endIndexX - beginIndexX + tileSizeX - 1) / tileSizeX;
+        const size_t NumTilesY = (endIndexY - beginIndexY + tileSizeY - 1) / tileSizeY;
+
+        internal::ForEachTile(NumTilesX * NumTilesY, order,
+            [&](size_t t) {
+                return internal::MortonCode2(t % NumTilesX, t / NumTilesX);
+            },
+            [&](size_t t) {
+                const IndexType i1 = beginIndexX + static_cast<IndexType>(t % NumTilesX) * tileSizeX;
+                const IndexType j1 = beginIndexY + static_cast<IndexType>(t / NumTilesX) * tileSizeY;
+                const IndexType i2 = std::min(i1 + tileSizeX, endIndexX);
+                const IndexType j2 = std::min(j1 + tileSizeY, endIndexY);
+
+                for (IndexType j = j1; j < j2; ++j)
+                    for (IndexType i = i1; i < i2; ++i)
+                        function(i, j);
+            });
+    }
+
+    template <typename IndexType, typename Function>
+    void ParallelTiledFor(
+        IndexType beginIndexX,
+        IndexType endIndexX,
+        IndexType beginIndexY,
+        IndexType endIndexY,
+        const Function& function)
+    {
+        if (beginIndexX >= endIndexX || beginIndexY >= endIndexY)
+            return;
+
+        const size_t NumThreads = ThreadPool::GetInstance().NumberOfThreads();
+        const IndexType sizeX = endIndexX - beginIndexX;
+        const IndexType sizeY = endIndexY - beginIndexY;
+
+        IndexType tileSizeX = 64;
+        IndexType tileSizeY = 32;
+
+        auto NumTiles = [&]() -> size_t {
+            return static_cast<size_t>((sizeX + tileSizeX - 1) / tileSizeX)
+                * static_cast<size_t>((sizeY + tileSizeY - 1) / tileSizeY);
+        };
+
+        while (NumTiles() < NumThreads && tileSizeY > 1)
+            tileSizeY /= 2;
+
+        ParallelTiledFor(beginIndexX, endIndexX, beginIndexY, endIndexY,
+                        tileSizeX, tileSizeY, TileOrder::kRowMajor, function);
+    }
+
+    template <typename IndexType, typename Function>
+    void ParallelTiledFor(
+        IndexType beginIndexX,
+        IndexType endIndexX,
+        IndexType beginIndexY,
+        IndexType endIndexY,
+        IndexType beginIndexZ,
+        IndexType endIndexZ,
+        IndexType tileSizeX,
+        IndexType tileSizeY,
+        IndexType tileSizeZ,
+        TileOrder order,
+        const Function& function)
+    {
+        if (beginIndexX >= endIndexX || beginIndexY >= endIndexY || beginIndexZ >= endIndexZ)
+            return;
+
+        tileSizeX = std::max(tileSizeX, IndexType(1));
+        tileSizeY = std::max(tileSizeY, IndexType(1));
+        tileSizeZ = std::max(tileSizeZ, IndexType(1));
+
+        const size_t NumTilesX = (endIndexX - beginIndexX + tileSizeX - 1) / tileSizeX;
+        const size_t NumTilesY = (endIndexY - beginIndexY + tileSizeY - 1) / tileSizeY;
+        const size_t NumTilesZ = (endIndexZ - beginIndexZ + tileSizeZ - 1) / tileSizeZ;
+
+        internal::ForEachTile(NumTilesX * NumTilesY * NumTilesZ, order,
+            [&](size_t t) {
+                return internal::MortonCode3(t % NumTilesX, (t / NumTilesX) % NumTilesY,
+                                            t / (NumTilesX * NumTilesY));
+            },
+            [&](size_t t) {
+                const IndexType i1 = beginIndexX + static_cast<IndexType>(t % NumTilesX) * tileSizeX;
+                const IndexType j1 = beginIndexY + static_cast<IndexType>((t / NumTilesX) % NumTilesY) * tileSizeY;
+                const IndexType k1 = beginIndexZ + static_cast<IndexType>(t / (NumTilesX * NumTilesY)) * tileSizeZ;
+                const IndexType i2 = std::min(i1 + tileSizeX, endIndexX);
+                const IndexType j2 = std::min(j1 + tileSizeY, endIndexY);
+                const IndexType k2 = std::min(k1 + tileSizeZ, endIndexZ);
+
+                for (IndexType k = k1; k < k2; ++k)
+                    for (IndexType j = j1; j < j2; ++j)
+                        for (IndexType i = i1; i < i2; ++i)
+                            function(i, j, k);
+            });
+    }
+
+    template <typename IndexType, typename Function>
+    void ParallelTiledFor(
+        IndexType beginIndexX,
+        IndexType endIndexX,
+        IndexType beginIndexY,
+        IndexType endIndexY,
+        IndexType beginIndexZ,
+        IndexType endIndexZ,
+        const Function& function)
+    {
+        if (beginIndexX >= endIndexX || beginIndexY >= endIndexY || beginIndexZ >= endIndexZ)
+            return;
+
+        const size_t NumThreads = ThreadPool::GetInstance().NumberOfThreads();
+        const IndexType sizeX = endIndexX - beginIndexX;
+        const IndexType sizeY = endIndexY - beginIndexY;
+        const IndexType sizeZ = endIndexZ - beginIndexZ;
+
+        IndexType tileSizeX = 32;
+        IndexType tileSizeY = 8;
+        IndexType tileSizeZ = 8;
+
+        auto NumTiles = [&]() -> size_t {
+            return static_cast<size_t>((sizeX + tileSizeX - 1) / tileSizeX)
+                * static_cast<size_t>((sizeY + tileSizeY - 1) / tileSizeY)
+                * static_cast<size_t>((sizeZ + tileSizeZ - 1) / tileSizeZ);
+        };
+
+        while (NumTiles() < NumThreads && tileSizeZ > 1)
+            tileSizeZ /= 2;
+        while (NumTiles() < NumThreads && tileSizeY > 1)
+            tileSizeY /= 2;
+
+        ParallelTiledFor(beginIndexX, endIndexX, beginIndexY, endIndexY, beginIndexZ, endIndexZ,
+                        tileSizeX, tileSizeY, tileSizeZ, TileOrder::kRowMajor, function);
+    }
+
     template<typename RandomIterator, typename CompareFunction>
     void ParallelSort(
         RandomIterator begin,
         RandomIterator end,
-        CompareFunction compareFunction) {
+        CompareFunction compareFunction,
+        ExecutionPolicy policy) {
         if (end < begin) {
             return;
         }
 
         size_t size = static_cast<size_t>(end - begin);
 
+        if (internal::IsSerial(policy, size)) {
+            std::sort(begin, end, compareFunction);
+            return;
+        }
+
         typedef typename std::iterator_traits<RandomIterator>::value_type
             value_type;
-        std::vector<value_type> temp(size);
 
-        // Estimate number of threads in the pool
-        static const unsigned int numThreadsHint
-            = std::thread::hardware_concurrency();
-        static const unsigned int numThreads
-            = (numThreadsHint == 0u ? 8u : numThreadsHint);
+        // The scratch buffer is returned even if the comparator throws.
+        internal::ScopedSortScratch<value_type> temp(size);
+
+        // Number of threads executing the tasks of the pool
+        const unsigned int numThreads = ThreadPool::GetInstance().NumberOfThreads();
 
         internal::ParallelMergeSort(
             begin, size, temp.begin(), numThreads, compareFunction);
     }
 
+    template<typename RandomIterator, typename OutputIterator, typename CompareFunction>
+    void ParallelMerge(
+        RandomIterator begin1,
+        RandomIterator end1,
+        RandomIterator begin2,
+        RandomIterator end2,
+        OutputIterator out,
+        CompareFunction compareFunction,
+        ExecutionPolicy policy) {
+        const size_t sizeA = static_cast<size_t>(end1 - begin1);
+        const size_t sizeB = static_cast<size_t>(end2 - begin2);
+        const size_t size = sizeA + sizeB;
+
+        if (internal::IsSerial(policy, size)) {
+            std::merge(begin1, end1, begin2, end2, out, compareFunction);
+            return;
+        }
+
+        const size_t numSegments = std::min(
+            static_cast<size_t>(ThreadPool::GetInstance().NumberOfThreads()), size);
+
+        ParallelFor(kZeroSize, numSegments, [&](size_t s) {
+            const size_t d1 = s * size / numSegments;
+            const size_t d2 = (s + 1) * size / numSegments;
+
+            const size_t i1 = internal::MergeCoRank(d1, begin1, sizeA, begin2, sizeB, compareFunction);
+            const size_t i2 = internal::MergeCoRank(d2, begin1, sizeA, begin2, sizeB, compareFunction);
+
+            std::merge(begin1 + i1, begin1 + i2, begin2 + (d1 - i1), begin2 + (d2 - i2),
+                       out + d1, compareFunction);
+        }, ExecutionPolicy::kParallel);
+    }
+
+    template<typename KeyIterator, typename ValueIterator>
+    void ParallelRadixSortByKey(
+        KeyIterator keysBegin,
+        KeyIterator keysEnd,
+        ValueIterator valuesBegin,
+        typename std::iterator_traits<KeyIterator>::value_type maxKey) {
+        typedef typename std::iterator_traits<KeyIterator>::value_type key_type;
+        typedef typename std::iterator_traits<ValueIterator>::value_type value_type;
+
+        static_assert(std::is_integral<key_type>::value && std::is_unsigned<key_type>::value,
+                        "Radix sort requires unsigned integer keys.");
+
+        if (keysEnd - keysBegin < 2) {
+            return;
+        }
+
+        const size_t size = static_cast<size_t>(keysEnd - keysBegin);
+
+        // 8-bit digits. Only the digits covering maxKey are sorted.
+        constexpr unsigned int kRadixBits = 8;
+        constexpr size_t kRadix = size_t(1) << kRadixBits;
+        unsigned int numPasses = 0;
+        for (key_type k = maxKey; k > 0; k >>= kRadixBits) {
+            ++numPasses;
+        }
+
+        if (numPasses == 0) {
+            return;
+        }
+
+        // One chunk of the input per thread. Each chunk gets its own histogram
+        // so no atomics are needed for counting and scattering.
+        const unsigned int numThreads = ThreadPool::GetInstance().NumberOfThreads();
+        const size_t chunkSize = (size - 1) / numThreads + 1;
+        const size_t numChunks = (size - 1) / chunkSize + 1;
+
+        std::vector<key_type> tempKeys(size);
+        std::vector<value_type> tempValues(size);
+        std::vector<size_t> offsets(numChunks * kRadix);
+
+        auto sortPass = [&](auto srcKeys, auto srcValues, auto dstKeys, auto dstValues,
+                            unsigned int shift) {
+            // Histogram of the digits of each chunk.
+            ParallelFor(kZeroSize, numChunks, [&](size_t c) {
+                size_t* histogram = &offsets[c * kRadix];
+                std::fill(histogram, histogram + kRadix, kZeroSize);
+
+                const size_t end = std::min(size, (c + 1) * chunkSize);
+                for (size_t i = c * chunkSize; i < end; ++i) {
+                    ++histogram[(srcKeys[i] >> shift) & (kRadix - 1)];
+                }
+            });
+
+            // Exclusive scan in (digit, chunk) order gives the stable scatter
+            // offset of each digit within each chunk.
+            size_t sum = 0;
+            for (size_t d = 0; d < kRadix; ++d) {
+                for (size_t c = 0; c < numChunks; ++c) {
+                    size_t count = offsets[c * kRadix + d];
+                    offsets[c * kRadix + d] = sum;
+                    sum += count;
+                }
+            }
+
+            ParallelFor(kZeroSize, numChunks, [&](size_t c) {
+                size_t* offset = &offsets[c * kRadix];
+
+                const size_t end = std::min(size, (c + 1) * chunkSize);
+                for (size_t i = c * chunkSize; i < end; ++i) {
+                    size_t dst = offset[(srcKeys[i] >> shift) & (kRadix - 1)]++;
+                    dstKeys[dst] = srcKeys[i];
+                    dstValues[dst] = srcValues[i];
+                }
+            });
+        };
+
+        for (unsigned int pass = 0; pass < numPasses; ++pass) {
+            const unsigned int shift = pass * kRadixBits;
+            if (pass % 2 == 0) {
+                sortPass(keysBegin, valuesBegin, tempKeys.begin(), tempValues.begin(), shift);
+            } else {
+                sortPass(tempKeys.begin(), tempValues.begin(), keysBegin, valuesBegin, shift);
+            }
+        }
+
+        // Odd number of passes leaves the result in the temporary buffers.
+        if (numPasses % 2 == 1) {
+            ParallelFor(kZeroSize, size, [&](size_t i) {
+                keysBegin[i] = tempKeys[i];
+                valuesBegin[i] = tempValues[i];
+            });
+        }
+    }
+
     template<typename RandomIterator>
-    void ParallelSort(RandomIterator begin, RandomIterator end) {
+    void ParallelSort(RandomIterator begin, RandomIterator end, ExecutionPolicy policy) {
         ParallelSort(
             begin,
             end,
-            std::less<typename std::iterator_traits<RandomIterator>::value_type>());
+            std::less<typename std::iterator_traits<RandomIterator>::value_type>(),
+            policy);
     }
 
 }
\ No newline at end of file
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <macros.h>
+
+#include<cstddef>
+
+#if defined(JET_USE_AVX512) || defined(JET_USE_AVX)
+#include<immintrin.h>
+#elif defined(JET_USE_SSE2)
+#include<emmintrin.h>
+#endif
+
+namespace jet
+{
+    //! \brief Invokes the callback for each 2D point within given squared
+    //! radius of the origin.
+    //!
+    //! The points are given as separate coordinate arrays, so that the
+    //! distance tests run on several points per instruction with the widest
+    //! SIMD instruction set enabled, see JET_NO_SIMD in macros.h. The points
+    //! are visited in order.
+    //!
+    //! \param[in] xs The x coordinates of the points.
+    //! \param[in] ys The y coordinates of the points.
+    //! \param[in] begin The index of the first point.
+    //! \param[in] end The index past the last point.
+    //! \param[in] originX The x coordinate of the origin.
+    //! \param[in] originY The y coordinate of the origin.
+    //! \param[in] radiusSq The squared search radius.
+    //! \param[in] callback The callback function, called as callback(index).
+    //!
+    //! \tparam Callback Callback function type.
+    template<typename Callback>
+    void ForEachPointInRadius(const double* xs, const double* ys, size_t begin, size_t end,
+                    double originX, double originY, double radiusSq, const Callback& callback);
+
+    //! \brief Invokes the callback for each 3D point within given squared
+    //! radius of the origin.
+    //!
+    //! Same as the 2D version with the z coordinates added.
+    //!
+    //! \param[in] xs The x coordinates of the points.
+    //! \param[in] ys The y coordinates of the points.
+    //! \param[in] zs The z coordinates of the points.
+    //! \param[in] begin The index of the first point.
+    //! \param[in] end The index past the last point.
+    //! \param[in] originX The x coordinate of the origin.
+    //! \param[in] originY The y coordinate of the origin.
+    //! \param[in] originZ The z coordinate of the origin.
+    //! \param[in] radiusSq The squared search radius.
+    //! \param[in] callback The callback function, called as callback(index).
+    //!
+    //! \tparam Callback Callback function type.
+    template<typename Callback>
+    void ForEachPointInRadius(const double* xs, const double* ys, const double* zs,
+                    size_t begin, size_t end, double originX, double originY, double originZ,
+                    double radiusSq, const Callback& callback);
+
+    namespace internal
+    {
+        // Calls the callback for the points of a SIMD block whose bit is set
+        // in mask.
+        template<typename Callback>
+        inline void ForEachSetBit(unsigned int mask, size_t first, const Callback& callback)
+        {
+            for (size_t k = 0; mask != 0; ++k, mask >>= 1)
+            {
+                if (mask & 1u)
+                    callback(first + k);
+            }
+        }
+    }
+
+    template<typename Callback>
+    void ForEachPointInRadius(const double* xs, const double* ys, size_t begin, size_t end,
+                    double originX, double originY, double radiusSq, const Callback& callback)
+    {
+        size_t j = begin;
+
+#if defined(JET_USE_AVX512)
+        const __m512d ox = _mm512_set1_pd(originX);
+        const __m512d oy = _mm512_set1_pd(originY);
+        const __m512d r = _mm512_set1_pd(radiusSq);
+        for (; j + 8 <= end; j += 8)
+        {
+            const __m512d dx = _mm512_sub_pd(_mm512_loadu_pd(xs + j), ox);
+            const __m512d dy = _mm512_sub_pd(_mm512_loadu_pd(ys + j), oy);
+            const __m512d d = _mm512_add_pd(_mm512_mul_pd(dx, dx), _mm512_mul_pd(dy, dy));
+            internal::ForEachSetBit(_mm512_cmp_pd_mask(d, r, _CMP_LE_OQ), j, callback);
+        }
+#elif defined(JET_USE_AVX)
+        const __m256d ox = _mm256_set1_pd(originX);
+        const __m256d oy = _mm256_set1_pd(originY);
+        const __m256d r = _mm256_set1_pd(radiusSq);
+        for (; j + 4 <= end; j += 4)
+        {
+            const __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(xs + j), ox);
+            const __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(ys + j), oy);
+            const __m256d d = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+            internal::ForEachSetBit(_mm256_movemask_pd(_mm256_cmp_pd(d, r, _CMP_LE_OQ)), j, callback);
+        }
+#elif defined(JET_USE_SSE2)
+        const __m128d ox = _mm_set1_pd(originX);
+        const __m128d oy = _mm_set1_pd(originY);
+        const __m128d r = _mm_set1_pd(radiusSq);
+        for (; j + 2 <= end; j += 2)
+        {
+            const __m128d dx = _mm_sub_pd(_mm_loadu_pd(xs + j), ox);
+            const __m128d dy = _mm_sub_pd(_mm_loadu_pd(ys + j), oy);
+            const __m128d d = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+            internal::ForEachSetBit(_mm_movemask_pd(_mm_cmple_pd(d, r)), j, callback);
+        }
+#endif
+
+        for (; j < end; ++j)
+        {
+            const double dx = xs[j] - originX;
+            const double dy = ys[j] - originY;
+            if (dx * dx + dy * dy <= radiusSq)
+                callback(j);
+        }
+    }
+
+    template<typename Callback>
+    void ForEachPointInRadius(const double* xs, const double* ys, const double* zs,
+                    size_t begin, size_t end, double originX, double originY, double originZ,
+                    double radiusSq, const Callback& callback)
+    {
+        size_t j = begin;
+
+#if defined(JET_USE_AVX512)
+        const __m512d ox = _mm512_set1_pd(originX);
+        const __m512d oy = _mm512_set1_pd(originY);
+        const __m512d oz = _mm512_set1_pd(originZ);
+        const __m512d r = _mm512_set1_pd(radiusSq);
+        for (; j + 8 <= end; j += 8)
+        {
+            const __m512d dx = _mm512_sub_pd(_mm512_loadu_pd(xs + j), ox);
+            const __m512d dy = _mm512_sub_pd(_mm512_loadu_pd(ys + j), oy);
+            const __m512d dz = _mm512_sub_pd(_mm512_loadu_pd(zs + j), oz);
+            const __m512d d = _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(dx, dx),
+                        _mm512_mul_pd(dy, dy)), _mm512_mul_pd(dz, dz));
+            internal::ForEachSetBit(_mm512_cmp_pd_mask(d, r, _CMP_LE_OQ), j, callback);
+        }
+#elif defined(JET_USE_AVX)
+        const __m256d ox = _mm256_set1_pd(originX);
+        const __m256d oy = _mm256_set1_pd(originY);
+        const __m256d oz = _mm256_set1_pd(originZ);
+        const __m256d r = _mm256_set1_pd(radiusSq);
+        for (; j + 4 <= end; j += 4)
+        {
+            const __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(xs + j), ox);
+            const __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(ys + j), oy);
+            const __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(zs + j), oz);
+            const __m256d d = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx),
+                        _mm256_mul_pd(dy, dy)), _mm256_mul_pd(dz, dz));
+            internal::ForEachSetBit(_mm256_movemask_pd(_mm256_cmp_pd(d, r, _CMP_LE_OQ)), j, callback);
+        }
+#elif defined(JET_USE_SSE2)
+        const __m128d ox = _mm_set1_pd(originX);
+        const __m128d oy = _mm_set1_pd(originY);
+        const __m128d oz = _mm_set1_pd(originZ);
+        const __m128d r = _mm_set1_pd(radiusSq);
+        for (; j + 2 <= end; j += 2)
+        {
+            const __m128d dx = _mm_sub_pd(_mm_loadu_pd(xs + j), ox);
+            const __m128d dy = _mm_sub_pd(_mm_loadu_pd(ys + j), oy);
+            const __m128d dz = _mm_sub_pd(_mm_loadu_pd(zs + j), oz);
+            const __m128d d = _mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx),
+                        _mm_mul_pd(dy, dy)), _mm_mul_pd(dz, dz));
+            internal::ForEachSetBit(_mm_movemask_pd(_mm_cmple_pd(d, r)), j, callback);
+        }
+#endif
+
+        for (; j < end; ++j)
+        {
+            const double dx = xs[j] - originX;
+            const double dy = ys[j] - originY;
+            const double dz = zs[j] - originZ;
+            if (dx * dx + dy * dy + dz * dz <= radiusSq)
+                callback(j);
+        }
+    }
+}
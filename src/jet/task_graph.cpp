@@ -0,0 +1,192 @@
+#include <jet.h>
+#include "task_graph.h"
+#include <timer.h>
+
+#include <algorithm>
+
+namespace jet
+{
+    struct TaskGraph::Node
+    {
+        std::string Name;
+        ThreadPool::Task Task;
+        std::vector<NodeId> Successors;
+        size_t NumPredecessors = 0;
+
+        // Number of predecessors which have not finished yet in the current run.
+        std::atomic<size_t> NumPendingPredecessors{0};
+
+        double DurationInSeconds = 0.0;
+    };
+
+    TaskGraph::TaskGraph()
+    {}
+
+    TaskGraph::~TaskGraph()
+    {}
+
+    TaskGraph::NodeId TaskGraph::AddNode(const std::string& name, ThreadPool::Task task)
+    {
+        std::unique_ptr<Node> node(new Node());
+        node->Name = name;
+        node->Task = std::move(task);
+        _Nodes.push_back(std::move(node));
+        return _Nodes.size() - 1;
+    }
+
+    void TaskGraph::AddDependency(NodeId predecessor, NodeId node)
+    {
+        JET_THROW_INVALID_ARG_IF(predecessor >= _Nodes.size() || node >= _Nodes.size());
+        JET_THROW_INVALID_ARG_IF(predecessor == node);
+
+        _Nodes[predecessor]->Successors.push_back(node);
+        ++_Nodes[node]->NumPredecessors;
+    }
+
+    void TaskGraph::Run(ExecutionPolicy policy, size_t workSize)
+    {
+        // Also validates that the graph has no cycle before running anything.
+        const std::vector<NodeId> order = TopologicalOrder();
+
+        Timer timer;
+
+        if (internal::IsSerial(policy, workSize))
+        {
+            for (NodeId node : order)
+            {
+                Timer nodeTimer;
+                _Nodes[node]->Task();
+                _Nodes[node]->DurationInSeconds = nodeTimer.DurationInSeconds();
+            }
+        }
+        else
+        {
+            for (const auto& node : _Nodes)
+                node->NumPendingPredecessors.store(node->NumPredecessors, std::memory_order_relaxed);
+
+            TaskGroup group;
+            for (NodeId node = 0; node < _Nodes.size(); ++node)
+            {
+                if (_Nodes[node]->NumPredecessors == 0)
+                    group.Run([this, node, &group]() { RunNode(node, &group); });
+            }
+            group.Wait();
+        }
+
+        _LastRunTimeInSeconds = timer.DurationInSeconds();
+    }
+
+    void TaskGraph::RunNode(NodeId node, TaskGroup* group)
+    {
+        Node& current = *_Nodes[node];
+
+        Timer timer;
+        current.Task();
+        current.DurationInSeconds = timer.DurationInSeconds();
+
+        // The successors are submitted before this task finishes, so the group
+        // cannot run out of pending tasks in between.
+        for (NodeId successor : current.Successors)
+        {
+            if (_Nodes[successor]->NumPendingPredecessors.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                group->Run([this, successor, group]() { RunNode(successor, group); });
+        }
+    }
+
+    size_t TaskGraph::NumberOfNodes() const
+    {
+        return _Nodes.size();
+    }
+
+    const std::string& TaskGraph::NodeName(NodeId node) const
+    {
+        return _Nodes[node]->Name;
+    }
+
+    double TaskGraph::NodeDurationInSeconds(NodeId node) const
+    {
+        return _Nodes[node]->DurationInSeconds;
+    }
+
+    double TaskGraph::LastRunTimeInSeconds() const
+    {
+        return _LastRunTimeInSeconds;
+    }
+
+    std::vector<TaskGraph::NodeId> TaskGraph::CriticalPath() const
+    {
+        const std::vector<NodeId> order = TopologicalOrder();
+        const size_t NumNodes = _Nodes.size();
+
+        // Longest time of a chain ending with each node and the node before it.
+        std::vector<double> finishTime(NumNodes, 0.0);
+        std::vector<NodeId> previous(NumNodes, kMaxSize);
+        for (NodeId node : order)
+        {
+            finishTime[node] += _Nodes[node]->DurationInSeconds;
+            for (NodeId successor : _Nodes[node]->Successors)
+            {
+                if (previous[successor] == kMaxSize || finishTime[node] > finishTime[successor])
+                {
+                    finishTime[successor] = finishTime[node];
+                    previous[successor] = node;
+                }
+            }
+        }
+
+        std::vector<NodeId> path;
+        if (NumNodes == 0)
+            return path;
+
+        NodeId last = static_cast<NodeId>(
+            std::max_element(finishTime.begin(), finishTime.end()) - finishTime.begin());
+        for (NodeId node = last; node != kMaxSize; node = previous[node])
+            path.push_back(node);
+
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+
+    double TaskGraph::CriticalPathTimeInSeconds() const
+    {
+        double time = 0.0;
+        for (NodeId node : CriticalPath())
+            time += _Nodes[node]->DurationInSeconds;
+        return time;
+    }
+
+    void TaskGraph::Clear()
+    {
+        _Nodes.clear();
+        _LastRunTimeInSeconds = 0.0;
+    }
+
+    std::vector<TaskGraph::NodeId> TaskGraph::TopologicalOrder() const
+    {
+        const size_t NumNodes = _Nodes.size();
+
+        std::vector<size_t> numPredecessors(NumNodes);
+        std::vector<NodeId> order;
+        order.reserve(NumNodes);
+        for (NodeId node = 0; node < NumNodes; ++node)
+        {
+            numPredecessors[node] = _Nodes[node]->NumPredecessors;
+            if (numPredecessors[node] == 0)
+                order.push_back(node);
+        }
+
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            for (NodeId successor : _Nodes[order[i]]->Successors)
+            {
+                if (--numPredecessors[successor] == 0)
+                    order.push_back(successor);
+            }
+        }
+
+        // Nodes on a cycle never reach zero pending predecessors.
+        JET_THROW_INVALID_ARG_IF(order.size() != NumNodes);
+
+        return order;
+    }
+}
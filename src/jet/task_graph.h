@@ -0,0 +1,107 @@
+#pragma once
+
+#include <constants.h>
+#include <parallel.h>
+#include <thread_pool.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace jet
+{
+    //! \brief Graph of tasks with dependencies running on the ThreadPool.
+    //!
+    //! Each node wraps a task. A node starts as soon as all of its
+    //! predecessors have finished, so independent nodes run concurrently. The
+    //! tasks can use the parallel functions themselves. After each run the
+    //! duration of every node is kept, which gives the critical path of the
+    //! graph, i.e. the chain of dependent nodes with the longest total time.
+    //!
+    //! \code{.cpp}
+    //! TaskGraph graph;
+    //! auto a = graph.AddNode("A", [&]() { ... });
+    //! auto b = graph.AddNode("B", [&]() { ... });
+    //! auto c = graph.AddNode("C", [&]() { ... });
+    //! graph.AddDependency(a, c);
+    //! graph.AddDependency(b, c);
+    //! graph.Run();   // A and B run concurrently, then C.
+    //! \endcode
+    class TaskGraph final
+    {
+    public:
+        //! Identifier of a node.
+        typedef size_t NodeId;
+
+        //! Constructs an empty graph.
+        TaskGraph();
+
+        //! Destructor.
+        ~TaskGraph();
+
+        TaskGraph(const TaskGraph&) = delete;
+        TaskGraph& operator=(const TaskGraph&) = delete;
+
+        //! \brief Adds a node to the graph.
+        //!
+        //! \param[in] name The name of the node, used for reporting.
+        //! \param[in] task The task to run.
+        //!
+        //! \return The identifier of the new node.
+        NodeId AddNode(const std::string& name, ThreadPool::Task task);
+
+        //! \brief Makes \p node wait until \p predecessor has finished.
+        //!
+        //! \param[in] predecessor The node which has to run first.
+        //! \param[in] node        The node depending on \p predecessor.
+        void AddDependency(NodeId predecessor, NodeId node);
+
+        //! \brief Runs every node of the graph once and waits for all of them.
+        //!
+        //! With ExecutionPolicy::kSerial the nodes run one after another on
+        //! the calling thread in a topological order, and so does
+        //! ExecutionPolicy::kAuto when \p workSize is below
+        //! kAutoParallelThreshold. Otherwise the nodes run on the thread pool.
+        //! Throws std::invalid_argument if the dependencies contain a cycle.
+        //!
+        //! \param[in] policy   The execution policy.
+        //! \param[in] workSize The number of elements processed by the
+        //!                     nodes, e.g. particles, used to resolve kAuto.
+        void Run(ExecutionPolicy policy = ExecutionPolicy::kParallel, size_t workSize = kMaxSize);
+
+        //! Returns the number of nodes.
+        size_t NumberOfNodes() const;
+
+        //! Returns the name of \p node.
+        const std::string& NodeName(NodeId node) const;
+
+        //! Returns the duration of \p node during the last run in seconds.
+        double NodeDurationInSeconds(NodeId node) const;
+
+        //! Returns the wall time of the last run in seconds.
+        double LastRunTimeInSeconds() const;
+
+        //! \brief Returns the critical path of the last run.
+        //!
+        //! The critical path is the chain of dependent nodes with the longest
+        //! sum of durations. No schedule can run the graph faster than this.
+        std::vector<NodeId> CriticalPath() const;
+
+        //! Returns the sum of the node durations along the critical path.
+        double CriticalPathTimeInSeconds() const;
+
+        //! Removes all the nodes.
+        void Clear();
+
+    private:
+        struct Node;
+
+        std::vector<std::unique_ptr<Node>> _Nodes;
+        double _LastRunTimeInSeconds = 0.0;
+
+        std::vector<NodeId> TopologicalOrder() const;
+
+        void RunNode(NodeId node, TaskGroup* group);
+    };
+}
@@ -0,0 +1,373 @@
+#include <jet.h>
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace jet
+{
+    namespace
+    {
+        // Index of the worker owning the calling thread, or kNotAWorker for
+        // threads which are not owned by the pool.
+        constexpr size_t kNotAWorker = static_cast<size_t>(-1);
+        thread_local size_t tWorkerIndex = kNotAWorker;
+
+        // Number of failed attempts to find a task before a waiting thread
+        // goes to sleep.
+        constexpr unsigned int kWaitSpinCount = 64;
+    }
+
+    ThreadPool& ThreadPool::GetInstance()
+    {
+        static ThreadPool instance;
+        return instance;
+    }
+
+    ThreadPool::ThreadPool()
+    {
+        Start(DefaultNumberOfThreads());
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        Stop();
+    }
+
+    unsigned int ThreadPool::DefaultNumberOfThreads()
+    {
+        const char* NumThreadsEnv = std::getenv("JET_NUM_THREADS");
+        if (NumThreadsEnv != nullptr)
+        {
+            char* end = nullptr;
+            const unsigned long NumThreads = std::strtoul(NumThreadsEnv, &end, 10);
+            if (end != NumThreadsEnv && NumThreads > 0)
+                return static_cast<unsigned int>(NumThreads);
+        }
+
+        const unsigned int NumThreadsHint = std::thread::hardware_concurrency();
+        return (NumThreadsHint == 0u ? 8u : NumThreadsHint);
+    }
+
+    void ThreadPool::Resize(unsigned int numThreads)
+    {
+        JET_THROW_INVALID_ARG_IF(tWorkerIndex != kNotAWorker);
+        JET_THROW_INVALID_ARG_IF(!IsIdle());
+
+        if (numThreads == 0)
+            numThreads = DefaultNumberOfThreads();
+
+        Stop();
+        Start(numThreads);
+    }
+
+    void ThreadPool::SetIsPinningWorkers(bool isPinning)
+    {
+        JET_THROW_INVALID_ARG_IF(tWorkerIndex != kNotAWorker);
+        JET_THROW_INVALID_ARG_IF(!IsIdle());
+
+        if (_IsPinningWorkers == isPinning)
+            return;
+
+        const unsigned int NumThreads = NumberOfThreads();
+        Stop();
+        _IsPinningWorkers = isPinning;
+        Start(NumThreads);
+    }
+
+    bool ThreadPool::IsPinningWorkers() const
+    {
+        return _IsPinningWorkers;
+    }
+
+    void ThreadPool::Start(unsigned int numThreads)
+    {
+        // The thread waiting on a task group executes tasks as well, so one
+        // thread less than the requested number of threads is spawned.
+        const unsigned int NumWorkers = std::max(numThreads, 1u) - 1;
+
+        // At least one queue is needed to receive tasks even if there are no
+        // workers. The waiting thread will then drain it by itself.
+        const size_t NumQueues = std::max(NumWorkers, 1u);
+        JET_ASSERT(IsIdle());
+        _Queues.clear();
+        for (size_t i = 0; i < NumQueues; ++i)
+            _Queues.emplace_back(new WorkQueue());
+
+        _Stop = false;
+        _Workers.reserve(NumWorkers);
+        for (unsigned int i = 0; i < NumWorkers; ++i)
+            _Workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+
+#if defined(__linux__)
+        if (_IsPinningWorkers)
+        {
+            const unsigned int NumCores = std::max(std::thread::hardware_concurrency(), 1u);
+            for (unsigned int i = 0; i < NumWorkers; ++i)
+            {
+                cpu_set_t cpuSet;
+                CPU_ZERO(&cpuSet);
+                CPU_SET((i + 1) % NumCores, &cpuSet);
+                pthread_setaffinity_np(_Workers[i].native_handle(), sizeof(cpu_set_t), &cpuSet);
+            }
+        }
+#endif
+    }
+
+    void ThreadPool::Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_WakeMutex);
+            _Stop = true;
+        }
+        _WakeCondition.notify_all();
+
+        for (std::thread& worker : _Workers)
+        {
+            if (worker.joinable())
+                worker.join();
+        }
+        _Workers.clear();
+    }
+
+    unsigned int ThreadPool::NumberOfThreads() const
+    {
+        return static_cast<unsigned int>(_Workers.size()) + 1u;
+    }
+
+    unsigned int ThreadPool::NumberOfWorkers() const
+    {
+        return static_cast<unsigned int>(_Workers.size());
+    }
+
+    void ThreadPool::Submit(Task task, TaskGroup* group)
+    {
+        size_t queueIndex = tWorkerIndex;
+        if (queueIndex == kNotAWorker)
+            queueIndex = _NextQueue.fetch_add(1, std::memory_order_relaxed) % _Queues.size();
+
+        WorkQueue& queue = *_Queues[queueIndex];
+        {
+            std::lock_guard<std::mutex> lock(queue.Mutex);
+            _NumUnfinishedJobs.fetch_add(1);
+            queue.Jobs.push_back(Job{std::move(task), group});
+        }
+        _NumQueuedJobs.fetch_add(1);
+
+        // Taking the lock makes sure a worker or a waiting thread which is
+        // about to sleep either sees the new job or receives the notification.
+        {
+            std::lock_guard<std::mutex> lock(_WakeMutex);
+        }
+        _WakeCondition.notify_one();
+        if (_NumSleepingWaiters.load() > 0)
+            _WaitCondition.notify_all();
+    }
+
+    bool ThreadPool::TryRunPendingTask()
+    {
+        Job job;
+        const size_t workerIndex = tWorkerIndex;
+
+        if (workerIndex != kNotAWorker && PopJob(workerIndex, &job))
+        {
+            RunJob(job);
+            return true;
+        }
+
+        if (StealJob(workerIndex, &job))
+        {
+            RunJob(job);
+            return true;
+        }
+
+        return false;
+    }
+
+    void ThreadPool::WorkerLoop(size_t workerIndex)
+    {
+        tWorkerIndex = workerIndex;
+
+        while (true)
+        {
+            if (TryRunPendingTask())
+                continue;
+
+            std::unique_lock<std::mutex> lock(_WakeMutex);
+            _WakeCondition.wait(lock, [this] {
+                return _Stop || _NumQueuedJobs.load() > 0;
+            });
+
+            if (_Stop)
+                return;
+        }
+    }
+
+    bool ThreadPool::PopJob(size_t queueIndex, Job* job)
+    {
+        WorkQueue& queue = *_Queues[queueIndex];
+        std::lock_guard<std::mutex> lock(queue.Mutex);
+        if (queue.Jobs.empty())
+            return false;
+
+        *job = std::move(queue.Jobs.back());
+        queue.Jobs.pop_back();
+        _NumQueuedJobs.fetch_sub(1);
+        return true;
+    }
+
+    bool ThreadPool::StealJob(size_t thiefIndex, Job* job)
+    {
+        const size_t NumQueues = _Queues.size();
+        const size_t start = (thiefIndex == kNotAWorker) ? 0 : thiefIndex + 1;
+
+        for (size_t i = 0; i < NumQueues; ++i)
+        {
+            size_t victim = (start + i) % NumQueues;
+            if (victim == thiefIndex)
+                continue;
+
+            WorkQueue& queue = *_Queues[victim];
+            std::lock_guard<std::mutex> lock(queue.Mutex);
+            if (queue.Jobs.empty())
+                continue;
+
+            *job = std::move(queue.Jobs.front());
+            queue.Jobs.pop_front();
+            _NumQueuedJobs.fetch_sub(1);
+            return true;
+        }
+
+        return false;
+    }
+
+    void ThreadPool::RunJob(Job& job)
+    {
+        // A throwing task still has to leave the group, otherwise waiting on
+        // the group would never return.
+        std::exception_ptr exception;
+        try
+        {
+            job.Function();
+        }
+        catch (...)
+        {
+            exception = std::current_exception();
+        }
+
+        // Counted as finished before the group is notified, so that the pool
+        // is idle as soon as the last TaskGroup::Wait returns.
+        _NumUnfinishedJobs.fetch_sub(1);
+
+        if (job.Group == nullptr)
+        {
+            if (exception)
+                std::rethrow_exception(exception);
+            return;
+        }
+
+        job.Group->OnTaskFinished(exception);
+    }
+
+    bool ThreadPool::IsIdle() const
+    {
+        return _NumUnfinishedJobs.load() == 0;
+    }
+
+    void ThreadPool::WaitUntilFinished(const std::atomic<size_t>& pending)
+    {
+        unsigned int NumFailedAttempts = 0;
+        while (pending.load(std::memory_order_acquire) > 0)
+        {
+            if (TryRunPendingTask())
+            {
+                NumFailedAttempts = 0;
+                continue;
+            }
+
+            if (NumFailedAttempts < kWaitSpinCount)
+            {
+                ++NumFailedAttempts;
+                std::this_thread::yield();
+                continue;
+            }
+
+            // The tasks of the group are running on other threads. Sleep
+            // until one of them is the last one, or until there is a task
+            // to help with.
+            std::unique_lock<std::mutex> lock(_WakeMutex);
+            ++_NumSleepingWaiters;
+            _WaitCondition.wait(lock, [this, &pending] {
+                return pending.load(std::memory_order_acquire) == 0 || _NumQueuedJobs.load() > 0;
+            });
+            --_NumSleepingWaiters;
+            NumFailedAttempts = 0;
+        }
+    }
+
+    void ThreadPool::NotifyGroupFinished()
+    {
+        // Same as in Submit, a waiting thread which is about to sleep either
+        // sees the finished group or receives the notification.
+        {
+            std::lock_guard<std::mutex> lock(_WakeMutex);
+        }
+        if (_NumSleepingWaiters.load() > 0)
+            _WaitCondition.notify_all();
+    }
+
+    TaskGroup::TaskGroup()
+        : _Pool(ThreadPool::GetInstance())
+    {}
+
+    TaskGroup::~TaskGroup()
+    {
+        WaitForTasks();
+    }
+
+    void TaskGroup::Run(ThreadPool::Task task)
+    {
+        _Pending.fetch_add(1, std::memory_order_relaxed);
+        _Pool.Submit(std::move(task), this);
+    }
+
+    void TaskGroup::Wait()
+    {
+        WaitForTasks();
+
+        if (_Exception)
+        {
+            std::exception_ptr exception = std::move(_Exception);
+            _Exception = nullptr;
+            std::rethrow_exception(exception);
+        }
+    }
+
+    void TaskGroup::WaitForTasks()
+    {
+        _Pool.WaitUntilFinished(_Pending);
+    }
+
+    void TaskGroup::OnTaskFinished(std::exception_ptr exception)
+    {
+        if (exception)
+        {
+            std::lock_guard<std::mutex> lock(_ExceptionMutex);
+            if (!_Exception)
+                _Exception = exception;
+        }
+
+        // The group may be destroyed by its waiter as soon as the count
+        // reaches zero, so the pool is fetched first.
+        ThreadPool& pool = _Pool;
+
+        // Released after the exception is stored, so that Wait sees it.
+        if (_Pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            pool.NotifyGroupFinished();
+    }
+}
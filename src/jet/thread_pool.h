@@ -0,0 +1,194 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace jet
+{
+    class TaskGroup;
+
+    //! \brief Process-wide work-stealing thread pool.
+    //!
+    //! This class owns the worker threads that execute the tasks submitted by
+    //! the parallel primitives (ParallelFor, ParallelFill, ParallelSort, ...).
+    //! Each worker has its own task deque. A worker pops the most recently pushed
+    //! task from the back of its own deque and, when it runs out of work, steals
+    //! the oldest task from the front of another worker's deque. The workers are
+    //! started lazily on the first call to ThreadPool::GetInstance and joined when
+    //! the process exits.
+    //!
+    //! \see TaskGroup
+    class ThreadPool final
+    {
+    public:
+        //! Task type executed by the pool.
+        typedef std::function<void()> Task;
+
+        //! Returns the process-wide thread pool instance.
+        static ThreadPool& GetInstance();
+
+        //! Stops and joins all the worker threads.
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        //! \brief Returns the number of threads which execute tasks.
+        //!
+        //! This includes the worker threads and the calling thread which helps
+        //! executing the tasks while waiting on a TaskGroup.
+        unsigned int NumberOfThreads() const;
+
+        //! Returns the number of worker threads owned by the pool.
+        unsigned int NumberOfWorkers() const;
+
+        //! \brief Restarts the pool with \p numThreads threads executing tasks.
+        //!
+        //! The pool keeps \p numThreads - 1 workers, the calling thread being
+        //! the last one. Passing 0 restores the default which is read from the
+        //! JET_NUM_THREADS environment variable, or falls back to the hardware
+        //! concurrency. This function joins the current workers, so it must not
+        //! be called while parallel work is running or from a task. Throws
+        //! std::invalid_argument if tasks are queued or running, instead of
+        //! dropping them.
+        //!
+        //! \param[in] numThreads The number of threads, or 0 for the default.
+        void Resize(unsigned int numThreads);
+
+        //! \brief Enables or disables pinning the workers to CPU cores.
+        //!
+        //! When enabled, the i-th worker is bound to core (i + 1) modulo the
+        //! number of cores, leaving core 0 to the main thread. Pinning is only
+        //! supported on Linux and is ignored on other platforms. The workers are
+        //! restarted, so the same restrictions and exceptions as for Resize apply.
+        //!
+        //! \param[in] isPinning True to pin the workers, false to let the OS
+        //!     schedule them freely.
+        void SetIsPinningWorkers(bool isPinning);
+
+        //! Returns true if the workers are pinned to CPU cores.
+        bool IsPinningWorkers() const;
+
+        //! \brief Returns the default number of threads.
+        //!
+        //! This is the value of the JET_NUM_THREADS environment variable if it
+        //! is set to a positive integer, the hardware concurrency otherwise.
+        static unsigned int DefaultNumberOfThreads();
+
+        //! \brief Submits a task to the pool.
+        //!
+        //! When called from a worker thread, the task is pushed to the back of
+        //! the worker's own deque. Otherwise the tasks are distributed over the
+        //! worker deques in round-robin order. Once the task has finished, even
+        //! by throwing, it is removed from the pending tasks of \p group, which
+        //! stores the exception to rethrow it from TaskGroup::Wait.
+        //!
+        //! \param[in] task  The task to run.
+        //! \param[in] group The group the task belongs to.
+        void Submit(Task task, TaskGroup* group);
+
+        //! \brief Runs a single queued task on the calling thread if there is any.
+        //!
+        //! \return True if a task was executed, false otherwise.
+        bool TryRunPendingTask();
+
+    private:
+        friend class TaskGroup;
+
+        struct Job
+        {
+            Task Function;
+            TaskGroup* Group = nullptr;
+        };
+
+        struct WorkQueue
+        {
+            std::mutex Mutex;
+            std::deque<Job> Jobs;
+        };
+
+        std::vector<std::unique_ptr<WorkQueue>> _Queues;
+        std::vector<std::thread> _Workers;
+
+        std::mutex _WakeMutex;
+        std::condition_variable _WakeCondition;
+        std::condition_variable _WaitCondition;
+        std::atomic<size_t> _NumQueuedJobs{0};
+        std::atomic<size_t> _NumUnfinishedJobs{0};
+        std::atomic<size_t> _NumSleepingWaiters{0};
+        std::atomic<size_t> _NextQueue{0};
+        bool _Stop = false;
+        bool _IsPinningWorkers = false;
+
+        ThreadPool();
+
+        void Start(unsigned int numThreads);
+
+        void Stop();
+
+        void WorkerLoop(size_t workerIndex);
+
+        bool PopJob(size_t queueIndex, Job* job);
+
+        bool StealJob(size_t thiefIndex, Job* job);
+
+        void RunJob(Job& job);
+
+        bool IsIdle() const;
+
+        void WaitUntilFinished(const std::atomic<size_t>& pending);
+
+        void NotifyGroupFinished();
+    };
+
+    //! \brief Group of tasks running on the ThreadPool which can be waited on.
+    //!
+    //! The thread calling TaskGroup::Wait does not block idle. It keeps executing
+    //! queued tasks until every task of the group has finished, so nested groups
+    //! (e.g. a ParallelFor inside a ParallelFor) cannot dead-lock the pool. When
+    //! there is nothing left to run, it spins for a short while and then sleeps
+    //! until a task is queued or the last task of the group finishes.
+    //!
+    //! If tasks throw, the first exception is rethrown by TaskGroup::Wait once
+    //! every task has finished. The destructor waits as well but drops the
+    //! exception.
+    class TaskGroup final
+    {
+    public:
+        //! Constructs an empty task group.
+        TaskGroup();
+
+        //! Waits for the unfinished tasks, without rethrowing their exception.
+        ~TaskGroup();
+
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+
+        //! Submits \p task to the pool as a part of this group.
+        void Run(ThreadPool::Task task);
+
+        //! \brief Waits until every task of this group has finished.
+        //!
+        //! Rethrows the first exception thrown by a task of the group.
+        void Wait();
+
+    private:
+        friend class ThreadPool;
+
+        ThreadPool& _Pool;
+        std::atomic<size_t> _Pending{0};
+        std::mutex _ExceptionMutex;
+        std::exception_ptr _Exception;
+
+        void WaitForTasks();
+
+        void OnTaskFinished(std::exception_ptr exception);
+    };
+}